@@ -0,0 +1,58 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Arena.cpp						---*
+ *---									---*
+ *---	    This file defines the methods of class Arena.		---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"header.h"
+#include	"Arena.h"
+
+
+//  PURPOSE:  To obtain a new slab able to hold at least 'numBytes' bytes
+//	aligned to 'alignment', and to make it the current one.  No return
+//	value.
+void		Arena::newSlab	(size_t		numBytes,
+				 size_t		alignment
+				)
+{
+  size_t	slabLen	= sizeof(char*) + alignment + numBytes;
+
+  if  (slabLen < ARENA_SLAB_LEN)
+    slabLen	= ARENA_SLAB_LEN;
+
+  char*		slabPtr	= (char*)malloc(slabLen);
+
+  if  (slabPtr == NULL)
+  {
+    fprintf(stderr,"Out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+
+  *(char**)slabPtr	= slabListPtr_;
+  slabListPtr_		= slabPtr;
+  freePtr_		= slabPtr + sizeof(char*);
+  endPtr_		= slabPtr + slabLen;
+}
+
+
+//  PURPOSE:  To give all slabs back to the OS at once.  No parameters.  No
+//	return value.
+void		Arena::release	()
+{
+  while  (slabListPtr_ != NULL)
+  {
+    char*	nextPtr	= *(char**)slabListPtr_;
+
+    free(slabListPtr_);
+    slabListPtr_	= nextPtr;
+  }
+
+  freePtr_	= NULL;
+  endPtr_	= NULL;
+}
@@ -0,0 +1,105 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Arena.h							---*
+ *---									---*
+ *---	    This file declares the Arena class, a slab allocator from	---*
+ *---	which the counting structures get their nodes and words.	---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To tell the default number of bytes in one slab.
+const size_t	ARENA_SLAB_LEN		= 64 * 1024;
+
+
+class	Arena
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To hold the address of the most recently obtained slab, or
+  //	'NULL' if none has been obtained yet.  The first 'sizeof(char*)'
+  //	bytes of each slab point to the previously obtained one.
+  char*		slabListPtr_;
+
+  //  PURPOSE:  To point to the first free byte of the current slab.
+  char*		freePtr_;
+
+  //  PURPOSE:  To point just past the last byte of the current slab.
+  char*		endPtr_;
+
+
+  //  II.  Disallowed auto-generated methods:
+  Arena				(const Arena&
+				);
+
+  Arena&	operator=	(const Arena&
+				);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To obtain a new slab able to hold at least 'numBytes' bytes
+  //	aligned to 'alignment', and to make it the current one.  No return
+  //	value.
+  void		newSlab		(size_t		numBytes,
+				 size_t		alignment
+				);
+
+public :
+  //  IV.  Constructor(s), op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to hold no slabs.  No parameters.
+  Arena				() :
+				slabListPtr_(NULL),
+				freePtr_(NULL),
+				endPtr_(NULL)
+				{ }
+
+  //  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+  //	return value.
+  ~Arena			()
+				{
+				  release();
+				}
+
+  //  V.  Accessors:
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To return the address of 'numBytes' bytes of memory aligned to
+  //	'alignment' (a power of 2).  The memory lives until 'release()'.
+  void*		allocate	(size_t		numBytes,
+				 size_t		alignment	= sizeof(void*)
+				)
+				{
+				  size_t  misalign = (size_t)freePtr_ & (alignment-1);
+				  char*	  ptr	   = freePtr_ + (misalign ? alignment-misalign : 0);
+
+				  if  ( (freePtr_ == NULL)  ||  (ptr + numBytes > endPtr_) )
+				  {
+				    newSlab(numBytes,alignment);
+				    misalign = (size_t)freePtr_ & (alignment-1);
+				    ptr	     = freePtr_ + (misalign ? alignment-misalign : 0);
+				  }
+
+				  freePtr_	= ptr + numBytes;
+				  return(ptr);
+				}
+
+  //  PURPOSE:  To return the address of a '\0'-terminated copy of the
+  //	'wordLen' chars starting at 'wordCPtr'.
+  const char*	intern		(const char*	wordCPtr,
+				 size_t		wordLen
+				)
+				{
+				  char*	copyCPtr = (char*)allocate(wordLen+1,1);
+
+				  memcpy(copyCPtr,wordCPtr,wordLen);
+				  copyCPtr[wordLen]	= '\0';
+				  return(copyCPtr);
+				}
+
+  //  PURPOSE:  To give all slabs back to the OS at once.  No parameters.  No
+  //	return value.
+  void		release		();
+
+};
@@ -0,0 +1,210 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Corpus.cpp						---*
+ *---									---*
+ *---	    This file defines the methods of class Corpus.		---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"header.h"
+#include	<vector>
+#include	"Arena.h"
+#include	"Histogram.h"
+#include	"WordTable.h"
+#include	"Tokenizer.h"
+#include	"Corpus.h"
+
+
+//  PURPOSE:  To hold the histogram of one block of the corpus, with its
+//	words copied into one pool so the table that counted them can go.
+struct		CorpusBlock
+{
+  std::vector<WordCount>	entryVector;
+  std::vector<char>		wordPool;
+};
+
+
+//  PURPOSE:  To release the resources of '*this'.  Only called by
+//	'release()'.  No parameters.  No return value.
+Corpus::~Corpus			()
+{
+  freeBlocks();
+}
+
+
+//  PURPOSE:  To free the block histograms of '*this'.  No parameters.  No
+//	return value.
+void		Corpus::freeBlocks
+				()
+{
+  if  (blockPtrArray_ == NULL)
+    return;
+
+  for  (uint64_t i = 0;  i < getNumBlocks();  i++)
+    delete(blockPtrArray_[i].load());
+
+  delete[](blockPtrArray_);
+  blockPtrArray_	= NULL;
+}
+
+
+//  PURPOSE:  To return the histogram of block 'blockIndex', sorted by word,
+//	making it on first use.  The entries point to words '*this' owns,
+//	and are truncated to 'BUFFER_LEN-1' chars.
+const std::vector<WordCount>&
+		Corpus::getBlock(uint64_t	blockIndex
+				)
+				const
+{
+  CorpusBlock*	blockPtr	= blockPtrArray_[blockIndex].load(std::memory_order_acquire);
+
+  if  (blockPtr != NULL)
+    return(blockPtr->entryVector);
+
+  //  Count the block:
+  WordTable	table;
+  uint64_t	index		= blockIndex * CORPUS_BLOCK_WORDS;
+  uint64_t	endIndex	= index + CORPUS_BLOCK_WORDS;
+  const char*	wordCPtr;
+  int		wordLen;
+
+  if  (endIndex > getNumWords())
+    endIndex	= getNumWords();
+
+  for  ( ;  index < endIndex;  index++)
+  {
+    getWord(index,&wordCPtr,&wordLen);
+    table.insert(wordCPtr,(wordLen < BUFFER_LEN) ? wordLen : BUFFER_LEN-1);
+  }
+
+  //  Copy its words into the pool:
+  size_t	poolLen		= 0;
+
+  blockPtr	= new CorpusBlock;
+  table.getSorted(blockPtr->entryVector);
+
+  for  (size_t i = 0;  i < blockPtr->entryVector.size();  i++)
+    poolLen	+= blockPtr->entryVector[i].wordLen + 1;
+
+  blockPtr->wordPool.resize(poolLen);
+
+  char*		poolCPtr	= blockPtr->wordPool.data();
+
+  for  (size_t i = 0;  i < blockPtr->entryVector.size();  i++)
+  {
+    WordCount&	entry	= blockPtr->entryVector[i];
+
+    memcpy(poolCPtr,entry.wordCPtr,entry.wordLen);
+    poolCPtr[entry.wordLen]	= '\0';
+    entry.wordCPtr		= poolCPtr;
+    poolCPtr			+= entry.wordLen + 1;
+  }
+
+  //  Keep it, unless another thread kept its own first:
+  CorpusBlock*	keptPtr		= NULL;
+
+  if  (!blockPtrArray_[blockIndex].compare_exchange_strong(keptPtr,blockPtr,
+							   std::memory_order_acq_rel,
+							   std::memory_order_acquire
+							  )
+      )
+  {
+    delete(blockPtr);
+    blockPtr	= keptPtr;
+  }
+
+  return(blockPtr->entryVector);
+}
+
+
+//  PURPOSE:  To hold what the threads of one 'Corpus::load()' share: the
+//	Tokenizer that mapped the files, and the packed words of each file.
+struct		CorpusLoad
+{
+  const Tokenizer*			tokenizerPtr;
+  std::vector< std::vector<uint64_t> >	fileWordVector;
+};
+
+
+//  PURPOSE:  To note, for the 'CorpusLoad' that 'vPtr' points to, where each
+//	word of file 'fileIndex' starts, packed as 'Corpus::wordVector_' holds
+//	them.  Called by 'Tokenizer::forEachFile()'.  No return value.
+static
+void		tokenizeFile	(void*		vPtr,
+				 int		fileIndex
+				)
+{
+  CorpusLoad*		loadPtr		= (CorpusLoad*)vPtr;
+  const Tokenizer&	tokenizer	= *loadPtr->tokenizerPtr;
+  std::vector<uint64_t>&	wordVector	= loadPtr->fileWordVector[fileIndex];
+  size_t		position	= tokenizer.getFileStart(fileIndex);
+  size_t		fileEnd		= position + tokenizer.getFileLen(fileIndex);
+  const char*		wordCPtr;
+  int			wordLen;
+
+  wordVector.reserve(tokenizer.getFileLen(fileIndex) / 6);
+
+  while  (tokenizer.scanWordIn(&position,fileEnd,&wordCPtr,&wordLen))
+  {
+    uint64_t	offset	= wordCPtr - tokenizer.getText();
+
+    if  ((uint64_t)wordLen > CORPUS_MAX_WORD_LEN)
+      wordLen	= CORPUS_MAX_WORD_LEN;
+
+    wordVector.push_back((offset << CORPUS_LEN_BITS) | wordLen);
+  }
+}
+
+
+//  PURPOSE:  To map the files 'pathCPtr' names, as 'listCorpusFiles()'
+//	lists them, and note where each of their words starts, tokenizing
+//	the files in parallel.  Returns 'true' on success or 'false'
+//	otherwise.
+bool		Corpus::load	(const char*		pathCPtr
+				)
+{
+  std::vector<std::string>	filenameVector;
+
+  //  The files are stamped before they are mapped, so one that changes in
+  //  between makes the next check see '*this' as stale:
+  if  (!listCorpusFiles(pathCPtr,filenameVector))
+    return(false);
+
+  stamp_	= stampCorpusFiles(filenameVector);
+
+  if  (!tokenizer_.open(filenameVector))
+    return(false);
+
+  //  Tokenize each file on its own thread, then lay their words end to end
+  //  in the order of the files:
+  CorpusLoad	loading;
+  size_t	numWords	= 0;
+
+  loading.tokenizerPtr	= &tokenizer_;
+  loading.fileWordVector.resize(tokenizer_.getNumFiles());
+  tokenizer_.forEachFile(tokenizeFile,&loading);
+
+  for  (size_t i = 0;  i < loading.fileWordVector.size();  i++)
+    numWords	+= loading.fileWordVector[i].size();
+
+  freeBlocks();
+  wordVector_.clear();
+  wordVector_.reserve(numWords);
+
+  for  (size_t i = 0;  i < loading.fileWordVector.size();  i++)
+  {
+    wordVector_.insert(wordVector_.end(),
+		       loading.fileWordVector[i].begin(),
+		       loading.fileWordVector[i].end()
+		      );
+    std::vector<uint64_t>().swap(loading.fileWordVector[i]);
+  }
+
+  //  No block histogram is made until it is needed:
+  blockPtrArray_	= new std::atomic<CorpusBlock*>[getNumBlocks()]();
+  return(true);
+}
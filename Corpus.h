@@ -0,0 +1,165 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Corpus.h						---*
+ *---									---*
+ *---	    This file declares the Corpus class, a read-only snapshot	---*
+ *---	of a memory-mapped file and the position of each of its words,	---*
+ *---	shared by every thread that histograms it.  The file may also	---*
+ *---	be a directory or a list of files, whose words are numbered	---*
+ *---	one file after the other.					---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	<stdint.h>
+#include	<atomic>
+
+
+//  PURPOSE:  To tell the number of low bits of a packed word that hold its
+//	length.  The other bits hold its offset in the file.
+const int	CORPUS_LEN_BITS		= 16;
+
+//  PURPOSE:  To tell the longest word length a packed word holds.  Longer
+//	words keep only this length, which is still more than any histogram
+//	counts.
+const uint64_t	CORPUS_MAX_WORD_LEN	= (1 << CORPUS_LEN_BITS) - 1;
+
+//  PURPOSE:  To tell the number of words in each block of the corpus whose
+//	histogram is kept once it has been made.  Block 'i' holds words
+//	'i*CORPUS_BLOCK_WORDS' up to (but not including) the next block, or
+//	the end of the corpus.
+const uint64_t	CORPUS_BLOCK_WORDS	= 8192;
+
+
+//  PURPOSE:  To hold the histogram of one block of the corpus.
+struct		CorpusBlock;
+
+
+class	Corpus
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To map the file.
+  Tokenizer		tokenizer_;
+
+  //  PURPOSE:  To hold, for word 'i' of the file, its offset shifted left by
+  //	'CORPUS_LEN_BITS' bits, or-ed with its length.
+  std::vector<uint64_t>	wordVector_;
+
+  //  PURPOSE:  To tell the 'stampCorpusFiles()' of the files when they were
+  //	mapped.
+  uint64_t		stamp_;
+
+  //  PURPOSE:  To point to one pointer per block, to its histogram or to
+  //	'NULL' until it has been made.  Threads that need the same block
+  //	at once may both make it, but only the first one made is kept.
+  std::atomic<CorpusBlock*>*
+			blockPtrArray_;
+
+  //  PURPOSE:  To count the holders of '*this'.  '*this' deletes itself when
+  //	the last one releases it.
+  std::atomic<int>	refCount_;
+
+
+  //  II.  Disallowed auto-generated methods:
+  Corpus			(const Corpus&
+				);
+
+  Corpus&	operator=	(const Corpus&
+				);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To release the resources of '*this'.  Only called by
+  //	'release()'.  No parameters.  No return value.
+  ~Corpus			();
+
+  //  PURPOSE:  To free the block histograms of '*this'.  No parameters.  No
+  //	return value.
+  void		freeBlocks	();
+
+public :
+  //  IV.  Constructor(s), op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to an empty corpus with one holder, the
+  //	caller.  No parameters.
+  Corpus			() :
+				stamp_(0),
+				blockPtrArray_(NULL),
+				refCount_(1)
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of words in the file.  No parameters.
+  uint64_t	getNumWords	()
+				const
+				{
+				  return(wordVector_.size());
+				}
+
+  //  PURPOSE:  To set '*wordCPtrPtr' to the address of word number
+  //	'wordIndex' of the file and '*wordLenPtr' to its length.  The word is
+  //	not '\0'-terminated.  No return value.
+  void		getWord		(uint64_t	wordIndex,
+				 const char**	wordCPtrPtr,
+				 int*		wordLenPtr
+				)
+				const
+				{
+				  uint64_t	packed	= wordVector_[wordIndex];
+
+				  *wordCPtrPtr	= tokenizer_.getText() + (packed >> CORPUS_LEN_BITS);
+				  *wordLenPtr	= (int)(packed & CORPUS_MAX_WORD_LEN);
+				}
+
+  //  PURPOSE:  To return the number of blocks of words, the last of which
+  //	may be short.  No parameters.
+  uint64_t	getNumBlocks	()
+				const
+				{
+				  return( (wordVector_.size() + CORPUS_BLOCK_WORDS - 1) / CORPUS_BLOCK_WORDS );
+				}
+
+  //  PURPOSE:  To return the histogram of block 'blockIndex', sorted by word,
+  //	making it on first use.  The entries point to words '*this' owns,
+  //	and are truncated to 'BUFFER_LEN-1' chars.
+  const std::vector<WordCount>&
+		getBlock	(uint64_t	blockIndex
+				)
+				const;
+
+  //  PURPOSE:  To return 'true' if 'stamp' is the 'getCorpusStamp()' of
+  //	different files, or of different versions of the files, than '*this'
+  //	was loaded from, or 'false' otherwise.
+  bool		isStale		(uint64_t		stamp
+				)
+				const
+				{
+				  return(stamp != stamp_);
+				}
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To map the files 'pathCPtr' names, as 'listCorpusFiles()'
+  //	lists them, and note where each of their words starts, tokenizing
+  //	the files in parallel.  Returns 'true' on success or 'false'
+  //	otherwise.
+  bool		load		(const char*		pathCPtr
+				);
+
+  //  PURPOSE:  To note one more holder of '*this'.  No parameters.  No
+  //	return value.
+  void		acquire		()
+				{
+				  refCount_.fetch_add(1,std::memory_order_relaxed);
+				}
+
+  //  PURPOSE:  To note one less holder of '*this', and to delete '*this' if
+  //	it was the last.  No parameters.  No return value.
+  void		release		()
+				{
+				  if  (refCount_.fetch_sub(1,std::memory_order_acq_rel) == 1)
+				    delete(this);
+				}
+
+};
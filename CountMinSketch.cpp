@@ -0,0 +1,238 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		CountMinSketch.cpp					---*
+ *---									---*
+ *---	    This file defines the methods of class CountMinSketch.	---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"header.h"
+#include	<stdint.h>
+#include	<math.h>
+#include	"Histogram.h"
+#include	"SpaceSaving.h"
+#include	"CountMinSketch.h"
+
+
+//  PURPOSE:  To tell the fewest bytes a 'CountMinSketch' takes.
+const size_t	COUNT_MIN_MIN_BYTES	= 1024;
+
+
+//  PURPOSE:  To return the 64-bit FNV-1a hash of the 'wordLen' chars at
+//	'wordCPtr'.  Its two halves pick the cells of the rows, so it needs
+//	more bits than 'hashWord()' gives.
+static
+inline
+uint64_t	hashWord64	(const char*	wordCPtr,
+				 int		wordLen
+				)
+{
+  uint64_t	hash	= 14695981039346656037ull;
+
+  for  (int i = 0;  i < wordLen;  i++)
+  {
+    hash ^= (unsigned char)wordCPtr[i];
+    hash *= 1099511628211ull;
+  }
+
+  return(hash);
+}
+
+
+//  PURPOSE:  To return the number of heavy hitters a sketch of 'numBytes'
+//	bytes keeps.
+static
+int		getNumHeavyHitters
+				(size_t		numBytes
+				)
+{
+  if  (numBytes < COUNT_MIN_MIN_BYTES)
+    numBytes	= COUNT_MIN_MIN_BYTES;
+
+  return(numBytes / COUNT_MIN_HEAVY_HITTER_SHARE / SpaceSaving::getNumBytes(1));
+}
+
+
+//  PURPOSE:  To return the number of cells in each row of a sketch of
+//	'numBytes' bytes, the greatest power of 2 that fits in what its heavy
+//	hitters leave.
+static
+unsigned int	getNumCells	(size_t		numBytes
+				)
+{
+  if  (numBytes < COUNT_MIN_MIN_BYTES)
+    numBytes	= COUNT_MIN_MIN_BYTES;
+
+  size_t	cellBytes	= numBytes - SpaceSaving::getNumBytes(getNumHeavyHitters(numBytes));
+  unsigned int	width		= 1;
+
+  while  (2 * width * COUNT_MIN_DEPTH * sizeof(unsigned int) <= cellBytes)
+    width	*= 2;
+
+  return(width);
+}
+
+
+//  PURPOSE:  To initialize '*this' to an empty sketch taking about
+//	'numBytes' bytes (at least one kilobyte), which is all the memory it
+//	ever uses.
+CountMinSketch::CountMinSketch	(size_t		numBytes
+				) :
+				cellArray_((unsigned int*)calloc(COUNT_MIN_DEPTH * getNumCells(numBytes),
+								 sizeof(unsigned int)
+								)
+					  ),
+				widthMask_(getNumCells(numBytes) - 1),
+				numWords_(0),
+				heavyHitters_(getNumHeavyHitters(numBytes))
+{
+  if  (cellArray_ == NULL)
+  {
+    fprintf(stderr,"Out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+
+//  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+//	return value.
+CountMinSketch::~CountMinSketch	()
+{
+  free(cellArray_);
+}
+
+
+//  PURPOSE:  To set 'cellIndexArray[]' to the index in 'cellArray_' of the
+//	cell of the 'wordLen' chars at 'wordCPtr' in each row.  No return
+//	value.
+void		CountMinSketch::findCells
+				(const char*	wordCPtr,
+				 int		wordLen,
+				 unsigned int	cellIndexArray[COUNT_MIN_DEPTH]
+				)
+				const
+{
+  uint64_t	hash	= hashWord64(wordCPtr,wordLen);
+  unsigned int	lowHash	= (unsigned int)hash;
+  unsigned int	highHash= (unsigned int)(hash >> 32) | 1;
+
+  //  Row 'row' uses the hash 'lowHash + row*highHash' (Kirsch and
+  //  Mitzenmacher), which is as good as 'COUNT_MIN_DEPTH' hashes:
+  for  (int row = 0;  row < COUNT_MIN_DEPTH;  row++)
+    cellIndexArray[row]	= row * (widthMask_ + 1)  +  ((lowHash + row*highHash) & widthMask_);
+}
+
+
+//  PURPOSE:  To return the least of the cells at the 'COUNT_MIN_DEPTH'
+//	indices of 'cellIndexArray[]'.
+unsigned int	CountMinSketch::getLeast
+				(const unsigned int	cellIndexArray[COUNT_MIN_DEPTH]
+				)
+				const
+{
+  unsigned int	least	= cellArray_[cellIndexArray[0]];
+
+  for  (int row = 1;  row < COUNT_MIN_DEPTH;  row++)
+    if  (least > cellArray_[cellIndexArray[row]])
+      least	= cellArray_[cellIndexArray[row]];
+
+  return(least);
+}
+
+
+//  PURPOSE:  To return the most by which an estimate is too high, unless
+//	with probability 'getFailureOdds()'.  No parameters.
+uint64_t	CountMinSketch::getMaxError
+				()
+				const
+{
+  return((uint64_t)ceil(M_E * numWords_ / getWidth()));
+}
+
+
+//  PURPOSE:  To return the probability that an estimate is too high by more
+//	than 'getMaxError()'.  No parameters.
+double		CountMinSketch::getFailureOdds
+				()
+				const
+{
+  return(exp(-COUNT_MIN_DEPTH));
+}
+
+
+//  PURPOSE:  To return the estimated count of the 'wordLen' chars at
+//	'wordCPtr', which is never too low.
+unsigned int	CountMinSketch::estimate
+				(const char*	wordCPtr,
+				 int		wordLen
+				)
+				const
+{
+  unsigned int	cellIndexArray[COUNT_MIN_DEPTH];
+
+  findCells(wordCPtr,wordLen,cellIndexArray);
+  return(getLeast(cellIndexArray));
+}
+
+
+//  PURPOSE:  To note 'count' more occurrences of the 'wordLen' chars
+//	starting at 'wordCPtr'.  No return value.
+void		CountMinSketch::add
+				(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
+				)
+{
+  unsigned int	cellIndexArray[COUNT_MIN_DEPTH];
+
+  findCells(wordCPtr,wordLen,cellIndexArray);
+
+  //  Only the cells under the new estimate need to rise to it (conservative
+  //  update), which keeps the others closer for the words sharing them:
+  unsigned int	newEstimate	= getLeast(cellIndexArray) + count;
+
+  for  (int row = 0;  row < COUNT_MIN_DEPTH;  row++)
+    if  (cellArray_[cellIndexArray[row]] < newEstimate)
+      cellArray_[cellIndexArray[row]]	= newEstimate;
+
+  numWords_	+= count;
+  heavyHitters_.offer(wordCPtr,wordLen,newEstimate);
+}
+
+
+//  PURPOSE:  To add to '*this' the counts of 'sketch', which must have been
+//	made with the same number of bytes, as if '*this' had seen its words
+//	too.  No return value.
+void		CountMinSketch::absorb
+				(const CountMinSketch&	sketch
+				)
+{
+  std::vector<WordCount>	entryVector;
+
+  for  (unsigned int i = 0;  i < COUNT_MIN_DEPTH * getWidth();  i++)
+    cellArray_[i]	+= sketch.cellArray_[i];
+
+  numWords_	+= sketch.numWords_;
+
+  //  Raise the heavy hitters of '*this' first, which only raises counts, so
+  //  'entryVector' still points at their words.  Then those of 'sketch' may
+  //  take the places of the least:
+  getSorted(entryVector);
+
+  for  (size_t i = 0;  i < entryVector.size();  i++)
+    heavyHitters_.offer(entryVector[i].wordCPtr,entryVector[i].wordLen,
+			estimate(entryVector[i].wordCPtr,entryVector[i].wordLen)
+		       );
+
+  entryVector.clear();
+  sketch.getSorted(entryVector);
+
+  for  (size_t i = 0;  i < entryVector.size();  i++)
+    heavyHitters_.offer(entryVector[i].wordCPtr,entryVector[i].wordLen,
+			estimate(entryVector[i].wordCPtr,entryVector[i].wordLen)
+		       );
+}
@@ -0,0 +1,160 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		CountMinSketch.h					---*
+ *---									---*
+ *---	    This file declares the CountMinSketch class, which counts	---*
+ *---	words approximately in a fixed number of bytes however many	---*
+ *---	distinct words there are (Cormode and Muthukrishnan's Count-Min	---*
+ *---	sketch).  A word adds to one cell in each of 'depth' rows of	---*
+ *---	'width' cells, and its estimate is the least of them, so it is	---*
+ *---	never too low.  It is too high by more than 'e/width' of the	---*
+ *---	words seen with probability at most 'exp(-depth)'.  Since a	---*
+ *---	sketch cannot list its words, the words with the highest	---*
+ *---	estimates so far are kept, with them, in a small SpaceSaving	---*
+ *---	table of heavy hitters.						---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To tell the number of rows of a 'CountMinSketch'.
+const int	COUNT_MIN_DEPTH			= 4;
+
+//  PURPOSE:  To tell what share of the bytes of a 'CountMinSketch' go to
+//	its table of heavy hitters (the rest go to its cells).
+const int	COUNT_MIN_HEAVY_HITTER_SHARE	= 4;
+
+
+class	CountMinSketch : public Histogram
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To hold 'COUNT_MIN_DEPTH' rows of 'widthMask_+1' cells each.
+  unsigned int*	cellArray_;
+
+  //  PURPOSE:  To tell the number of cells of a row less one, their number
+  //	being a power of 2.
+  unsigned int	widthMask_;
+
+  //  PURPOSE:  To tell the number of words seen.
+  uint64_t	numWords_;
+
+  //  PURPOSE:  To hold the words with the highest estimates, and those
+  //	estimates.
+  SpaceSaving	heavyHitters_;
+
+
+  //  II.  Disallowed auto-generated methods:
+  CountMinSketch		();
+
+  CountMinSketch		(const CountMinSketch&
+				);
+
+  CountMinSketch&
+		operator=	(const CountMinSketch&
+				);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To set 'cellIndexArray[]' to the index in 'cellArray_' of the
+  //	cell of the 'wordLen' chars at 'wordCPtr' in each row.  No return
+  //	value.
+  void		findCells	(const char*	wordCPtr,
+				 int		wordLen,
+				 unsigned int	cellIndexArray[COUNT_MIN_DEPTH]
+				)
+				const;
+
+  //  PURPOSE:  To return the least of the cells at the 'COUNT_MIN_DEPTH'
+  //	indices of 'cellIndexArray[]'.
+  unsigned int	getLeast	(const unsigned int	cellIndexArray[COUNT_MIN_DEPTH]
+				)
+				const;
+
+public :
+  //  IV.  Constructor(s), op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to an empty sketch taking about
+  //	'numBytes' bytes (at least one kilobyte), which is all the memory it
+  //	ever uses.
+  CountMinSketch		(size_t		numBytes
+				);
+
+  //  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+  //	return value.
+  ~CountMinSketch		();
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of words in the table of heavy hitters.
+  //	No parameters.
+  int		getNumDistinct	()
+				const
+				{
+				  return(heavyHitters_.getNumDistinct());
+				}
+
+  //  PURPOSE:  To return the number of cells in each row.  No parameters.
+  unsigned int	getWidth	()
+				const
+				{
+				  return(widthMask_ + 1);
+				}
+
+  //  PURPOSE:  To return the number of words seen.  No parameters.
+  uint64_t	getNumWords	()
+				const
+				{
+				  return(numWords_);
+				}
+
+  //  PURPOSE:  To return the most by which an estimate is too high, unless
+  //	with probability 'getFailureOdds()'.  No parameters.
+  uint64_t	getMaxError	()
+				const;
+
+  //  PURPOSE:  To return the probability that an estimate is too high by
+  //	more than 'getMaxError()'.  No parameters.
+  double	getFailureOdds	()
+				const;
+
+  //  PURPOSE:  To return the estimated count of the 'wordLen' chars at
+  //	'wordCPtr', which is never too low.
+  unsigned int	estimate	(const char*	wordCPtr,
+				 int		wordLen
+				)
+				const;
+
+  //  PURPOSE:  To append to 'entryVector' one entry per heavy hitter, with
+  //	its estimated count, sorted the way 'strcmp()' orders the words.  No
+  //	return value.
+  void		getSorted	(std::vector<WordCount>&	entryVector
+				)
+				const
+				{
+				  heavyHitters_.getSorted(entryVector);
+				}
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To note one more occurrence of the 'wordLen' chars starting at
+  //	'wordCPtr'.  No return value.
+  void		insert		(const char*	wordCPtr,
+				 int		wordLen
+				)
+				{
+				  add(wordCPtr,wordLen,1);
+				}
+
+  //  PURPOSE:  To note 'count' more occurrences of the 'wordLen' chars
+  //	starting at 'wordCPtr'.  No return value.
+  void		add		(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
+				);
+
+  //  PURPOSE:  To add to '*this' the counts of 'sketch', which must have
+  //	been made with the same number of bytes, as if '*this' had seen its
+  //	words too.  No return value.
+  void		absorb		(const CountMinSketch&	sketch
+				);
+
+};
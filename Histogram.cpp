@@ -0,0 +1,384 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Histogram.cpp						---*
+ *---									---*
+ *---	    This file defines the functions related to the Histogram	---*
+ *---	interface.							---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"header.h"
+#include	<queue>
+#include	"Arena.h"
+#include	"Histogram.h"
+#include	"Node.h"
+#include	"WordTable.h"
+#include	"protocol.h"
+
+
+//  PURPOSE:  To compare the 'lhsLen' chars at 'lhsCPtr' with the 'rhsLen'
+//	chars at 'rhsCPtr' the way 'strcmp()' would.  Returns a negative
+//	number, '0' or a positive number.
+int		compareWords	(const char*	lhsCPtr,
+				 int		lhsLen,
+				 const char*	rhsCPtr,
+				 int		rhsLen
+				)
+{
+  int	compRes	= memcmp(lhsCPtr,rhsCPtr,(lhsLen < rhsLen) ? lhsLen : rhsLen);
+
+  if  (compRes == 0)
+    compRes	= lhsLen - rhsLen;
+
+  return(compRes);
+}
+
+
+//  PURPOSE:  To return 'true' if 'lhs' sorts before 'rhs' by word, or 'false'
+//	otherwise.
+bool		isWordBefore	(const WordCount&	lhs,
+				 const WordCount&	rhs
+				)
+{
+  return(compareWords(lhs.wordCPtr,lhs.wordLen,rhs.wordCPtr,rhs.wordLen) < 0);
+}
+
+
+//  PURPOSE:  To return 'true' if 'lhs' ranks before 'rhs' among the most
+//	frequent words: if it has the higher count, or the same count and
+//	sorts before it by word.  Returns 'false' otherwise.
+bool		isMoreFrequent	(const WordCount&	lhs,
+				 const WordCount&	rhs
+				)
+{
+  if  (lhs.count != rhs.count)
+    return(lhs.count > rhs.count);
+
+  return(isWordBefore(lhs,rhs));
+}
+
+
+//  PURPOSE:  To return a new, empty 'Histogram' of the engine named
+//	'engineCPtr' ("tree" or "hash"), or 'NULL' if there is no such engine.
+Histogram*	newHistogram	(const char*	engineCPtr
+				)
+{
+  if  (strcmp(engineCPtr,"tree") == 0)
+    return(new WordTree);
+
+  if  (strcmp(engineCPtr,"hash") == 0)
+    return(new WordTable);
+
+  return(NULL);
+}
+
+
+//  PURPOSE:  To count word 'wordCPtr' in 'histogram', truncating it to
+//	'BUFFER_LEN-1' chars.  No return value.
+void		insert		(Histogram&	histogram,
+				 const char*	wordCPtr
+				)
+{
+  histogram.insert(wordCPtr,strnlen(wordCPtr,BUFFER_LEN-1));
+}
+
+
+//  PURPOSE:  To tell where the k-way merge of 'mergeSorted()' is in one of
+//	its runs.
+struct		RunCursor
+{
+  const WordCount*	entryPtr;
+  const WordCount*	endPtr;
+
+  //  PURPOSE:  To return 'true' if '*this' should come out of the heap after
+  //	'rhs', or 'false' otherwise.
+  bool		operator<	(const RunCursor&	rhs
+				)
+				const
+				{
+				  return(isWordBefore(*rhs.entryPtr,*entryPtr));
+				}
+};
+
+
+//  PURPOSE:  To merge the sorted runs of 'runVector' into one sorted run
+//	appended to 'entryVector', adding the counts of a word that is in
+//	more than one run.  The merged entries point to the same words as
+//	the runs do.  No return value.
+void		mergeSorted	(const std::vector< std::vector<WordCount> >&	runVector,
+				 std::vector<WordCount>&			entryVector
+				)
+{
+  std::priority_queue<RunCursor>	heap;
+  size_t				first	= entryVector.size();
+
+  for  (size_t i = 0;  i < runVector.size();  i++)
+  {
+    if  (runVector[i].empty())
+      continue;
+
+    RunCursor	cursor;
+
+    cursor.entryPtr	= &runVector[i][0];
+    cursor.endPtr	= cursor.entryPtr + runVector[i].size();
+    heap.push(cursor);
+  }
+
+  while  (!heap.empty())
+  {
+    RunCursor		cursor	= heap.top();
+    const WordCount&	entry	= *cursor.entryPtr;
+
+    heap.pop();
+
+    if  ( (entryVector.size() > first)					&&
+	  (compareWords(entryVector.back().wordCPtr,entryVector.back().wordLen,
+			entry.wordCPtr,entry.wordLen
+		       ) == 0
+	  )
+	)
+      entryVector.back().count	+= entry.count;
+    else
+      entryVector.push_back(entry);
+
+    if  (++cursor.entryPtr < cursor.endPtr)
+      heap.push(cursor);
+  }
+}
+
+
+//  PURPOSE:  To add to 'histogram' the counts of the entries of
+//	'entryVector', such as those another histogram has, each 'times'
+//	times over.  No return value.
+void		merge		(Histogram&			histogram,
+				 const std::vector<WordCount>&	entryVector,
+				 int				times
+				)
+{
+  for  (size_t i = 0;  i < entryVector.size();  i++)
+    histogram.add(entryVector[i].wordCPtr,entryVector[i].wordLen,
+		  times * entryVector[i].count
+		 );
+}
+
+
+//  PURPOSE:  To append to 'topVector' the 'k' entries of 'entryVector' with
+//	the highest counts (or all of them if there are fewer), most frequent
+//	first and those with the same count by word.  Keeps only 'k' entries
+//	in a heap while going through 'entryVector', in any order, once.  No
+//	return value.
+void		selectTop	(const std::vector<WordCount>&	entryVector,
+				 int				k,
+				 std::vector<WordCount>&	topVector
+				)
+{
+  //  The least frequent entry kept is on top, to be replaced first:
+  std::priority_queue< WordCount,std::vector<WordCount>,
+		       bool (*)(const WordCount&,const WordCount&)
+		     >					heap(isMoreFrequent);
+
+  for  (size_t i = 0;  i < entryVector.size();  i++)
+  {
+    if  ((int)heap.size() < k)
+      heap.push(entryVector[i]);
+    else
+    if  ( (k > 0)  &&  isMoreFrequent(entryVector[i],heap.top()) )
+    {
+      heap.pop();
+      heap.push(entryVector[i]);
+    }
+  }
+
+  size_t	first	= topVector.size();
+
+  topVector.resize(first + heap.size());
+
+  for  (size_t i = topVector.size();  i > first;  i--)
+  {
+    topVector[i-1]	= heap.top();
+    heap.pop();
+  }
+}
+
+
+//  PURPOSE:  To print out 'histogram' in sorted order, one "count\tword"
+//	line per distinct word.  No return value.
+void		print		(const Histogram&	histogram
+				)
+{
+  std::vector<WordCount>	entryVector;
+
+  histogram.getSorted(entryVector);
+  print(entryVector);
+}
+
+
+//  PURPOSE:  To print out the sorted entries of 'entryVector' to standard
+//	output, serialized in binary if 'isBinary' or else as text, in one
+//	buffer written out in chunks.  No return value.
+void		print		(const std::vector<WordCount>&	entryVector,
+				 bool				isBinary
+				)
+{
+  size_t	len		= getSerializedLen(entryVector,isBinary);
+  char*		bufferPtr	= (char*)malloc(len);
+
+  if  ( (bufferPtr == NULL)  &&  (len > 0) )
+  {
+    fprintf(stderr,"Out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+
+  //  What was 'printf()'ed before goes first:
+  fflush(stdout);
+  writeAll(STDOUT_FILENO,bufferPtr,serialize(entryVector,isBinary,bufferPtr));
+  free(bufferPtr);
+}
+
+
+//  PURPOSE:  To return the number of decimal digits of 'value'.
+static
+inline
+int		getNumDigits	(unsigned int	value
+				)
+{
+  int	numDigits	= 1;
+
+  while  (value >= 10)
+  {
+    value	/= 10;
+    numDigits++;
+  }
+
+  return(numDigits);
+}
+
+
+//  PURPOSE:  To write 'value' in decimal at 'bufferPtr', as 'printf("%d")'
+//	would.  Returns the address just after it.
+static
+inline
+char*		formatInt	(char*		bufferPtr,
+				 int		value
+				)
+{
+  unsigned int	magnitude	= value;
+
+  if  (value < 0)
+  {
+    *bufferPtr++	= '-';
+    magnitude		= -magnitude;
+  }
+
+  char*	endPtr	= bufferPtr + getNumDigits(magnitude);
+
+  //  Fill in the digits from the last one:
+  bufferPtr	= endPtr;
+
+  do
+  {
+    *--bufferPtr	= '0' + magnitude % 10;
+    magnitude		/= 10;
+  }
+  while  (magnitude > 0);
+
+  return(endPtr);
+}
+
+
+//  PURPOSE:  To return the number of bytes 'serialize()' writes for the
+//	entries of 'entryVector', in binary if 'isBinary' or else as text.
+size_t		getSerializedLen(const std::vector<WordCount>&	entryVector,
+				 bool				isBinary
+				)
+{
+  size_t	len	= 0;
+
+  for  (size_t i = 0;  i < entryVector.size();  i++)
+  {
+    const WordCount&	entry	= entryVector[i];
+
+    if  (isBinary)
+      len	+= sizeof(uint32_t) + sizeof(uint16_t) + entry.wordLen;
+    else
+      len	+= (entry.count < 0)
+		   + getNumDigits( (entry.count < 0) ? -(unsigned int)entry.count : entry.count )
+		   + 1 + entry.wordLen + 1;
+  }
+
+  return(len);
+}
+
+
+//  PURPOSE:  To write the entries of 'entryVector' at 'bufferPtr', which has
+//	room for 'getSerializedLen()' bytes.  As text, each is a
+//	"count\tword\n" line, as 'printf("%d\t%s\n")' would write it.  In
+//	binary, each is a 'u32' count and a 'u16' word length in network byte
+//	order and then the word, as in a version 2 reply.  Returns the number
+//	of bytes written.
+size_t		serialize	(const std::vector<WordCount>&	entryVector,
+				 bool				isBinary,
+				 char*				bufferPtr
+				)
+{
+  char*	endPtr	= bufferPtr;
+
+  for  (size_t i = 0;  i < entryVector.size();  i++)
+  {
+    const WordCount&	entry	= entryVector[i];
+
+    if  (isBinary)
+    {
+      putU32(endPtr,entry.count);
+      putU16(endPtr+sizeof(uint32_t),entry.wordLen);
+      endPtr	+= sizeof(uint32_t) + sizeof(uint16_t);
+    }
+    else
+    {
+      endPtr	= formatInt(endPtr,entry.count);
+      *endPtr++	= '\t';
+    }
+
+    memcpy(endPtr,entry.wordCPtr,entry.wordLen);
+    endPtr	+= entry.wordLen;
+
+    if  (!isBinary)
+      *endPtr++	= '\n';
+  }
+
+  return(endPtr - bufferPtr);
+}
+
+
+//  PURPOSE:  To write the 'len' bytes at 'bufferPtr' to file descriptor
+//	'fd', at most 'SERIAL_CHUNK_LEN' at a time.  Returns 'true' if they
+//	all were written, or 'false' otherwise.
+bool		writeAll	(int		fd,
+				 const char*	bufferPtr,
+				 size_t		len
+				)
+{
+  while  (len > 0)
+  {
+    ssize_t	numWritten	= write(fd,bufferPtr,
+					(len < SERIAL_CHUNK_LEN) ? len : SERIAL_CHUNK_LEN
+				       );
+
+    if  (numWritten < 0)
+    {
+      if  (errno == EINTR)
+	continue;
+
+      return(false);
+    }
+
+    bufferPtr	+= numWritten;
+    len		-= numWritten;
+  }
+
+  return(true);
+}
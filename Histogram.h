@@ -0,0 +1,232 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Histogram.h						---*
+ *---									---*
+ *---	    This file declares the Histogram interface implemented by	---*
+ *---	the word-counting engines, and related functions.		---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	<vector>
+
+
+//  PURPOSE:  To tell the most bytes 'writeAll()' hands 'write()' at once.
+const size_t	SERIAL_CHUNK_LEN	= 65536;
+
+
+//  PURPOSE:  To tell one distinct word and how many times it was seen.
+//	'wordCPtr' is '\0'-terminated and owned by the 'Histogram' it came
+//	from.
+struct		WordCount
+{
+  const char*	wordCPtr;
+  int		wordLen;
+  int		count;
+};
+
+
+class	Histogram
+{
+  //  I.  Member vars:
+
+  //  II.  Disallowed auto-generated methods:
+  Histogram			(const Histogram&
+				);
+
+  Histogram&	operator=	(const Histogram&
+				);
+
+protected :
+  //  III.  Protected methods:
+
+public :
+  //  IV.  Constructor(s), op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this'.  No parameters.
+  Histogram			()
+				{ }
+
+  //  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+  //	return value.
+  virtual
+  ~Histogram			()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of distinct words.  No parameters.
+  virtual
+  int		getNumDistinct	()
+				const
+				= 0;
+
+  //  PURPOSE:  To append to 'entryVector' one entry per distinct word, sorted
+  //	the way 'strcmp()' orders the words.  No return value.
+  virtual
+  void		getSorted	(std::vector<WordCount>&	entryVector
+				)
+				const
+				= 0;
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To note one more occurrence of the 'wordLen' chars starting at
+  //	'wordCPtr'.  'wordLen' is at most 'BUFFER_LEN-1'.  No return value.
+  virtual
+  void		insert		(const char*	wordCPtr,
+				 int		wordLen
+				)
+				= 0;
+
+  //  PURPOSE:  To note 'count' more occurrences of the 'wordLen' chars
+  //	starting at 'wordCPtr'.  'wordLen' is at most 'BUFFER_LEN-1'.  No
+  //	return value.
+  virtual
+  void		add		(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
+				)
+				= 0;
+
+};
+
+
+//  PURPOSE:  To compare the 'lhsLen' chars at 'lhsCPtr' with the 'rhsLen'
+//	chars at 'rhsCPtr' the way 'strcmp()' would.  Returns a negative
+//	number, '0' or a positive number.
+extern
+int		compareWords	(const char*	lhsCPtr,
+				 int		lhsLen,
+				 const char*	rhsCPtr,
+				 int		rhsLen
+				);
+
+
+//  PURPOSE:  To return the FNV-1a hash of the 'wordLen' chars at 'wordCPtr'.
+inline
+unsigned int	hashWord	(const char*	wordCPtr,
+				 int		wordLen
+				)
+{
+  unsigned int	hash	= 2166136261u;
+
+  for  (int i = 0;  i < wordLen;  i++)
+  {
+    hash ^= (unsigned char)wordCPtr[i];
+    hash *= 16777619u;
+  }
+
+  return(hash);
+}
+
+
+//  PURPOSE:  To return 'true' if 'lhs' sorts before 'rhs' by word, or 'false'
+//	otherwise.
+extern
+bool		isWordBefore	(const WordCount&	lhs,
+				 const WordCount&	rhs
+				);
+
+
+//  PURPOSE:  To return 'true' if 'lhs' ranks before 'rhs' among the most
+//	frequent words: if it has the higher count, or the same count and
+//	sorts before it by word.  Returns 'false' otherwise.
+extern
+bool		isMoreFrequent	(const WordCount&	lhs,
+				 const WordCount&	rhs
+				);
+
+
+//  PURPOSE:  To return a new, empty 'Histogram' of the engine named
+//	'engineCPtr' ("tree" or "hash"), or 'NULL' if there is no such engine.
+extern
+Histogram*	newHistogram	(const char*	engineCPtr
+				);
+
+
+//  PURPOSE:  To count word 'wordCPtr' in 'histogram', truncating it to
+//	'BUFFER_LEN-1' chars.  No return value.
+extern
+void		insert		(Histogram&	histogram,
+				 const char*	wordCPtr
+				);
+
+
+//  PURPOSE:  To merge the sorted runs of 'runVector' into one sorted run
+//	appended to 'entryVector', adding the counts of a word that is in
+//	more than one run.  The merged entries point to the same words as
+//	the runs do.  No return value.
+extern
+void		mergeSorted	(const std::vector< std::vector<WordCount> >&	runVector,
+				 std::vector<WordCount>&			entryVector
+				);
+
+
+//  PURPOSE:  To add to 'histogram' the counts of the entries of
+//	'entryVector', such as those another histogram has, each 'times'
+//	times over.  No return value.
+extern
+void		merge		(Histogram&			histogram,
+				 const std::vector<WordCount>&	entryVector,
+				 int				times
+				);
+
+
+//  PURPOSE:  To append to 'topVector' the 'k' entries of 'entryVector' with
+//	the highest counts (or all of them if there are fewer), most frequent
+//	first and those with the same count by word.  Keeps only 'k' entries
+//	in a heap while going through 'entryVector', in any order, once.  No
+//	return value.
+extern
+void		selectTop	(const std::vector<WordCount>&	entryVector,
+				 int				k,
+				 std::vector<WordCount>&	topVector
+				);
+
+
+//  PURPOSE:  To print out 'histogram' in sorted order, one "count\tword"
+//	line per distinct word.  No return value.
+extern
+void		print		(const Histogram&	histogram
+				);
+
+
+//  PURPOSE:  To print out the sorted entries of 'entryVector' to standard
+//	output, serialized in binary if 'isBinary' or else as text, in one
+//	buffer written out in chunks.  No return value.
+extern
+void		print		(const std::vector<WordCount>&	entryVector,
+				 bool				isBinary	= false
+				);
+
+
+//  PURPOSE:  To return the number of bytes 'serialize()' writes for the
+//	entries of 'entryVector', in binary if 'isBinary' or else as text.
+extern
+size_t		getSerializedLen(const std::vector<WordCount>&	entryVector,
+				 bool				isBinary
+				);
+
+
+//  PURPOSE:  To write the entries of 'entryVector' at 'bufferPtr', which has
+//	room for 'getSerializedLen()' bytes.  As text, each is a
+//	"count\tword\n" line, as 'printf("%d\t%s\n")' would write it.  In
+//	binary, each is a 'u32' count and a 'u16' word length in network
+//	byte order and then the word, as in a version 2 reply.  Returns the
+//	number of bytes written.
+extern
+size_t		serialize	(const std::vector<WordCount>&	entryVector,
+				 bool				isBinary,
+				 char*				bufferPtr
+				);
+
+
+//  PURPOSE:  To write the 'len' bytes at 'bufferPtr' to file descriptor
+//	'fd', at most 'SERIAL_CHUNK_LEN' at a time.  Returns 'true' if they
+//	all were written, or 'false' otherwise.
+extern
+bool		writeAll	(int		fd,
+				 const char*	bufferPtr,
+				 size_t		len
+				);
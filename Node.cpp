@@ -12,74 +12,214 @@
  *-------------------------------------------------------------------------*/
 
 #include	"header.h"
+#include	"Histogram.h"
 #include	"Node.h"
 
-//  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+
+//  PURPOSE:  To recompute the height of node 'index' from its children.  No
 //	return value.
-Node::~Node			()
+void		WordTree::updateHeight
+				(uint32_t	index
+				)
+{
+  Node&	node		= nodeVector_[index];
+  int	leftHeight	= heightOf(node.getLeftIndex());
+  int	rightHeight	= heightOf(node.getRightIndex());
+
+  node.setHeight(1 + ((leftHeight > rightHeight) ? leftHeight : rightHeight));
+}
+
+
+//  PURPOSE:  To rotate the subtree at 'index' to the right.  Returns the
+//	index of the new root of the subtree.
+uint32_t	WordTree::rotateRight
+				(uint32_t	index
+				)
+{
+  uint32_t	newRootIndex	= nodeVector_[index].getLeftIndex();
+
+  nodeVector_[index].setLeftIndex(nodeVector_[newRootIndex].getRightIndex());
+  nodeVector_[newRootIndex].setRightIndex(index);
+  updateHeight(index);
+  updateHeight(newRootIndex);
+  return(newRootIndex);
+}
+
+
+//  PURPOSE:  To rotate the subtree at 'index' to the left.  Returns the
+//	index of the new root of the subtree.
+uint32_t	WordTree::rotateLeft
+				(uint32_t	index
+				)
 {
+  uint32_t	newRootIndex	= nodeVector_[index].getRightIndex();
 
-	free(wordCPtr_);
-	
-	if (leftPtr_ != NULL)
-		delete leftPtr_;
-	
-	if (rightPtr_ != NULL)
-		delete rightPtr_;
+  nodeVector_[index].setRightIndex(nodeVector_[newRootIndex].getLeftIndex());
+  nodeVector_[newRootIndex].setLeftIndex(index);
+  updateHeight(index);
+  updateHeight(newRootIndex);
+  return(newRootIndex);
 }
 
 
-//  PURPOSE:  To either increment the count of the node at or under '*nodePtr'
-//	that corresponds to word 'wordCPtr' when such a node exists, or to
-//	insert a 'new Node()' for 'wordCPtr' under '*nodePtr' that maintains
-//	the sorted nature of the subtree.  No return value.
-void		insert		(Node*		nodePtr,
-				 const char*	wordCPtr
+//  PURPOSE:  To restore the AVL property at 'index', whose children are
+//	already balanced.  Returns the index of the new root of the subtree.
+uint32_t	WordTree::rebalance
+				(uint32_t	index
 				)
 {
-  int	compRes	= strcmp(nodePtr->getWordCPtr(),wordCPtr);
+  uint32_t	leftIndex	= nodeVector_[index].getLeftIndex();
+  uint32_t	rightIndex	= nodeVector_[index].getRightIndex();
+  int		balance		= heightOf(leftIndex) - heightOf(rightIndex);
 
-  if  (compRes > 0)
+  if  (balance > 1)
   {
-   
-	if (nodePtr->getLeftPtr() != NULL) {
-		insert(nodePtr->getLeftPtr(), wordCPtr);
-	}
-	else {
-		Node* newNode = new Node(wordCPtr);
-		nodePtr->setLeftPtr(newNode);
-	}
+    const Node&	left	= nodeVector_[leftIndex];
+
+    if  (heightOf(left.getLeftIndex()) < heightOf(left.getRightIndex()))
+      nodeVector_[index].setLeftIndex(rotateLeft(leftIndex));
+
+    return(rotateRight(index));
   }
-  else
-  if  (compRes < 0)
+
+  if  (balance < -1)
   {
-    
-	if (nodePtr->getRightPtr() != NULL) {
-		insert(nodePtr->getRightPtr(), wordCPtr);
-	}
-	else {
-		Node* newNode = new Node(wordCPtr);
-		nodePtr->setRightPtr(newNode);
-	}
+    const Node&	right	= nodeVector_[rightIndex];
+
+    if  (heightOf(right.getRightIndex()) < heightOf(right.getLeftIndex()))
+      nodeVector_[index].setRightIndex(rotateRight(rightIndex));
+
+    return(rotateLeft(index));
   }
+
+  updateHeight(index);
+  return(index);
+}
+
+
+//  PURPOSE:  To return the index of a new node for the 'wordLen' chars at
+//	'wordCPtr' with count 'count', keeping them in the node or appending
+//	them to the string pool.  'exit()'s if the pool would grow past what
+//	a node's 32-bit offset reaches.
+uint32_t	WordTree::newNode
+				(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
+				)
+{
+  Node	node(wordLen,count);
+
+  if  (node.isInline())
+    node.setInlineWord(wordCPtr);
   else
   {
+    //  A bigger offset would wrap, and the node would name another word:
+    if  (pool_.size() > UINT32_MAX)
+    {
+      fprintf(stderr,"Too many long words: the string pool is past 4 GB\n");
+      exit(EXIT_FAILURE);
+    }
+
+    node.setPoolOffset(pool_.size());
+    pool_.insert(pool_.end(),wordCPtr,wordCPtr+wordLen);
+    pool_.push_back('\0');
+  }
+
+  nodeVector_.push_back(node);
+  return(nodeVector_.size() - 1);
+}
+
+
+//  PURPOSE:  To either add 'count' to the count of the node for the
+//	'wordLen' chars at 'wordCPtr', or to add a node for them with count
+//	'count', and then to re-balance the tree.  No return value.
+void		WordTree::add	(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
+				)
+{
+  uint32_t	pathArray[WORD_TREE_MAX_HEIGHT];
+  bool		wentLeftArray[WORD_TREE_MAX_HEIGHT];
+  int		depth	= 0;
+  uint32_t	index	= rootIndex_;
+
+  //  I.  Find the node, noting the path down to where it would go:
+  while  (index != NO_NODE)
+  {
+    Node&	node	= nodeVector_[index];
+    int		compRes	= compareWords(getWordCPtr(node),node.getWordLen(),wordCPtr,wordLen);
+
+    if  (compRes == 0)
+    {
+      node.addCount(count);
+      return;
+    }
+
+    pathArray[depth]	= index;
+    wentLeftArray[depth]= (compRes > 0);
+    depth++;
+    index		= (compRes > 0) ? node.getLeftIndex() : node.getRightIndex();
+  }
+
+  //  II.  Add it and re-balance back up the path, hanging each new subtree
+  //	   root under its parent.  Adding may move 'nodeVector_', so no
+  //	   reference to a node is kept across it:
+  index	= newNode(wordCPtr,wordLen,count);
+
+  while  (depth > 0)
+  {
+    uint32_t	parentIndex	= pathArray[--depth];
+    int		oldHeight	= nodeVector_[parentIndex].getHeight();
 
-	nodePtr->incCount();
+    if  (wentLeftArray[depth])
+      nodeVector_[parentIndex].setLeftIndex(index);
+    else
+      nodeVector_[parentIndex].setRightIndex(index);
+
+    index	= rebalance(parentIndex);
+
+    //  A subtree that kept its root and its height changes nothing above:
+    if  ( (index == parentIndex)  &&  (nodeVector_[index].getHeight() == oldHeight) )
+      return;
   }
+
+  rootIndex_	= index;
 }
 
 
-//  PURPOSE:  To print out the subtree pointed to by 'nodePtr' in an in-fix
-//	(sorted) fashion.  No return value.
-void		print		(const Node*	nodePtr
+//  PURPOSE:  To append to 'entryVector' one entry per distinct word, in
+//	the in-fix order of the tree.  The entries point to words that stay
+//	put until the next word is added.  Loops rather than recurses.  No
+//	return value.
+void		WordTree::getSorted
+				(std::vector<WordCount>&	entryVector
 				)
+				const
 {
+  uint32_t	stackArray[WORD_TREE_MAX_HEIGHT];
+  int		depth	= 0;
+  uint32_t	index	= rootIndex_;
+
+  entryVector.reserve(entryVector.size() + nodeVector_.size());
+
+  //  Each node is stacked on the way down its left spine, and appended when
+  //  popped, before going down its right subtree:
+  while  ( (index != NO_NODE)  ||  (depth > 0) )
+  {
+    if  (index != NO_NODE)
+    {
+      stackArray[depth++]	= index;
+      index			= nodeVector_[index].getLeftIndex();
+      continue;
+    }
+
+    const Node&	node	= nodeVector_[stackArray[--depth]];
+    WordCount	entry;
 
-  if (nodePtr == NULL)
-	  return;
-  
-  print(nodePtr->getLeftPtr());
-  printf("%d\t%s\n",nodePtr->getCount(),nodePtr->getWordCPtr());
-  print(nodePtr->getRightPtr());
+    entry.wordCPtr	= getWordCPtr(node);
+    entry.wordLen	= node.getWordLen();
+    entry.count		= node.getCount();
+    entryVector.push_back(entry);
+    index		= node.getRightIndex();
+  }
 }
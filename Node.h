@@ -10,125 +10,320 @@
  *---									---*
  *-------------------------------------------------------------------------*/
 
+#include	<stdint.h>
+
+
+//  PURPOSE:  To tell the index of no node, the child of a leaf.
+const uint32_t	NO_NODE			= 0xFFFFFFFF;
+
+//  PURPOSE:  To tell the number of bytes a 'Node' has for its word.  A word
+//	shorter than that is kept in the node itself, '\0'-terminated, and a
+//	longer one in the string pool of its 'WordTree'.
+const int	NODE_INLINE_LEN		= 10;
+
+//  PURPOSE:  To tell the most nodes on a path from the root of a 'WordTree'
+//	to a leaf.  An AVL tree of 2^32 nodes is less than 1.45*32+2 high, so
+//	paths are kept in fixed arrays of this length instead of recursing.
+const int	WORD_TREE_MAX_HEIGHT	= 64;
+
+
 class	Node
 {
   //  I.  Member vars:
-  //  PURPOSE:  To hold the address of the left child of '*this', or 'NULL'
-  //	if there is no left-child.
-  Node*		leftPtr_;
-
-  //  PURPOSE:  To hold the address of the right child of '*this', or 'NULL'
-  //	if there is no left-child.
-  Node*		rightPtr_;
+  //  PURPOSE:  To hold the index of the left child of '*this' in the node
+  //	array of its 'WordTree', or 'NO_NODE' if there is no left-child.
+  uint32_t	leftIndex_;
 
-  //  PURPOSE:  To point to the word being counted.
-  char*		wordCPtr_;
+  //  PURPOSE:  To hold the index of the right child of '*this', or 'NO_NODE'
+  //	if there is no right-child.
+  uint32_t	rightIndex_;
 
   //  PURPOSE:  To tell the count.
   int		count_;
 
+  //  PURPOSE:  To tell the height of the subtree rooted at '*this' (a leaf
+  //	has height 1).  Used to keep the tree AVL-balanced.
+  uint8_t	height_;
 
-  //  II.  Disallowed auto-generated methods:
- 
-  Node				();
+  //  PURPOSE:  To tell the length of the word being counted, which is less
+  //	than 'BUFFER_LEN'.
+  uint8_t	wordLen_;
 
+  //  PURPOSE:  To hold the word being counted, '\0'-terminated, if it is
+  //	shorter than 'NODE_INLINE_LEN', or else the 'uint32_t' offset of it
+  //	in the string pool.
+  char		word_[NODE_INLINE_LEN];
 
-  Node				(const Node&
-				);
 
-  Node&		operator=	(const Node&
-				);
+  //  II.  Disallowed auto-generated methods:
+  Node				();
 
 protected :
   //  III.  Protected methods:
 
 public :
   //  IV.  Constructor(s), op(s), factory(s) and destructor:
-  //  PURPOSE:  To initialize '*this' to note that word 'wordCPtr' has been
-  //	seen once so far.
-  Node				(const char*	wordCPtr
+  //  PURPOSE:  To initialize '*this' to note that a word of 'wordLen' chars
+  //	has been seen 'count' times so far.  The word is then set with
+  //	'setInlineWord()' or 'setPoolOffset()'.
+  Node				(int		wordLen,
+				 int		count
 				) :
-				leftPtr_(NULL),
-				rightPtr_(NULL),
-				wordCPtr_(strndup(wordCPtr,BUFFER_LEN-1)),
-				count_(1)
+				leftIndex_(NO_NODE),
+				rightIndex_(NO_NODE),
+				count_(count),
+				height_(1),
+				wordLen_(wordLen)
 				{ }
-				
-  //  PURPOSE:  To release the resources of '*this'.  No parameters.  No
-  //	return value.
-  ~Node				();
 
   //  V.  Accessors:
-  //  PURPOSE:  To return the address of the left child of '*this', or 'NULL'
-  //	if there is no left-child.  No parameters.
-  Node*		getLeftPtr	()
+  //  PURPOSE:  To return the index of the left child of '*this', or
+  //	'NO_NODE' if there is no left-child.  No parameters.
+  uint32_t	getLeftIndex	()
 				const
 				{
-				  return(leftPtr_);
+				  return(leftIndex_);
 				}
 
-  //  PURPOSE:  To return the address of the right child of '*this', or 'NULL'
-  //	if there is no left-child.  No parameters.
-  Node*		getRightPtr	()
+  //  PURPOSE:  To return the index of the right child of '*this', or
+  //	'NO_NODE' if there is no right-child.  No parameters.
+  uint32_t	getRightIndex	()
 				const
 				{
-				  return(rightPtr_);
+				  return(rightIndex_);
 				}
 
-  //  PURPOSE:  To return the address of the word being counted.  No parameters.
-  const char*	getWordCPtr	()
+  //  PURPOSE:  To return the count.  No parameters.
+  int		getCount	()
 				const
 				{
-				  return(wordCPtr_);
+				  return(count_);
 				}
 
-  //  PURPOSE:  To return the count.  No parameters.
-  int		getCount	()
+  //  PURPOSE:  To return the height of the subtree rooted at '*this'.  No
+  //	parameters.
+  int		getHeight	()
 				const
 				{
-				  return(count_);
+				  return(height_);
+				}
+
+  //  PURPOSE:  To return the length of the word being counted.  No
+  //	parameters.
+  int		getWordLen	()
+				const
+				{
+				  return(wordLen_);
+				}
+
+  //  PURPOSE:  To return 'true' if the word is kept in '*this', or 'false'
+  //	if it is in the string pool.  No parameters.
+  bool		isInline	()
+				const
+				{
+				  return(wordLen_ < NODE_INLINE_LEN);
+				}
+
+  //  PURPOSE:  To return the address of the word kept in '*this', if
+  //	'isInline()'.  No parameters.
+  const char*	getInlineWord	()
+				const
+				{
+				  return(word_);
+				}
+
+  //  PURPOSE:  To return the offset of the word in the string pool, if not
+  //	'isInline()'.  No parameters.
+  uint32_t	getPoolOffset	()
+				const
+				{
+				  uint32_t	offset;
+
+				  memcpy(&offset,word_,sizeof(offset));
+				  return(offset);
 				}
 
   //  VI.  Mutators:
-  //  PURPOSE:  To note that the address of the left child is now 'newLeftPtr'.
+  //  PURPOSE:  To note that the index of the left child is now 'newIndex'.
+  //	No return value.
+  void		setLeftIndex	(uint32_t	newIndex
+				)
+				{
+				  leftIndex_	= newIndex;
+				}
+
+  //  PURPOSE:  To note that the index of the right child is now 'newIndex'.
   //	No return value.
-  void		setLeftPtr	(Node*	newLeftPtr
+  void		setRightIndex	(uint32_t	newIndex
 				)
 				{
-				  leftPtr_	= newLeftPtr;
+				  rightIndex_	= newIndex;
 				}
 
-  //  PURPOSE:  To note that the address of the right child is now
-  //	'newRightPtr'.  No return value.
-  void		setRightPtr	(Node*	newRightPtr
+  //  PURPOSE:  To note that the height of the subtree rooted at '*this' is
+  //	now 'newHeight'.  No return value.
+  void		setHeight	(int	newHeight
 				)
 				{
-				  rightPtr_	= newRightPtr;
+				  height_	= newHeight;
 				}
 
-  //  PURPOSE:  To note that the word for '*this' has been seen one more time.
-  //	No parameters.  No return value.
-  void		incCount	()
+  //  PURPOSE:  To note that the word for '*this' has been seen 'count' more
+  //	times.  No return value.
+  void		addCount	(int	count
+				)
+				{
+				  count_	+= count;
+				}
+
+  //  PURPOSE:  To keep in '*this' a '\0'-terminated copy of the word of
+  //	'getWordLen()' chars at 'wordCPtr', if 'isInline()'.  No return
+  //	value.
+  void		setInlineWord	(const char*	wordCPtr
+				)
 				{
-				  count_++;
+				  memcpy(word_,wordCPtr,wordLen_);
+				  word_[wordLen_]	= '\0';
+				}
+
+  //  PURPOSE:  To note that the word is at offset 'offset' in the string
+  //	pool, if not 'isInline()'.  No return value.
+  void		setPoolOffset	(uint32_t	offset
+				)
+				{
+				  memcpy(word_,&offset,sizeof(offset));
 				}
 
 };
 
 
-//  PURPOSE:  To either increment the count of the node at or under '*nodePtr'
-//	that corresponds to word 'wordCPtr' when such a node exists, or to
-//	insert a 'new Node()' for 'wordCPtr' under '*nodePtr' that maintains
-//	the sorted nature of the subtree.  No return value.
-extern
-void		insert		(Node*		nodePtr,
-				 const char*	wordCPtr
+class	WordTree : public Histogram
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To hold the nodes of '*this', one after the other, which
+  //	refer to each other by their indices.
+  std::vector<Node>	nodeVector_;
+
+  //  PURPOSE:  To hold, one after the other and '\0'-terminated, the words
+  //	too long to be kept in their nodes.  Only ever appended to.
+  std::vector<char>	pool_;
+
+  //  PURPOSE:  To hold the index of the root of the balanced tree, or
+  //	'NO_NODE' if no word has been inserted yet.
+  uint32_t		rootIndex_;
+
+
+  //  II.  Disallowed auto-generated methods:
+  WordTree			(const WordTree&
+				);
+
+  WordTree&	operator=	(const WordTree&
+				);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To return the height of the subtree at 'index', or '0' if
+  //	'index' is 'NO_NODE'.
+  int		heightOf	(uint32_t	index
+				)
+				const
+				{
+				  return( (index == NO_NODE) ? 0 : nodeVector_[index].getHeight() );
+				}
+
+  //  PURPOSE:  To recompute the height of node 'index' from its children.
+  //	No return value.
+  void		updateHeight	(uint32_t	index
+				);
+
+  //  PURPOSE:  To rotate the subtree at 'index' to the right.  Returns the
+  //	index of the new root of the subtree.
+  uint32_t	rotateRight	(uint32_t	index
 				);
 
+  //  PURPOSE:  To rotate the subtree at 'index' to the left.  Returns the
+  //	index of the new root of the subtree.
+  uint32_t	rotateLeft	(uint32_t	index
+				);
+
+  //  PURPOSE:  To restore the AVL property at 'index', whose children are
+  //	already balanced.  Returns the index of the new root of the subtree.
+  uint32_t	rebalance	(uint32_t	index
+				);
+
+  //  PURPOSE:  To return the index of a new node for the 'wordLen' chars at
+  //	'wordCPtr' with count 'count', keeping them in the node or appending
+  //	them to the string pool.
+  uint32_t	newNode		(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
+				);
+
+public :
+  //  IV.  Constructor(s), op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to an empty tree.  No parameters.
+  WordTree			() :
+				rootIndex_(NO_NODE)
+				{ }
+
+  //  PURPOSE:  To release the resources of '*this'.  The nodes and the pool
+  //	go back in one step each.  No parameters.  No return value.
+  ~WordTree			()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the address of the '\0'-terminated word of node
+  //	'node', which stays put until the next word is added.
+  const char*	getWordCPtr	(const Node&	node
+				)
+				const
+				{
+				  return( node.isInline()
+					  ? node.getInlineWord()
+					  : &pool_[node.getPoolOffset()]
+					);
+				}
+
+  //  PURPOSE:  To return the number of distinct words.  No parameters.
+  int		getNumDistinct	()
+				const
+				{
+				  return(nodeVector_.size());
+				}
+
+  //  PURPOSE:  To return the number of bytes the nodes and the pool of
+  //	'*this' have reserved.  No parameters.
+  size_t	getNumBytes	()
+				const
+				{
+				  return(nodeVector_.capacity() * sizeof(Node) + pool_.capacity());
+				}
+
+  //  PURPOSE:  To append to 'entryVector' one entry per distinct word, in
+  //	the in-fix order of the tree.  The entries point to words that stay
+  //	put until the next word is added.  No return value.
+  void		getSorted	(std::vector<WordCount>&	entryVector
+				)
+				const;
 
-//  PURPOSE:  To print out the subtree pointed to by 'nodePtr' in an in-fix
-//	(sorted) fashion.  No return value.
-extern
-void		print		(const Node*	nodePtr
+  //  VI.  Mutators:
+  //  PURPOSE:  To either increment the count of the node for the 'wordLen'
+  //	chars at 'wordCPtr', or to add a node for them, and then to
+  //	re-balance the tree.  Loops rather than recurses, so any number of
+  //	words may be inserted in any order.  No return value.
+  void		insert		(const char*	wordCPtr,
+				 int		wordLen
+				)
+				{
+				  add(wordCPtr,wordLen,1);
+				}
+
+  //  PURPOSE:  To either add 'count' to the count of the node for the
+  //	'wordLen' chars at 'wordCPtr', or to add a node for them with count
+  //	'count', and then to re-balance the tree.  No return value.
+  void		add		(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
 				);
 
+};
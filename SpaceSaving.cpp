@@ -0,0 +1,305 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		SpaceSaving.cpp						---*
+ *---									---*
+ *---	    This file defines the methods of class SpaceSaving.		---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"header.h"
+#include	<algorithm>
+#include	"Histogram.h"
+#include	"SpaceSaving.h"
+
+
+//  PURPOSE:  To initialize '*this' to an empty sketch of 'numCounters'
+//	counters, which is all the memory it ever uses.
+SpaceSaving::SpaceSaving	(int		numCounters
+				) :
+				counterArray_((SketchCounter*)calloc(numCounters,sizeof(SketchCounter))),
+				numCounters_(numCounters),
+				numUsed_(0),
+				heapArray_((int*)calloc(numCounters,sizeof(int))),
+				slotArray_(NULL),
+				indexMask_(0)
+{
+  unsigned int	numSlots	= 1;
+
+  //  Keep the load factor at or under one half:
+  while  (numSlots < 2 * (unsigned int)numCounters)
+    numSlots	*= 2;
+
+  slotArray_	= (int*)malloc(numSlots * sizeof(int));
+  indexMask_	= numSlots - 1;
+
+  if  ( (counterArray_ == NULL)  ||  (heapArray_ == NULL)  ||  (slotArray_ == NULL) )
+  {
+    fprintf(stderr,"Out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for  (unsigned int i = 0;  i < numSlots;  i++)
+    slotArray_[i]	= -1;
+}
+
+
+//  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+//	return value.
+SpaceSaving::~SpaceSaving	()
+{
+  free(slotArray_);
+  free(heapArray_);
+  free(counterArray_);
+}
+
+
+//  PURPOSE:  To return the index of the slot holding the counter of the
+//	'wordLen' chars at 'wordCPtr', whose hash is 'hash', or of the empty
+//	slot where it would go.
+unsigned int	SpaceSaving::findSlot
+				(const char*	wordCPtr,
+				 int		wordLen,
+				 unsigned int	hash
+				)
+				const
+{
+  unsigned int	slot	= hash & indexMask_;
+
+  while  (slotArray_[slot] >= 0)
+  {
+    const SketchCounter&	counter	= counterArray_[slotArray_[slot]];
+
+    if  ( (counter.hash == hash)				&&
+	  (counter.wordLen == wordLen)				&&
+	  (memcmp(counter.word,wordCPtr,wordLen) == 0)
+	)
+      break;
+
+    slot	= (slot + 1) & indexMask_;
+  }
+
+  return(slot);
+}
+
+
+//  PURPOSE:  To empty slot 'slot', moving up the slots after it that would
+//	no longer be found.  No return value.
+void		SpaceSaving::clearSlot
+				(unsigned int	slot
+				)
+{
+  unsigned int	next	= slot;
+
+  slotArray_[slot]	= -1;
+
+  while  (slotArray_[next = (next + 1) & indexMask_] >= 0)
+  {
+    unsigned int	home	= counterArray_[slotArray_[next]].hash & indexMask_;
+
+    //  It stays if its home is after the hole, cyclically:
+    if  ( ((next - home) & indexMask_) < ((next - slot) & indexMask_) )
+      continue;
+
+    slotArray_[slot]	= slotArray_[next];
+    slotArray_[next]	= -1;
+    slot		= next;
+  }
+}
+
+
+//  PURPOSE:  To move the counter at 'heapIndex' in the heap towards the top
+//	while its count is less than its parent's.  No return value.
+void		SpaceSaving::siftUp
+				(int		heapIndex
+				)
+{
+  int	counter	= heapArray_[heapIndex];
+
+  while  (heapIndex > 0)
+  {
+    int	parentIndex	= (heapIndex - 1) / 2;
+
+    if  (counterArray_[heapArray_[parentIndex]].count <= counterArray_[counter].count)
+      break;
+
+    placeInHeap(heapIndex,heapArray_[parentIndex]);
+    heapIndex	= parentIndex;
+  }
+
+  placeInHeap(heapIndex,counter);
+}
+
+
+//  PURPOSE:  To move the counter at 'heapIndex' in the heap towards the
+//	bottom while its count is more than a child's.  No return value.
+void		SpaceSaving::siftDown
+				(int		heapIndex
+				)
+{
+  int	counter	= heapArray_[heapIndex];
+
+  while  (2 * heapIndex + 1 < numUsed_)
+  {
+    int	childIndex	= 2 * heapIndex + 1;
+
+    if  ( (childIndex + 1 < numUsed_)  &&
+	  (counterArray_[heapArray_[childIndex+1]].count <
+	   counterArray_[heapArray_[childIndex]].count
+	  )
+	)
+      childIndex++;
+
+    if  (counterArray_[counter].count <= counterArray_[heapArray_[childIndex]].count)
+      break;
+
+    placeInHeap(heapIndex,heapArray_[childIndex]);
+    heapIndex	= childIndex;
+  }
+
+  placeInHeap(heapIndex,counter);
+}
+
+
+//  PURPOSE:  To append to 'entryVector' one entry per word with a counter,
+//	with its approximate count, sorted the way 'strcmp()' orders the
+//	words.  No return value.
+void		SpaceSaving::getSorted
+				(std::vector<WordCount>&	entryVector
+				)
+				const
+{
+  size_t	first	= entryVector.size();
+
+  entryVector.reserve(first + numUsed_);
+
+  for  (int i = 0;  i < numUsed_;  i++)
+  {
+    WordCount	entry;
+
+    entry.wordCPtr	= counterArray_[i].word;
+    entry.wordLen	= counterArray_[i].wordLen;
+    entry.count		= counterArray_[i].count;
+    entryVector.push_back(entry);
+  }
+
+  std::sort(entryVector.begin()+first,entryVector.end(),isWordBefore);
+}
+
+
+//  PURPOSE:  To return the counter given to the 'wordLen' chars at
+//	'wordCPtr', whose hash is 'hash' and which have none: a free one with
+//	count '0', or else the one with the least count, which keeps it.  The
+//	caller changes the count and then re-places the counter in the heap.
+SketchCounter&	SpaceSaving::claimCounter
+				(const char*	wordCPtr,
+				 int		wordLen,
+				 unsigned int	hash
+				)
+{
+  int	index;
+
+  if  (numUsed_ < numCounters_)
+  {
+    //  A free counter goes at the bottom of the heap:
+    index				= numUsed_++;
+    counterArray_[index].count		= 0;
+    counterArray_[index].heapIndex	= numUsed_ - 1;
+    heapArray_[numUsed_-1]		= index;
+  }
+  else
+  {
+    index	= heapArray_[0];
+    clearSlot(findSlot(counterArray_[index].word,counterArray_[index].wordLen,
+		       counterArray_[index].hash
+		      )
+	     );
+  }
+
+  SketchCounter&	counter	= counterArray_[index];
+
+  memcpy(counter.word,wordCPtr,wordLen);
+  counter.word[wordLen]	= '\0';
+  counter.hash		= hash;
+  counter.wordLen	= wordLen;
+  slotArray_[findSlot(wordCPtr,wordLen,hash)]	= index;
+  return(counter);
+}
+
+
+//  PURPOSE:  To note 'count' more occurrences of the 'wordLen' chars
+//	starting at 'wordCPtr', taking over the counter with the least count
+//	if it has none and none is free.  No return value.
+void		SpaceSaving::add(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
+				)
+{
+  if  (wordLen >= BUFFER_LEN)
+    wordLen	= BUFFER_LEN-1;
+
+  unsigned int	hash	= hashWord(wordCPtr,wordLen);
+  unsigned int	slot	= findSlot(wordCPtr,wordLen,hash);
+
+  if  (slotArray_[slot] >= 0)
+  {
+    SketchCounter&	counter	= counterArray_[slotArray_[slot]];
+
+    counter.count	+= count;
+    siftDown(counter.heapIndex);
+    return;
+  }
+
+  //  A taken-over counter keeps its count, now credited to the new word:
+  SketchCounter&	counter	= claimCounter(wordCPtr,wordLen,hash);
+
+  counter.count	+= count;
+
+  //  A new counter may be less than its parent, a taken-over one more than
+  //  its children:
+  siftUp(counter.heapIndex);
+  siftDown(counter.heapIndex);
+}
+
+
+//  PURPOSE:  To raise the count of the 'wordLen' chars starting at
+//	'wordCPtr' to 'count', if they have a counter.  If not, to give them
+//	a free counter, or else the one with the least count if that is less
+//	than 'count'.  No return value.
+void		SpaceSaving::offer
+				(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
+				)
+{
+  if  (wordLen >= BUFFER_LEN)
+    wordLen	= BUFFER_LEN-1;
+
+  unsigned int	hash	= hashWord(wordCPtr,wordLen);
+  unsigned int	slot	= findSlot(wordCPtr,wordLen,hash);
+
+  if  (slotArray_[slot] >= 0)
+  {
+    SketchCounter&	counter	= counterArray_[slotArray_[slot]];
+
+    if  (counter.count < count)
+    {
+      counter.count	= count;
+      siftDown(counter.heapIndex);
+    }
+
+    return;
+  }
+
+  if  ( (numUsed_ == numCounters_)  &&  (counterArray_[heapArray_[0]].count >= count) )
+    return;
+
+  SketchCounter&	counter	= claimCounter(wordCPtr,wordLen,hash);
+
+  counter.count	= count;
+  siftUp(counter.heapIndex);
+  siftDown(counter.heapIndex);
+}
@@ -0,0 +1,182 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		SpaceSaving.h						---*
+ *---									---*
+ *---	    This file declares the SpaceSaving class, a sketch that	---*
+ *---	keeps approximate counts of the most frequent words in a fixed	---*
+ *---	number of counters (Metwally, Agrawal and El Abbadi's		---*
+ *---	Space-Saving algorithm).  When every counter is in use, a new	---*
+ *---	word takes over the counter with the least count and adds to	---*
+ *---	it.  So a count is never too low, and is too high by at most	---*
+ *---	the least count, which is at most the number of words seen	---*
+ *---	divided by the number of counters.  Any word seen more often	---*
+ *---	than that has a counter.					---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To hold one counter of a 'SpaceSaving' sketch, and the word it
+//	counts, '\0'-terminated.
+struct		SketchCounter
+{
+  char		word[BUFFER_LEN];
+  unsigned int	hash;
+  int		wordLen;
+  int		count;
+
+  //  PURPOSE:  To tell where the counter is in the heap of the sketch.
+  int		heapIndex;
+};
+
+
+class	SpaceSaving : public Histogram
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To point to the array of 'numCounters_' counters.
+  SketchCounter*	counterArray_;
+
+  //  PURPOSE:  To tell the number of counters.
+  int			numCounters_;
+
+  //  PURPOSE:  To tell the number of counters in use, which are the first
+  //	ones of 'counterArray_'.
+  int			numUsed_;
+
+  //  PURPOSE:  To hold the indices of the counters in use as a binary heap,
+  //	the one with the least count first.
+  int*			heapArray_;
+
+  //  PURPOSE:  To hold the index of a counter in use, or '-1', in each of
+  //	'indexMask_+1' slots, placed by the hash of its word with linear
+  //	probing.
+  int*			slotArray_;
+
+  //  PURPOSE:  To tell the number of slots of 'slotArray_' less one, their
+  //	number being a power of 2.
+  unsigned int		indexMask_;
+
+
+  //  II.  Disallowed auto-generated methods:
+  SpaceSaving			();
+
+  SpaceSaving			(const SpaceSaving&
+				);
+
+  SpaceSaving&	operator=	(const SpaceSaving&
+				);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To return the index of the slot holding the counter of the
+  //	'wordLen' chars at 'wordCPtr', whose hash is 'hash', or of the empty
+  //	slot where it would go.
+  unsigned int	findSlot	(const char*	wordCPtr,
+				 int		wordLen,
+				 unsigned int	hash
+				)
+				const;
+
+  //  PURPOSE:  To empty slot 'slot', moving up the slots after it that
+  //	would no longer be found.  No return value.
+  void		clearSlot	(unsigned int	slot
+				);
+
+  //  PURPOSE:  To put counter 'counter' at 'heapIndex' in the heap.  No
+  //	return value.
+  void		placeInHeap	(int		heapIndex,
+				 int		counter
+				)
+				{
+				  heapArray_[heapIndex]			= counter;
+				  counterArray_[counter].heapIndex	= heapIndex;
+				}
+
+  //  PURPOSE:  To return the counter given to the 'wordLen' chars at
+  //	'wordCPtr', whose hash is 'hash' and which have none: a free one
+  //	with count '0', or else the one with the least count, which keeps
+  //	it.  The caller changes the count and then re-places the counter in
+  //	the heap.
+  SketchCounter&
+		claimCounter	(const char*	wordCPtr,
+				 int		wordLen,
+				 unsigned int	hash
+				);
+
+  //  PURPOSE:  To move the counter at 'heapIndex' in the heap towards the
+  //	top while its count is less than its parent's.  No return value.
+  void		siftUp		(int		heapIndex
+				);
+
+  //  PURPOSE:  To move the counter at 'heapIndex' in the heap towards the
+  //	bottom while its count is more than a child's.  No return value.
+  void		siftDown	(int		heapIndex
+				);
+
+public :
+  //  IV.  Constructor(s), op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to an empty sketch of 'numCounters'
+  //	counters, which is all the memory it ever uses.
+  SpaceSaving			(int		numCounters
+				);
+
+  //  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+  //	return value.
+  ~SpaceSaving			();
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of bytes a sketch of 'numCounters'
+  //	counters takes.
+  static
+  size_t	getNumBytes	(int		numCounters
+				)
+				{
+				  return(numCounters * (sizeof(SketchCounter) + 3*sizeof(int)));
+				}
+
+  //  PURPOSE:  To return the number of distinct words with a counter.  No
+  //	parameters.
+  int		getNumDistinct	()
+				const
+				{
+				  return(numUsed_);
+				}
+
+  //  PURPOSE:  To append to 'entryVector' one entry per word with a counter,
+  //	with its approximate count, sorted the way 'strcmp()' orders the
+  //	words.  No return value.
+  void		getSorted	(std::vector<WordCount>&	entryVector
+				)
+				const;
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To note one more occurrence of the 'wordLen' chars starting at
+  //	'wordCPtr'.  No return value.
+  void		insert		(const char*	wordCPtr,
+				 int		wordLen
+				)
+				{
+				  add(wordCPtr,wordLen,1);
+				}
+
+  //  PURPOSE:  To note 'count' more occurrences of the 'wordLen' chars
+  //	starting at 'wordCPtr', taking over the counter with the least count
+  //	if it has none and none is free.  No return value.
+  void		add		(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
+				);
+
+  //  PURPOSE:  To raise the count of the 'wordLen' chars starting at
+  //	'wordCPtr' to 'count', if they have a counter.  If not, to give them
+  //	a free counter, or else the one with the least count if that is
+  //	less than 'count'.  This keeps the words with the highest counts
+  //	when the counts come from elsewhere.  No return value.
+  void		offer		(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
+				);
+
+};
@@ -0,0 +1,403 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Tokenizer.cpp						---*
+ *---									---*
+ *---	    This file defines the methods of class Tokenizer.		---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"header.h"
+#include	<sys/mman.h>	// For mmap(), munmap(), madvise()
+#include	<pthread.h>	// For pthread_create()
+#include	<atomic>
+#include	<algorithm>	// For std::sort()
+#include	"Tokenizer.h"
+#include	"WordOffsetIndex.h"
+
+
+//  PURPOSE:  To hold what the threads of one 'forEachFile()' share: the task
+//	to call, for how many files, and the next file no thread has taken.
+struct		FileTaskRun
+{
+  FileTask		task;
+  void*			taskPtr;
+  int			numFiles;
+  std::atomic<int>	nextFile;
+};
+
+
+//  PURPOSE:  To call the task of the 'FileTaskRun' that 'vPtr' points to for
+//	each file no thread has taken yet, until there are none.  Returns
+//	'NULL'.
+static
+void*		runFileTasks	(void*		vPtr
+				)
+{
+  FileTaskRun*	runPtr	= (FileTaskRun*)vPtr;
+  int		fileIndex;
+
+  while  ( (fileIndex = runPtr->nextFile.fetch_add(1)) < runPtr->numFiles )
+    (*runPtr->task)(runPtr->taskPtr,fileIndex);
+
+  return(NULL);
+}
+
+
+//  PURPOSE:  To initialize '*this' to have no file.  No parameters.
+Tokenizer::Tokenizer		() :
+				textPtr_(NULL),
+				textLen_(0),
+				mapLen_(0),
+				position_(0)
+{
+  memset(isSeparator_,0,sizeof(isSeparator_));
+
+  for  (const char* cPtr = SEPARATORY_CHAR_ARRAY;  *cPtr != '\0';  cPtr++)
+    isSeparator_[(unsigned char)*cPtr]	= 1;
+
+  isSeparator_[0]	= 1;
+}
+
+
+//  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+//	return value.
+Tokenizer::~Tokenizer		()
+{
+  if  (textPtr_ != NULL)
+    munmap((void*)textPtr_,mapLen_);
+}
+
+
+//  PURPOSE:  To memory-map file 'filenameCPtr' read-only and start at its
+//	beginning.  Returns 'true' on success or 'false' otherwise.
+bool		Tokenizer::open	(const char*	filenameCPtr
+				)
+{
+  return(open(std::vector<std::string>(1,filenameCPtr)));
+}
+
+
+//  PURPOSE:  To memory-map the files named in 'filenameVector' read-only,
+//	one after the other, and start at the beginning of the first.
+//	Returns 'true' on success or 'false' otherwise.
+bool		Tokenizer::open	(const std::vector<std::string>&
+						filenameVector
+				)
+{
+  //  I.  Lay the files out, each starting on a page of its own and followed
+  //	  by at least one '\0' (a separator), so no word runs from one file
+  //	  into the next:
+  size_t		pageLen		= sysconf(_SC_PAGESIZE);
+  size_t		numFiles	= filenameVector.size();
+  std::vector<size_t>	startVector(numFiles);
+  std::vector<size_t>	lenVector(numFiles);
+  size_t		mapLen		= 0;
+
+  for  (size_t i = 0;  i < numFiles;  i++)
+  {
+    struct stat	statBuffer;
+
+    if  (stat(filenameVector[i].c_str(),&statBuffer) < 0)
+      return(false);
+
+    startVector[i]	= mapLen;
+    lenVector[i]	= statBuffer.st_size;
+
+    if  (lenVector[i] > 0)
+      mapLen	+= (lenVector[i] + pageLen) / pageLen * pageLen;
+  }
+
+  if  (textPtr_ != NULL)
+    munmap((void*)textPtr_,mapLen_);
+
+  textPtr_	= NULL;
+  textLen_	= 0;
+  mapLen_	= 0;
+  position_	= 0;
+  fileStartVector_.clear();
+  fileLenVector_.clear();
+
+  //  II.  Reserve the addresses, reading as '\0's, then map each file over
+  //	   its part.  A file that shrank since it was laid out keeps its new
+  //	   length, and one that grew only the length it had:
+  char*		basePtr		= NULL;
+
+  if  (mapLen > 0)
+  {
+    void*	mapPtr	= mmap(NULL,mapLen,PROT_READ,
+			       MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE,-1,0
+			      );
+
+    if  (mapPtr == MAP_FAILED)
+      return(false);
+
+    basePtr	= (char*)mapPtr;
+  }
+
+  for  (size_t i = 0;  i < numFiles;  i++)
+  {
+    if  (lenVector[i] == 0)
+      continue;
+
+    int		fd	= ::open(filenameVector[i].c_str(),O_RDONLY);
+    struct stat	statBuffer;
+    void*	mapPtr	= MAP_FAILED;
+
+    if  ( (fd >= 0)  &&  (fstat(fd,&statBuffer) == 0) )
+    {
+      if  ((size_t)statBuffer.st_size < lenVector[i])
+	lenVector[i]	= statBuffer.st_size;
+
+      mapPtr	= (lenVector[i] == 0)
+		  ? basePtr
+		  : mmap(basePtr+startVector[i],lenVector[i],PROT_READ,
+			 MAP_PRIVATE|MAP_FIXED,fd,0
+			);
+    }
+
+    if  (fd >= 0)
+      close(fd);
+
+    if  (mapPtr == MAP_FAILED)
+    {
+      munmap(basePtr,mapLen);
+      return(false);
+    }
+
+    if  (lenVector[i] > 0)
+      madvise(mapPtr,lenVector[i],MADV_SEQUENTIAL);
+  }
+
+  //  III.  Note where they went:
+  if  (numFiles > 0)
+    textLen_	= startVector[numFiles-1] + lenVector[numFiles-1];
+
+  textPtr_		= basePtr;
+  mapLen_		= mapLen;
+  fileStartVector_.swap(startVector);
+  fileLenVector_.swap(lenVector);
+  return(true);
+}
+
+
+//  PURPOSE:  To call '(*task)(taskPtr,i)' once for each mapped file 'i',
+//	on as many threads at once as there are CPUs (but no more than
+//	'TOKENIZER_MAX_THREADS' or the number of files), each of which takes
+//	the next file no thread has taken yet.  Returns once every call has.
+//	No return value.
+void		Tokenizer::forEachFile
+				(FileTask	task,
+				 void*		taskPtr
+				)
+				const
+{
+  FileTaskRun	run;
+  int		numThreads	= sysconf(_SC_NPROCESSORS_ONLN);
+  pthread_t	threadArray[TOKENIZER_MAX_THREADS];
+
+  run.task	= task;
+  run.taskPtr	= taskPtr;
+  run.numFiles	= getNumFiles();
+  run.nextFile	= 0;
+
+  if  (numThreads > TOKENIZER_MAX_THREADS)
+    numThreads	= TOKENIZER_MAX_THREADS;
+
+  if  (numThreads > run.numFiles)
+    numThreads	= run.numFiles;
+
+  //  The calling thread is one of them:
+  for  (int i = 1;  i < numThreads;  i++)
+    if  (pthread_create(&threadArray[i],NULL,runFileTasks,&run) != 0)
+      numThreads	= i;
+
+  runFileTasks(&run);
+
+  for  (int i = 1;  i < numThreads;  i++)
+    pthread_join(threadArray[i],NULL);
+}
+
+
+//  PURPOSE:  To return 'true' if 'nameCPtr' names a word-offset index, as
+//	the name of a file with 'WORD_INDEX_SUFFIX' added, or the temporary
+//	file one is written to, as that name with "." and a process id
+//	added.  Returns 'false' otherwise, even for names that only contain
+//	the suffix.
+static
+bool		isIndexName	(const char*	nameCPtr
+				)
+{
+  size_t	nameLen		= strlen(nameCPtr);
+  size_t	suffixLen	= sizeof(WORD_INDEX_SUFFIX) - 1;
+  const char*	dotCPtr		= strrchr(nameCPtr,'.');
+
+  //  Leave off the ".<digits>" of a temporary file:
+  if  ( (dotCPtr != NULL)  &&  (dotCPtr[1] != '\0')  &&
+	(strspn(dotCPtr+1,"0123456789") == strlen(dotCPtr+1))
+      )
+    nameLen	= dotCPtr - nameCPtr;
+
+  return( (nameLen >= suffixLen)  &&
+	  (strncmp(nameCPtr + nameLen - suffixLen,WORD_INDEX_SUFFIX,suffixLen) == 0)
+	);
+}
+
+
+//  PURPOSE:  To add to 'filenameVector' the paths of the files in directory
+//	'dirName' and in the directories under it, leaving out hidden ones
+//	and word-offset indices.  Returns 'true' on success or 'false' if a
+//	directory cannot be read.
+static
+bool		addDirFiles	(const std::string&	dirName,
+				 std::vector<std::string>&
+							filenameVector
+				)
+{
+  DIR*		dirPtr	= opendir(dirName.c_str());
+  struct dirent*	entryPtr;
+  bool		isOk	= true;
+
+  if  (dirPtr == NULL)
+    return(false);
+
+  while  ( isOk  &&  ((entryPtr = readdir(dirPtr)) != NULL) )
+  {
+    if  ( (entryPtr->d_name[0] == '.')  ||  isIndexName(entryPtr->d_name) )
+      continue;
+
+    std::string	path	= dirName + "/" + entryPtr->d_name;
+    struct stat	statBuffer;
+
+    if  (stat(path.c_str(),&statBuffer) < 0)
+      continue;
+
+    if  (S_ISDIR(statBuffer.st_mode))
+      isOk	= addDirFiles(path,filenameVector);
+    else
+    if  (S_ISREG(statBuffer.st_mode))
+      filenameVector.push_back(path);
+  }
+
+  closedir(dirPtr);
+  return(isOk);
+}
+
+
+//  PURPOSE:  To set 'filenameVector' to the names of the files that
+//	'pathCPtr' names, in the order their words are read: the file itself;
+//	or, if it is a directory, the files in it and in the directories
+//	under it, sorted by path, leaving out hidden ones and word-offset
+//	indices; or, if it is "@listFile", the files named by the lines of
+//	'listFile'.  Returns 'true' on success or 'false' if 'pathCPtr'
+//	cannot be read.
+bool		listCorpusFiles	(const char*		pathCPtr,
+				 std::vector<std::string>&
+							filenameVector
+				)
+{
+  struct stat	statBuffer;
+
+  filenameVector.clear();
+
+  //  I.  A list of files:
+  if  (pathCPtr[0] == '@')
+  {
+    FILE*	filePtr	= fopen(pathCPtr+1,"r");
+    char*	linePtr	= NULL;
+    size_t	lineCapacity	= 0;
+    ssize_t	lineLen;
+
+    if  (filePtr == NULL)
+      return(false);
+
+    while  ( (lineLen = getline(&linePtr,&lineCapacity,filePtr)) >= 0 )
+    {
+      while  ( (lineLen > 0)  &&
+	       ( (linePtr[lineLen-1] == '\n')  ||  (linePtr[lineLen-1] == '\r') )
+	     )
+	linePtr[--lineLen]	= '\0';
+
+      if  (lineLen > 0)
+	filenameVector.push_back(linePtr);
+    }
+
+    free(linePtr);
+    fclose(filePtr);
+    return(true);
+  }
+
+  //  II.  A directory:
+  if  (stat(pathCPtr,&statBuffer) < 0)
+    return(false);
+
+  if  (S_ISDIR(statBuffer.st_mode))
+  {
+    if  (!addDirFiles(pathCPtr,filenameVector))
+      return(false);
+
+    std::sort(filenameVector.begin(),filenameVector.end());
+    return(true);
+  }
+
+  //  III.  One file:
+  filenameVector.push_back(pathCPtr);
+  return(true);
+}
+
+
+//  PURPOSE:  To return a number that changes whenever a file is added to or
+//	removed from 'filenameVector', or one of them is replaced or changed,
+//	judging by their names, devices, inodes, sizes and modification
+//	times.
+uint64_t	stampCorpusFiles(const std::vector<std::string>&
+							filenameVector
+				)
+{
+  //  (an FNV-1a hash of it all)
+  uint64_t	stamp	= 14695981039346656037ULL;
+
+  for  (size_t i = 0;  i < filenameVector.size();  i++)
+  {
+    struct stat	statBuffer;
+    uint64_t	fieldArray[5];
+
+    memset(&statBuffer,'\0',sizeof(statBuffer));
+    stat(filenameVector[i].c_str(),&statBuffer);
+    fieldArray[0]	= statBuffer.st_dev;
+    fieldArray[1]	= statBuffer.st_ino;
+    fieldArray[2]	= statBuffer.st_size;
+    fieldArray[3]	= statBuffer.st_mtim.tv_sec;
+    fieldArray[4]	= statBuffer.st_mtim.tv_nsec;
+
+    const unsigned char*	bytePtr	= (const unsigned char*)filenameVector[i].c_str();
+
+    for  (size_t j = 0;  j <= filenameVector[i].size();  j++)
+      stamp	= (stamp ^ bytePtr[j]) * 1099511628211ULL;
+
+    bytePtr	= (const unsigned char*)fieldArray;
+
+    for  (size_t j = 0;  j < sizeof(fieldArray);  j++)
+      stamp	= (stamp ^ bytePtr[j]) * 1099511628211ULL;
+  }
+
+  return(stamp);
+}
+
+
+//  PURPOSE:  To return 'stampCorpusFiles()' of the files 'pathCPtr' names,
+//	as 'listCorpusFiles()' lists them, or '0' if it cannot list them.
+extern "C"
+uint64_t	getCorpusStamp	(const char*		pathCPtr
+				)
+{
+  std::vector<std::string>	filenameVector;
+
+  if  (!listCorpusFiles(pathCPtr,filenameVector))
+    return(0);
+
+  return(stampCorpusFiles(filenameVector));
+}
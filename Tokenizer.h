@@ -0,0 +1,260 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Tokenizer.h						---*
+ *---									---*
+ *---	    This file declares the Tokenizer class, which memory-maps	---*
+ *---	a file and hands out its words as views into the mapping.  It	---*
+ *---	can also map several files one after the other, with at least	---*
+ *---	one '\0' between each and the next, so that their words read as	---*
+ *---	one stream and offsets into it work as for one file.		---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	<stdint.h>
+#include	<vector>
+#include	<string>
+
+
+//  PURPOSE:  To tell the most threads 'Tokenizer::forEachFile()' runs at
+//	once.
+const int	TOKENIZER_MAX_THREADS	= 64;
+
+
+//  PURPOSE:  To be called by 'Tokenizer::forEachFile()' for mapped file
+//	number 'fileIndex', with the 'taskPtr' given to it.
+typedef	void	(*FileTask)	(void*		taskPtr,
+				 int		fileIndex
+				);
+
+
+class	Tokenizer
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To point to the start of the mapped file, or 'NULL' if no file
+  //	(or an empty one) is mapped.
+  const char*	textPtr_;
+
+  //  PURPOSE:  To tell the length of the mapped file, or of the mapped files
+  //	from the start of the first to the end of the last.
+  size_t	textLen_;
+
+  //  PURPOSE:  To tell the number of bytes mapped at 'textPtr_', which may
+  //	go on past 'textLen_' to the end of a page.
+  size_t	mapLen_;
+
+  //  PURPOSE:  To hold, at 'i', the offset at which mapped file 'i' starts.
+  std::vector<size_t>	fileStartVector_;
+
+  //  PURPOSE:  To hold, at 'i', the length of mapped file 'i'.
+  std::vector<size_t>	fileLenVector_;
+
+  //  PURPOSE:  To tell the offset in the file at which to look for the next
+  //	word.
+  size_t	position_;
+
+  //  PURPOSE:  To hold non-zero for each byte value that separates words,
+  //	as listed by 'SEPARATORY_CHAR_ARRAY' (plus '\0'), or '0' otherwise.
+  unsigned char	isSeparator_[256];
+
+
+  //  II.  Disallowed auto-generated methods:
+  Tokenizer			(const Tokenizer&
+				);
+
+  Tokenizer&	operator=	(const Tokenizer&
+				);
+
+protected :
+  //  III.  Protected methods:
+
+public :
+  //  IV.  Constructor(s), op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to have no file.  No parameters.
+  Tokenizer			();
+
+  //  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+  //	return value.
+  ~Tokenizer			();
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the start of the mapped file, or 'NULL' if no file
+  //	(or an empty one) is mapped.  No parameters.
+  const char*	getText		()
+				const
+				{
+				  return(textPtr_);
+				}
+
+  //  PURPOSE:  To return the length of the mapped file.  No parameters.
+  size_t	getTextLen	()
+				const
+				{
+				  return(textLen_);
+				}
+
+  //  PURPOSE:  To return the number of mapped files.  No parameters.
+  int		getNumFiles	()
+				const
+				{
+				  return(fileStartVector_.size());
+				}
+
+  //  PURPOSE:  To return the offset at which mapped file 'fileIndex' starts.
+  size_t	getFileStart	(int		fileIndex
+				)
+				const
+				{
+				  return(fileStartVector_[fileIndex]);
+				}
+
+  //  PURPOSE:  To return the length of mapped file 'fileIndex'.
+  size_t	getFileLen	(int		fileIndex
+				)
+				const
+				{
+				  return(fileLenVector_[fileIndex]);
+				}
+
+  //  PURPOSE:  To return the offset in the file at which the next word is
+  //	looked for.  No parameters.
+  size_t	getPosition	()
+				const
+				{
+				  return(position_);
+				}
+
+  //  PURPOSE:  To return 'true' if byte 'c' separates words, or 'false'
+  //	otherwise.
+  bool		isSeparator	(char		c
+				)
+				const
+				{
+				  return(isSeparator_[(unsigned char)c] != 0);
+				}
+
+  //  PURPOSE:  To set '*wordCPtrPtr' to the address of the first word at or
+  //	after offset '*positionPtr' and before offset 'endPosition',
+  //	'*wordLenPtr' to its length and '*positionPtr' to just past it.  Only
+  //	reads '*this', so threads may scan different parts of it at once.
+  //	Returns 'true' on success, or 'false' (with '*positionPtr' at
+  //	'endPosition') if there are no more words before 'endPosition'.
+  bool		scanWordIn	(size_t*	positionPtr,
+				 size_t		endPosition,
+				 const char**	wordCPtrPtr,
+				 int*		wordLenPtr
+				)
+				const
+				{
+				  const char*	endPtr	= textPtr_ + endPosition;
+				  const char*	cPtr	= textPtr_ + *positionPtr;
+
+				  while  ( (cPtr < endPtr)  &&  isSeparator(*cPtr) )
+				    cPtr++;
+
+				  const char*	wordCPtr	= cPtr;
+
+				  while  ( (cPtr < endPtr)  &&  !isSeparator(*cPtr) )
+				    cPtr++;
+
+				  *positionPtr	= cPtr - textPtr_;
+
+				  if  (cPtr == wordCPtr)
+				    return(false);
+
+				  *wordCPtrPtr	= wordCPtr;
+				  *wordLenPtr	= cPtr - wordCPtr;
+				  return(true);
+				}
+
+  //  PURPOSE:  To call '(*task)(taskPtr,i)' once for each mapped file 'i',
+  //	on as many threads at once as there are CPUs (but no more than
+  //	'TOKENIZER_MAX_THREADS' or the number of files), each of which takes
+  //	the next file no thread has taken yet.  Returns once every call has.
+  //	No return value.
+  void		forEachFile	(FileTask	task,
+				 void*		taskPtr
+				)
+				const;
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To memory-map file 'filenameCPtr' read-only and start at its
+  //	beginning.  Returns 'true' on success or 'false' otherwise.
+  bool		open		(const char*	filenameCPtr
+				);
+
+  //  PURPOSE:  To memory-map the files named in 'filenameVector' read-only,
+  //	one after the other, and start at the beginning of the first.
+  //	Returns 'true' on success or 'false' otherwise.
+  bool		open		(const std::vector<std::string>&
+						filenameVector
+				);
+
+  //  PURPOSE:  To make the next word be looked for at offset 'position'.  No
+  //	return value.
+  void		setPosition	(size_t		position
+				)
+				{
+				  position_	= (position < textLen_) ? position : textLen_;
+				}
+
+  //  PURPOSE:  To set '*wordCPtrPtr' to the address of the next word in the
+  //	file and '*wordLenPtr' to its length.  The word is not '\0'-terminated
+  //	and stays valid as long as '*this' does.  Returns 'true' on success,
+  //	or 'false' (and moves to the end of file) if there are no more words
+  //	before the end of file.
+  bool		scanWord	(const char**	wordCPtrPtr,
+				 int*		wordLenPtr
+				)
+				{
+				  return(scanWordIn(&position_,textLen_,wordCPtrPtr,wordLenPtr));
+				}
+
+  //  PURPOSE:  To set '*wordCPtrPtr' to the address of the next word in the
+  //	file and '*wordLenPtr' to its length, as 'scanWord()' does, except
+  //	that at end of file it wraps to the beginning of the file.  Returns
+  //	'true' on success, or 'false' if the file has no words.
+  bool		getNextWord	(const char**	wordCPtrPtr,
+				 int*		wordLenPtr
+				)
+				{
+				  if  (scanWord(wordCPtrPtr,wordLenPtr))
+				    return(true);
+
+				  position_	= 0;
+				  return(scanWord(wordCPtrPtr,wordLenPtr));
+				}
+
+};
+
+
+//  PURPOSE:  To set 'filenameVector' to the names of the files that
+//	'pathCPtr' names, in the order their words are read: the file itself;
+//	or, if it is a directory, the files in it and in the directories
+//	under it, sorted by path, leaving out hidden ones and word-offset
+//	indices; or, if it is "@listFile", the files named by the lines of
+//	'listFile'.  Returns 'true' on success or 'false' if 'pathCPtr'
+//	cannot be read.
+extern
+bool		listCorpusFiles	(const char*		pathCPtr,
+				 std::vector<std::string>&
+							filenameVector
+				);
+
+//  PURPOSE:  To return a number that changes whenever a file is added to or
+//	removed from 'filenameVector', or one of them is replaced or changed,
+//	judging by their names, devices, inodes, sizes and modification
+//	times.
+extern
+uint64_t	stampCorpusFiles(const std::vector<std::string>&
+							filenameVector
+				);
+
+//  PURPOSE:  To return 'stampCorpusFiles()' of the files 'pathCPtr' names,
+//	as 'listCorpusFiles()' lists them, or '0' if it cannot list them.
+extern "C"
+uint64_t	getCorpusStamp	(const char*		pathCPtr
+				);
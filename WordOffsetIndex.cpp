@@ -0,0 +1,292 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		WordOffsetIndex.cpp					---*
+ *---									---*
+ *---	    This file defines the methods of class WordOffsetIndex.	---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"header.h"
+#include	<vector>
+#include	<algorithm>	// For std::upper_bound()
+#include	"Tokenizer.h"
+#include	"WordOffsetIndex.h"
+
+
+//  PURPOSE:  To hold the index of one file while it is loaded or made: its
+//	number of words, and the offset in the file (not in the stream of the
+//	Tokenizer) of its word 'i * WORD_INDEX_INTERVAL' at 'i'.
+struct		WordIndexPart
+{
+  uint64_t		numWords;
+  std::vector<uint64_t>	checkpointVector;
+  bool			isOk;
+};
+
+
+//  PURPOSE:  To hold what the threads of one 'loadOrBuild()' share: the
+//	files, the Tokenizer that mapped them and the index of each.
+struct		WordIndexBuild
+{
+  const std::vector<std::string>*	filenameVectorPtr;
+  const Tokenizer*			tokenizerPtr;
+  std::vector<WordIndexPart>		partVector;
+};
+
+
+//  PURPOSE:  To return 'true' if 'header' describes an index made with
+//	interval 'WORD_INDEX_INTERVAL' for a file like 'statBuffer' describes,
+//	or 'false' otherwise.
+static
+bool		isCurrent	(const WordIndexHeader&	header,
+				 const struct stat&	statBuffer
+				)
+{
+  return( (memcmp(header.magic,WORD_INDEX_MAGIC,sizeof(header.magic)) == 0)	&&
+	  (header.fileSize  == (uint64_t)statBuffer.st_size)			&&
+	  (header.mtimeSec  == (int64_t)statBuffer.st_mtim.tv_sec)		&&
+	  (header.mtimeNsec == (int64_t)statBuffer.st_mtim.tv_nsec)		&&
+	  (header.interval  == WORD_INDEX_INTERVAL)				&&
+	  (header.numCheckpoints == (header.totalWords + header.interval - 1) / header.interval)
+	);
+}
+
+
+//  PURPOSE:  To attempt to read the index file 'indexNameCPtr' into
+//	'part', checking that it was made for a file like 'statBuffer'
+//	describes.  Returns 'true' on success or 'false' otherwise.
+bool		WordOffsetIndex::load
+				(const char*		indexNameCPtr,
+				 const struct stat&	statBuffer,
+				 WordIndexPart&		part
+				)
+{
+  FILE*			filePtr	= fopen(indexNameCPtr,"r");
+  WordIndexHeader	header;
+  bool			isOk	= false;
+
+  if  (filePtr == NULL)
+    return(false);
+
+  if  ( (fread(&header,sizeof(header),1,filePtr) == 1)  &&
+	isCurrent(header,statBuffer)
+      )
+  {
+    part.checkpointVector.resize(header.numCheckpoints);
+
+    if  ( (header.numCheckpoints == 0)  ||
+	  (fread(&part.checkpointVector[0],sizeof(uint64_t),header.numCheckpoints,filePtr)
+		== header.numCheckpoints
+	  )
+	)
+    {
+      part.numWords	= header.totalWords;
+      isOk		= true;
+    }
+    else
+      part.checkpointVector.clear();
+  }
+
+  fclose(filePtr);
+  return(isOk);
+}
+
+
+//  PURPOSE:  To make the index 'part' of mapped file 'fileIndex' of
+//	'tokenizer' by tokenizing all of it once.  No return value.
+void		WordOffsetIndex::build
+				(const Tokenizer&	tokenizer,
+				 int			fileIndex,
+				 WordIndexPart&		part
+				)
+{
+  const char*	wordCPtr;
+  int		wordLen;
+  size_t	fileStart	= tokenizer.getFileStart(fileIndex);
+  size_t	fileEnd		= fileStart + tokenizer.getFileLen(fileIndex);
+  size_t	position	= fileStart;
+
+  part.checkpointVector.clear();
+  part.numWords	= 0;
+
+  while  (tokenizer.scanWordIn(&position,fileEnd,&wordCPtr,&wordLen))
+  {
+    if  (part.numWords % WORD_INDEX_INTERVAL == 0)
+      part.checkpointVector.push_back(position - wordLen - fileStart);
+
+    part.numWords++;
+  }
+}
+
+
+//  PURPOSE:  To attempt to write 'part' to index file 'indexNameCPtr' for
+//	a file like 'statBuffer' describes.  Writes to a temporary file first
+//	and renames it, so readers never see half an index.  Returns 'true'
+//	on success or 'false' otherwise.
+bool		WordOffsetIndex::save
+				(const char*		indexNameCPtr,
+				 const struct stat&	statBuffer,
+				 const WordIndexPart&	part
+				)
+{
+  WordIndexHeader	header;
+  std::vector<char>	tmpName(strlen(indexNameCPtr) + BUFFER_LEN);
+
+  memset(&header,'\0',sizeof(header));
+  memcpy(header.magic,WORD_INDEX_MAGIC,sizeof(header.magic));
+  header.fileSize	= statBuffer.st_size;
+  header.mtimeSec	= statBuffer.st_mtim.tv_sec;
+  header.mtimeNsec	= statBuffer.st_mtim.tv_nsec;
+  header.totalWords	= part.numWords;
+  header.numCheckpoints	= part.checkpointVector.size();
+  header.interval	= WORD_INDEX_INTERVAL;
+
+  snprintf(&tmpName[0],tmpName.size(),"%s.%d",indexNameCPtr,(int)getpid());
+
+  FILE*	filePtr	= fopen(&tmpName[0],"w");
+
+  if  (filePtr == NULL)
+    return(false);
+
+  bool	isOk	= (fwrite(&header,sizeof(header),1,filePtr) == 1)  &&
+		  ( part.checkpointVector.empty()  ||
+		    (fwrite(&part.checkpointVector[0],sizeof(uint64_t),part.checkpointVector.size(),filePtr)
+			== part.checkpointVector.size()
+		    )
+		  );
+
+  isOk	= (fclose(filePtr) == 0)  &&  isOk;
+
+  if  ( !isOk  ||  (rename(&tmpName[0],indexNameCPtr) < 0) )
+  {
+    unlink(&tmpName[0]);
+    return(false);
+  }
+
+  return(true);
+}
+
+
+//  PURPOSE:  To load or make the index of one file, as 'loadOrBuild()'
+//	does, for the 'WordIndexBuild' that 'vPtr' points to.  Called by
+//	'Tokenizer::forEachFile()' for file 'fileIndex'.  No return value.
+void		WordOffsetIndex::loadOrBuildFile
+				(void*			vPtr,
+				 int			fileIndex
+				)
+{
+  WordIndexBuild*	buildPtr	= (WordIndexBuild*)vPtr;
+  const std::string&	filename	= (*buildPtr->filenameVectorPtr)[fileIndex];
+  WordIndexPart&	part		= buildPtr->partVector[fileIndex];
+  struct stat		statBuffer;
+  std::string		indexName	= filename + WORD_INDEX_SUFFIX;
+
+  part.isOk	= (stat(filename.c_str(),&statBuffer) == 0);
+
+  if  (!part.isOk)
+    return;
+
+  //  An index is only saved if the file did not change since the
+  //  tokenizer mapped it:
+  if  ((uint64_t)statBuffer.st_size != buildPtr->tokenizerPtr->getFileLen(fileIndex))
+    build(*buildPtr->tokenizerPtr,fileIndex,part);
+  else
+  if  (!load(indexName.c_str(),statBuffer,part))
+  {
+    build(*buildPtr->tokenizerPtr,fileIndex,part);
+    save(indexName.c_str(),statBuffer,part);
+  }
+}
+
+
+//  PURPOSE:  To move 'tokenizer' so that its next word is word number
+//	'wordIndex' (modulo the number of words) of all the files.  Tokenizes
+//	at most 'interval_-1' words.  Returns 'true' on success, or 'false'
+//	if the files have no words.
+bool		WordOffsetIndex::seek
+				(Tokenizer&		tokenizer,
+				 uint64_t		wordIndex
+				)
+				const
+{
+  if  (totalWords_ == 0)
+    return(false);
+
+  //  The word is in the last file that starts at or before it (files with
+  //  no words start where the next one does, so they are passed over):
+  wordIndex	%= totalWords_;
+
+  size_t	fileIndex	= std::upper_bound(fileFirstWordVector_.begin(),
+						   fileFirstWordVector_.end(),
+						   wordIndex
+						  )
+				  - fileFirstWordVector_.begin() - 1;
+
+  wordIndex	-= fileFirstWordVector_[fileIndex];
+  tokenizer.setPosition(checkpointVector_[fileFirstCheckpointVector_[fileIndex] + wordIndex / interval_]);
+
+  for  (uint64_t toSkip = wordIndex % interval_;  toSkip > 0;  toSkip--)
+  {
+    const char*	wordCPtr;
+    int		wordLen;
+
+    tokenizer.scanWord(&wordCPtr,&wordLen);
+  }
+
+  return(true);
+}
+
+
+//  PURPOSE:  To load the index of each file of 'filenameVector', whose
+//	words are given by 'tokenizer', from its sidecar file.  If there is
+//	none, or it was made for a different size or modification time of
+//	the file, then makes it and tries to save it for next time.  The
+//	files are done in parallel.  'tokenizer' must already have mapped
+//	the files.  Returns 'true' on success or 'false' if a file cannot be
+//	'stat()'ed.
+bool		WordOffsetIndex::loadOrBuild
+				(const std::vector<std::string>&
+							filenameVector,
+				 Tokenizer&		tokenizer
+				)
+{
+  //  I.  Load or make the index of each file:
+  WordIndexBuild	build;
+
+  if  ((size_t)tokenizer.getNumFiles() != filenameVector.size())
+    return(false);
+
+  build.filenameVectorPtr	= &filenameVector;
+  build.tokenizerPtr		= &tokenizer;
+  build.partVector.resize(filenameVector.size());
+  tokenizer.forEachFile(loadOrBuildFile,&build);
+
+  //  II.  Lay them end to end, with their offsets in the stream:
+  totalWords_	= 0;
+  interval_	= WORD_INDEX_INTERVAL;
+  checkpointVector_.clear();
+  fileFirstWordVector_.clear();
+  fileFirstCheckpointVector_.clear();
+
+  for  (size_t i = 0;  i < build.partVector.size();  i++)
+  {
+    const WordIndexPart&	part	= build.partVector[i];
+
+    if  (!part.isOk)
+      return(false);
+
+    fileFirstWordVector_.push_back(totalWords_);
+    fileFirstCheckpointVector_.push_back(checkpointVector_.size());
+
+    for  (size_t j = 0;  j < part.checkpointVector.size();  j++)
+      checkpointVector_.push_back(tokenizer.getFileStart(i) + part.checkpointVector[j]);
+
+    totalWords_	+= part.numWords;
+  }
+
+  return(true);
+}
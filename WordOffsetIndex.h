@@ -0,0 +1,162 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		WordOffsetIndex.h					---*
+ *---									---*
+ *---	    This file declares the WordOffsetIndex class, a sidecar	---*
+ *---	index of the byte offset of every Kth word of a file, so that	---*
+ *---	a word index can be reached without tokenizing the whole	---*
+ *---	prefix of the file.  For several files mapped as one stream by	---*
+ *---	Tokenizer, each file has an index of its own, made in parallel	---*
+ *---	with the others', and the number of words of each tells which	---*
+ *---	file a word index falls in.					---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	<stdint.h>
+
+
+//  PURPOSE:  To tell the number of words between two checkpoints.
+const uint32_t	WORD_INDEX_INTERVAL	= 4096;
+
+//  PURPOSE:  To tell the ending added to a file's name to name its index.
+#define		WORD_INDEX_SUFFIX	".idx"
+
+//  PURPOSE:  To tell the first bytes of every index file.
+#define		WORD_INDEX_MAGIC	"WHIDX01"
+
+
+//  PURPOSE:  To hold the index of one file while it is loaded or made.
+struct		WordIndexPart;
+
+
+//  PURPOSE:  To hold the start of an index file.  It is followed by
+//	'numCheckpoints' 'uint64_t' byte offsets, the 'i'th of which is the
+//	offset of word 'i * interval'.
+struct		WordIndexHeader
+{
+  char		magic[8];
+  uint64_t	fileSize;
+  int64_t	mtimeSec;
+  int64_t	mtimeNsec;
+  uint64_t	totalWords;
+  uint64_t	numCheckpoints;
+  uint32_t	interval;
+  uint32_t	reserved;
+};
+
+
+class	WordOffsetIndex
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To tell the number of words in all the files.
+  uint64_t		totalWords_;
+
+  //  PURPOSE:  To tell the number of words between two checkpoints.
+  uint32_t		interval_;
+
+  //  PURPOSE:  To hold the checkpoints of each file, one file after the
+  //	other.  The 'i'th of a file is the offset in the stream of the
+  //	Tokenizer of its word 'i * interval_'.
+  std::vector<uint64_t>	checkpointVector_;
+
+  //  PURPOSE:  To hold, at 'i', the index of the first word of file 'i'.
+  std::vector<uint64_t>	fileFirstWordVector_;
+
+  //  PURPOSE:  To hold, at 'i', the index in 'checkpointVector_' of the
+  //	first checkpoint of file 'i'.
+  std::vector<uint64_t>	fileFirstCheckpointVector_;
+
+
+  //  II.  Disallowed auto-generated methods:
+  WordOffsetIndex		(const WordOffsetIndex&
+				);
+
+  WordOffsetIndex&
+		operator=	(const WordOffsetIndex&
+				);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To attempt to read the index file 'indexNameCPtr' into
+  //	'part', checking that it was made for a file like 'statBuffer'
+  //	describes.  Returns 'true' on success or 'false' otherwise.
+  static
+  bool		load		(const char*		indexNameCPtr,
+				 const struct stat&	statBuffer,
+				 WordIndexPart&		part
+				);
+
+  //  PURPOSE:  To make the index 'part' of mapped file 'fileIndex' of
+  //	'tokenizer' by tokenizing all of it once.  No return value.
+  static
+  void		build		(const Tokenizer&	tokenizer,
+				 int			fileIndex,
+				 WordIndexPart&		part
+				);
+
+  //  PURPOSE:  To attempt to write 'part' to index file 'indexNameCPtr' for
+  //	a file like 'statBuffer' describes.  Writes to a temporary file first
+  //	and renames it, so readers never see half an index.  Returns 'true'
+  //	on success or 'false' otherwise.
+  static
+  bool		save		(const char*		indexNameCPtr,
+				 const struct stat&	statBuffer,
+				 const WordIndexPart&	part
+				);
+
+  //  PURPOSE:  To load or make the index of one file, as 'loadOrBuild()'
+  //	does, for the 'WordIndexBuild' that 'vPtr' points to.  Called by
+  //	'Tokenizer::forEachFile()' for file 'fileIndex'.  No return value.
+  static
+  void		loadOrBuildFile	(void*			vPtr,
+				 int			fileIndex
+				);
+
+public :
+  //  IV.  Constructor(s), op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to an empty index.  No parameters.
+  WordOffsetIndex		() :
+				totalWords_(0),
+				interval_(WORD_INDEX_INTERVAL)
+				{ }
+
+  //  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+  //	return value.
+  ~WordOffsetIndex		()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of words in all the files.  No
+  //	parameters.
+  uint64_t	getTotalWords	()
+				const
+				{
+				  return(totalWords_);
+				}
+
+  //  PURPOSE:  To move 'tokenizer' so that its next word is word number
+  //	'wordIndex' (modulo the number of words) of all the files.  Tokenizes
+  //	at most 'interval_-1' words.  Returns 'true' on success, or 'false'
+  //	if the files have no words.
+  bool		seek		(Tokenizer&		tokenizer,
+				 uint64_t		wordIndex
+				)
+				const;
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To load the index of each file of 'filenameVector', whose
+  //	words are given by 'tokenizer', from its sidecar file.  If there is
+  //	none, or it was made for a different size or modification time of
+  //	the file, then makes it and tries to save it for next time.  The
+  //	files are done in parallel.  Returns 'true' on success or 'false' if
+  //	a file cannot be 'stat()'ed.
+  bool		loadOrBuild	(const std::vector<std::string>&
+							filenameVector,
+				 Tokenizer&		tokenizer
+				);
+
+};
@@ -0,0 +1,276 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		WordRing.h						---*
+ *---									---*
+ *---	    This file declares the WordBatch struct and the WordRing	---*
+ *---	class, a single-producer/single-consumer ring of word batches	---*
+ *---	used to hand words from the reading thread to a counting	---*
+ *---	thread.								---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	<atomic>
+#include	<pthread.h>	// For pthread_cond_wait()
+#include	<sched.h>	// For sched_yield()
+
+
+//  PURPOSE:  To tell the most words one batch holds.
+const int	WORD_BATCH_MAX_WORDS	= 1024;
+
+//  PURPOSE:  To tell the number of bytes of word text one batch holds.
+const int	WORD_BATCH_TEXT_LEN	= WORD_BATCH_MAX_WORDS * 8;
+
+//  PURPOSE:  To tell the number of batches in one ring.  Must be a power of 2.
+const unsigned	WORD_RING_LEN		= 8;
+
+//  PURPOSE:  To tell the most times a thread yields the CPU while the ring
+//	is full (or empty) before it sleeps until the other thread wakes it.
+//	A batch takes long enough to fill or count that a short wait is
+//	mostly over within this many, so a syscall is then rarely needed.
+const int	WORD_RING_MAX_SPINS	= 64;
+
+
+//  PURPOSE:  To hold a block of words owned by the batch itself.  Word 'i'
+//	is the 'lenArray[i]' chars starting at 'text + startArray[i]'.
+struct		WordBatch
+{
+  int		numWords;
+  int		textLen;
+  int		startArray[WORD_BATCH_MAX_WORDS];
+  unsigned char	lenArray[WORD_BATCH_MAX_WORDS];
+  char		text[WORD_BATCH_TEXT_LEN];
+
+  //  PURPOSE:  To make '*this' empty.  No parameters.  No return value.
+  void		clear		()
+				{
+				  numWords	= 0;
+				  textLen	= 0;
+				}
+
+  //  PURPOSE:  To return 'true' if '*this' can take another word of up to
+  //	'BUFFER_LEN-1' chars, or 'false' otherwise.  No parameters.
+  bool		hasRoom		()
+				const
+				{
+				  return( (numWords < WORD_BATCH_MAX_WORDS)  &&
+					  (textLen + BUFFER_LEN <= WORD_BATCH_TEXT_LEN)
+					);
+				}
+
+  //  PURPOSE:  To copy into '*this' word 'wordCPtr', truncated to
+  //	'BUFFER_LEN-1' chars.  '*this' must have room.  No return value.
+  void		add		(const char*	wordCPtr
+				)
+				{
+				  add(wordCPtr,strnlen(wordCPtr,BUFFER_LEN-1));
+				}
+
+  //  PURPOSE:  To copy into '*this' the 'wordLen' chars at 'wordCPtr',
+  //	truncated to 'BUFFER_LEN-1' chars.  '*this' must have room.  No
+  //	return value.
+  void		add		(const char*	wordCPtr,
+				 int		wordLen
+				)
+				{
+				  if  (wordLen > BUFFER_LEN-1)
+				    wordLen	= BUFFER_LEN-1;
+
+				  memcpy(text+textLen,wordCPtr,wordLen);
+				  startArray[numWords]	= textLen;
+				  lenArray[numWords]	= wordLen;
+				  numWords++;
+				  textLen	+= wordLen;
+				}
+};
+
+
+class	WordRing
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To hold the batches.
+  WordBatch	batchArray_[WORD_RING_LEN];
+
+  //  PURPOSE:  To count the batches published so far.  Only written by the
+  //	producer.
+  std::atomic<unsigned>	head_;
+
+  //  PURPOSE:  To count the batches released so far.  Only written by the
+  //	consumer.
+  std::atomic<unsigned>	tail_;
+
+  //  PURPOSE:  To hold 'true' once the producer will publish no more
+  //	batches, or 'false' otherwise.
+  std::atomic<bool>	isDone_;
+
+  //  PURPOSE:  To hold 'true' while the producer sleeps on 'wakeCond_' until
+  //	the ring is not full, or 'false' otherwise.
+  std::atomic<bool>	isProducerAsleep_;
+
+  //  PURPOSE:  To hold 'true' while the consumer sleeps on 'wakeCond_' until
+  //	the ring is not empty, or 'false' otherwise.
+  std::atomic<bool>	isConsumerAsleep_;
+
+  //  PURPOSE:  To guard the sleeping on 'wakeCond_'.  It is taken only by a
+  //	thread that is about to sleep or that wakes one that is.
+  pthread_mutex_t	wakeLock_;
+
+  //  PURPOSE:  To wake the producer or consumer sleeping on it.
+  pthread_cond_t	wakeCond_;
+
+
+  //  II.  Disallowed auto-generated methods:
+  WordRing			(const WordRing&
+				);
+
+  WordRing&	operator=	(const WordRing&
+				);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To wake the other thread if '*isAsleepPtr' tells it sleeps.
+  //	The caller's last store and this load are both sequentially
+  //	consistent, so either the other thread sees the store before it
+  //	sleeps or this sees that it sleeps.  No return value.
+  void		wake		(std::atomic<bool>*	isAsleepPtr
+				)
+				{
+				  if  (isAsleepPtr->load())
+				  {
+				    pthread_mutex_lock(&wakeLock_);
+				    pthread_cond_broadcast(&wakeCond_);
+				    pthread_mutex_unlock(&wakeLock_);
+				  }
+				}
+
+public :
+  //  IV.  Constructor(s), op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to an empty ring.  No parameters.
+  WordRing			() :
+				head_(0),
+				tail_(0),
+				isDone_(false),
+				isProducerAsleep_(false),
+				isConsumerAsleep_(false)
+				{
+				  pthread_mutex_init(&wakeLock_,NULL);
+				  pthread_cond_init(&wakeCond_,NULL);
+				}
+
+  //  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+  //	return value.
+  ~WordRing			()
+				{
+				  pthread_cond_destroy(&wakeCond_);
+				  pthread_mutex_destroy(&wakeLock_);
+				}
+
+  //  V.  Accessors:
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To be called by the producer to get the next batch to fill,
+  //	waiting while the ring is full: first yielding the CPU up to
+  //	'WORD_RING_MAX_SPINS' times, and then sleeping until the consumer
+  //	releases a batch.  The batch is returned empty.  No parameters.
+  WordBatch*	getEmptyBatch	()
+				{
+				  unsigned	head	= head_.load(std::memory_order_relaxed);
+
+				  for  (int spins = 0;
+					head - tail_.load(std::memory_order_acquire) == WORD_RING_LEN;
+					spins++
+				       )
+				  {
+				    if  (spins < WORD_RING_MAX_SPINS)
+				    {
+				      sched_yield();
+				      continue;
+				    }
+
+				    pthread_mutex_lock(&wakeLock_);
+				    isProducerAsleep_.store(true);
+
+				    while  (head - tail_.load() == WORD_RING_LEN)
+				      pthread_cond_wait(&wakeCond_,&wakeLock_);
+
+				    isProducerAsleep_.store(false);
+				    pthread_mutex_unlock(&wakeLock_);
+				  }
+
+				  WordBatch*	batchPtr = &batchArray_[head & (WORD_RING_LEN-1)];
+
+				  batchPtr->clear();
+				  return(batchPtr);
+				}
+
+  //  PURPOSE:  To be called by the producer to hand the batch last returned
+  //	by 'getEmptyBatch()' to the consumer.  No parameters.  No return
+  //	value.
+  void		publish		()
+				{
+				  head_.store(head_.load(std::memory_order_relaxed) + 1);
+				  wake(&isConsumerAsleep_);
+				}
+
+  //  PURPOSE:  To be called by the producer after its last 'publish()'.  No
+  //	parameters.  No return value.
+  void		finish		()
+				{
+				  isDone_.store(true);
+				  wake(&isConsumerAsleep_);
+				}
+
+  //  PURPOSE:  To be called by the consumer to get the next full batch,
+  //	waiting while the ring is empty, as 'getEmptyBatch()' waits while it
+  //	is full.  Returns 'NULL' once the producer has finished and every
+  //	batch has been consumed.  No parameters.
+  const WordBatch*
+		getFullBatch	()
+				{
+				  unsigned	tail	= tail_.load(std::memory_order_relaxed);
+
+				  for  (int spins = 0;
+					head_.load(std::memory_order_acquire) == tail;
+					spins++
+				       )
+				  {
+				    if  (isDone_.load(std::memory_order_acquire))
+				    {
+				      if  (head_.load(std::memory_order_acquire) == tail)
+					return(NULL);
+
+				      break;
+				    }
+
+				    if  (spins < WORD_RING_MAX_SPINS)
+				    {
+				      sched_yield();
+				      continue;
+				    }
+
+				    pthread_mutex_lock(&wakeLock_);
+				    isConsumerAsleep_.store(true);
+
+				    while  ( (head_.load() == tail)  &&  !isDone_.load() )
+				      pthread_cond_wait(&wakeCond_,&wakeLock_);
+
+				    isConsumerAsleep_.store(false);
+				    pthread_mutex_unlock(&wakeLock_);
+				  }
+
+				  return(&batchArray_[tail & (WORD_RING_LEN-1)]);
+				}
+
+  //  PURPOSE:  To be called by the consumer to give the batch last returned
+  //	by 'getFullBatch()' back to the producer.  No parameters.  No return
+  //	value.
+  void		release		()
+				{
+				  tail_.store(tail_.load(std::memory_order_relaxed) + 1);
+				  wake(&isProducerAsleep_);
+				}
+
+};
@@ -0,0 +1,189 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		WordTable.cpp						---*
+ *---									---*
+ *---	    This file defines the methods of class WordTable.		---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"header.h"
+#include	<algorithm>
+#include	"Arena.h"
+#include	"Histogram.h"
+#include	"WordTable.h"
+
+
+//  PURPOSE:  To initialize '*this' to an empty table.  No parameters.
+WordTable::WordTable		() :
+				slotArray_((WordSlot*)calloc(WORD_TABLE_INIT_CAPACITY,sizeof(WordSlot))),
+				capacity_(WORD_TABLE_INIT_CAPACITY),
+				numDistinct_(0),
+				isTrackingDirty_(false)
+{
+  if  (slotArray_ == NULL)
+  {
+    fprintf(stderr,"Out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+
+//  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+//	return value.
+WordTable::~WordTable		()
+{
+  free(slotArray_);
+}
+
+
+//  PURPOSE:  To double the number of slots and re-place every word.  No
+//	parameters.  No return value.
+void		WordTable::grow	()
+{
+  int		newCapacity	= 2 * capacity_;
+  unsigned int	mask		= newCapacity - 1;
+  WordSlot*	newArray	= (WordSlot*)calloc(newCapacity,sizeof(WordSlot));
+
+  if  (newArray == NULL)
+  {
+    fprintf(stderr,"Out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+
+  //  The dirty slots move too:
+  dirtyVector_.clear();
+
+  for  (int i = 0;  i < capacity_;  i++)
+  {
+    if  (slotArray_[i].wordCPtr == NULL)
+      continue;
+
+    unsigned int	index	= slotArray_[i].hash & mask;
+
+    while  (newArray[index].wordCPtr != NULL)
+      index	= (index + 1) & mask;
+
+    newArray[index]	= slotArray_[i];
+
+    if  (newArray[index].isDirty)
+      dirtyVector_.push_back(index);
+  }
+
+  free(slotArray_);
+  slotArray_	= newArray;
+  capacity_	= newCapacity;
+}
+
+
+//  PURPOSE:  To append to 'entryVector' one entry per distinct word, in the
+//	order of their slots.  No return value.
+void		WordTable::getUnsorted
+				(std::vector<WordCount>&	entryVector
+				)
+				const
+{
+  entryVector.reserve(entryVector.size() + numDistinct_);
+
+  for  (int i = 0;  i < capacity_;  i++)
+  {
+    if  (slotArray_[i].wordCPtr == NULL)
+      continue;
+
+    WordCount	entry;
+
+    entry.wordCPtr	= slotArray_[i].wordCPtr;
+    entry.wordLen	= slotArray_[i].wordLen;
+    entry.count		= slotArray_[i].count;
+    entryVector.push_back(entry);
+  }
+}
+
+
+//  PURPOSE:  To append to 'entryVector' one entry per distinct word, sorted
+//	the way 'strcmp()' orders the words.  No return value.
+void		WordTable::getSorted
+				(std::vector<WordCount>&	entryVector
+				)
+				const
+{
+  size_t	first	= entryVector.size();
+
+  getUnsorted(entryVector);
+  std::sort(entryVector.begin()+first,entryVector.end(),isWordBefore);
+}
+
+
+//  PURPOSE:  To return the slot of the 'wordLen' chars at 'wordCPtr',
+//	interning them into a new slot with count '0' on first sight.
+WordSlot&	WordTable::findSlot
+				(const char*	wordCPtr,
+				 int		wordLen
+				)
+{
+  //  Keep the load factor at or under one half, even with a new word:
+  if  (2 * (numDistinct_ + 1) > capacity_)
+    grow();
+
+  unsigned int	hash	= hashWord(wordCPtr,wordLen);
+  unsigned int	mask	= capacity_ - 1;
+  unsigned int	index	= hash & mask;
+
+  while  (slotArray_[index].wordCPtr != NULL)
+  {
+    WordSlot&	slot	= slotArray_[index];
+
+    if  ( (slot.hash == hash)				&&
+	  (slot.wordLen == wordLen)			&&
+	  (memcmp(slot.wordCPtr,wordCPtr,wordLen) == 0)
+	)
+    {
+      markDirty(index);
+      return(slot);
+    }
+
+    index	= (index + 1) & mask;
+  }
+
+  WordSlot&	slot	= slotArray_[index];
+
+  slot.wordCPtr	= arena_.intern(wordCPtr,wordLen);
+  slot.hash	= hash;
+  slot.wordLen	= wordLen;
+  slot.count	= 0;
+  numDistinct_++;
+  markDirty(index);
+  return(slot);
+}
+
+
+//  PURPOSE:  To append to 'entryVector' one entry, with its current count,
+//	per distinct word whose count changed since the last call (or since
+//	'trackDirty()'), sorted the way 'strcmp()' orders the words, and to
+//	start noting changes afresh.  No return value.
+void		WordTable::getDirty
+				(std::vector<WordCount>&	entryVector
+				)
+{
+  size_t	first	= entryVector.size();
+
+  entryVector.reserve(first + dirtyVector_.size());
+
+  for  (size_t i = 0;  i < dirtyVector_.size();  i++)
+  {
+    WordSlot&	slot	= slotArray_[dirtyVector_[i]];
+    WordCount	entry;
+
+    entry.wordCPtr	= slot.wordCPtr;
+    entry.wordLen	= slot.wordLen;
+    entry.count		= slot.count;
+    slot.isDirty	= 0;
+    entryVector.push_back(entry);
+  }
+
+  dirtyVector_.clear();
+  std::sort(entryVector.begin()+first,entryVector.end(),isWordBefore);
+}
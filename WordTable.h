@@ -0,0 +1,154 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		WordTable.h						---*
+ *---									---*
+ *---	    This file declares the WordTable class, an open-addressing	---*
+ *---	hash table of word counts that is only sorted when read out.	---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To tell the number of slots a new 'WordTable' starts with.  Must
+//	be a power of 2.
+const int	WORD_TABLE_INIT_CAPACITY	= 1024;
+
+
+//  PURPOSE:  To hold one slot of a 'WordTable'.  An empty slot has a 'NULL'
+//	'wordCPtr'.  'isDirty' (which fits in what would be padding) is
+//	non-zero if the count changed since the last 'getDirty()'.
+struct		WordSlot
+{
+  const char*	wordCPtr;
+  unsigned int	hash;
+  int		wordLen;
+  int		count;
+  int		isDirty;
+};
+
+
+class	WordTable : public Histogram
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To hold the interned words of '*this'.
+  Arena		arena_;
+
+  //  PURPOSE:  To point to the array of 'capacity_' slots.
+  WordSlot*	slotArray_;
+
+  //  PURPOSE:  To tell the number of slots in 'slotArray_', a power of 2.
+  int		capacity_;
+
+  //  PURPOSE:  To tell the number of distinct words in '*this'.
+  int		numDistinct_;
+
+  //  PURPOSE:  To be 'true' if '*this' notes which counts changed, or
+  //	'false' otherwise.
+  bool		isTrackingDirty_;
+
+  //  PURPOSE:  To hold the index of each slot whose count changed since the
+  //	last 'getDirty()', if 'isTrackingDirty_'.
+  std::vector<unsigned int>
+		dirtyVector_;
+
+
+  //  II.  Disallowed auto-generated methods:
+  WordTable			(const WordTable&
+				);
+
+  WordTable&	operator=	(const WordTable&
+				);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To double the number of slots and re-place every word.  No
+  //	parameters.  No return value.
+  void		grow		();
+
+  //  PURPOSE:  To return the slot of the 'wordLen' chars at 'wordCPtr',
+  //	interning them into a new slot with count '0' on first sight.  The
+  //	slot is noted as dirty if '*this' is tracking that.
+  WordSlot&	findSlot	(const char*	wordCPtr,
+				 int		wordLen
+				);
+
+  //  PURPOSE:  To note that the count of slot 'index' changes, if '*this'
+  //	is tracking that.  No return value.
+  void		markDirty	(unsigned int	index
+				)
+				{
+				  if  (isTrackingDirty_  &&  !slotArray_[index].isDirty)
+				  {
+				    slotArray_[index].isDirty	= 1;
+				    dirtyVector_.push_back(index);
+				  }
+				}
+
+public :
+  //  IV.  Constructor(s), op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to an empty table.  No parameters.
+  WordTable			();
+
+  //  PURPOSE:  To release the resources of '*this'.  No parameters.  No
+  //	return value.
+  ~WordTable			();
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of distinct words.  No parameters.
+  int		getNumDistinct	()
+				const
+				{
+				  return(numDistinct_);
+				}
+
+  //  PURPOSE:  To append to 'entryVector' one entry per distinct word, in the
+  //	order of their slots, which is quicker than 'getSorted()'.  No return
+  //	value.
+  void		getUnsorted	(std::vector<WordCount>&	entryVector
+				)
+				const;
+
+  //  PURPOSE:  To append to 'entryVector' one entry per distinct word, sorted
+  //	the way 'strcmp()' orders the words.  No return value.
+  void		getSorted	(std::vector<WordCount>&	entryVector
+				)
+				const;
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To start noting which counts change, so that 'getDirty()'
+  //	can tell them.  No parameters.  No return value.
+  void		trackDirty	()
+				{
+				  isTrackingDirty_	= true;
+				}
+
+  //  PURPOSE:  To append to 'entryVector' one entry, with its current count,
+  //	per distinct word whose count changed since the last call (or since
+  //	'trackDirty()'), sorted the way 'strcmp()' orders the words, and to
+  //	start noting changes afresh.  No return value.
+  void		getDirty	(std::vector<WordCount>&	entryVector
+				);
+
+  //  PURPOSE:  To note one more occurrence of the 'wordLen' chars starting at
+  //	'wordCPtr', interning them on first sight.  No return value.
+  void		insert		(const char*	wordCPtr,
+				 int		wordLen
+				)
+				{
+				  findSlot(wordCPtr,wordLen).count++;
+				}
+
+  //  PURPOSE:  To note 'count' more occurrences of the 'wordLen' chars
+  //	starting at 'wordCPtr', interning them on first sight.  No return
+  //	value.
+  void		add		(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
+				)
+				{
+				  findSlot(wordCPtr,wordLen).count += count;
+				}
+
+};
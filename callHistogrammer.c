@@ -10,91 +10,298 @@
  *---									---*
  *-------------------------------------------------------------------------*/
 
-//	Compile with:
-//	$ gcc wordHistogramServer.c callHistogrammer.c -o wordHistogramServer -lpthread
+//	Compiled into wordHistogramServer, see wordHistogramServer.c.
 
 //---		Header file inclusion					---//
 
+#define		_GNU_SOURCE		// For pipe2()
 #include	"header.h"
+#include	"protocol.h"
+#include	"serverMetrics.h"
 
 
-//  PURPOSE:  To make a process that histograms words starting at 'wordIndex'
-//  	and count 'wordCount' words, get the word histogram from that process
-//	and send it back to the client via socket file-descriptor 'toClientFd'.
+//---		Definition of constants:				---//
+
+//  PURPOSE:  To tell the most bytes read from the pipe at once.
+#define		PIPE_READ_LEN		65536
+
+//  PURPOSE:  To tell the length of the count and the word length that start
+//	each entry the histogrammer writes with "--binary".
+#define		PIPE_ENTRY_HEADER_LEN	(sizeof(uint32_t) + sizeof(uint16_t))
+
+
+//---		Definition of types:					---//
+
+//  PURPOSE:  To hold one long-lived "histogrammer --serve" process, which
+//	keeps the file mapped and its index loaded from one request to the
+//	next, the pipes to it, and its "--corpus=path" argument.  Only the
+//	worker that owns it uses it.
+struct		Histogrammer
+{
+  char*		corpusArgCPtr;
+  pid_t		pid;
+  int		toChildFd;
+  int		fromChildFd;
+  uint64_t	version;
+};
+
+
+//---		Definition of functions:				---//
+
+//  PURPOSE:  To read exactly 'len' bytes from 'fd' into 'bytePtr'.  Returns
+//	'1' on success or '0' if 'fd' closed or failed first.
+static
+int		readAll		(int		fd,
+				 char*		bytePtr,
+				 size_t		len
+				)
+{
+  while  (len > 0)
+  {
+    ssize_t	numRead	= read(fd,bytePtr,len);
+
+    if  (numRead < 0)
+    {
+      if  (errno == EINTR)
+	continue;
+
+      return(0);
+    }
+
+    if  (numRead == 0)
+      return(0);
+
+    bytePtr	+= numRead;
+    len		-= numRead;
+  }
+
+  return(1);
+}
+
+
+//  PURPOSE:  To stop the process of '*histogrammerPtr', if it has one, by
+//	closing its pipes, which ends it once it finishes what it is doing.
 //	No return value.
-void		callHistogrammer(int		toClientFd,
-				 int		wordIndex,
-				 int		wordCount
+static
+void		stopHistogrammer(struct Histogrammer*	histogrammerPtr
+				)
+{
+  if  (histogrammerPtr->pid <= 0)
+    return;
+
+  close(histogrammerPtr->toChildFd);
+  close(histogrammerPtr->fromChildFd);
+  waitpid(histogrammerPtr->pid, NULL, 0);
+  histogrammerPtr->pid	= 0;
+}
+
+
+//  PURPOSE:  To start the process of '*histogrammerPtr' on the file as it is
+//	at version 'version', and to wait until it is ready.  Returns '1' on
+//	success or '0' otherwise.
+static
+int		startHistogrammer
+				(struct Histogrammer*	histogrammerPtr,
+				 uint64_t		version
 				)
 {
+  int	parentToChild[2];
   int	childToParent[2];
-  pid_t	childPid;
-  int	endOrErr	= 0;	/
-	
-	//Make the pipe.
-  // AND THEN CHILD
-	if (pipe(childToParent) == -1)
-		exit(-1);
-	///Make a child process.
+  char*	hist_args[]	= {PROGRAM_NAME, "--serve", histogrammerPtr->corpusArgCPtr, NULL};
+
+  //  MAKE THE PIPES (not inherited by the histogrammers other workers start,
+  //  which would keep them open after this one quits)
+  if  (pipe2(parentToChild,O_CLOEXEC) == -1)
+    return(0);
+
+  if  (pipe2(childToParent,O_CLOEXEC) == -1)
+  {
+    close(parentToChild[0]);
+    close(parentToChild[1]);
+    return(0);
+  }
 
-	childPid = fork();
+  //  MAKE A CHILD PROCESS (timed for the metrics until it is ready)
+  uint64_t	startNs	= getNowNs();
+  pid_t		childPid = fork();
 
   if  (childPid == 0)
   {
-    char	wordIndexBuffer[BUFFER_LEN];
-    char	wordCountBuffer[BUFFER_LEN];
-
-	char *hist_args[] = {"./histogrammer", wordIndexBuffer, NULL};
-	///close() unnecessary pipe file descriptor
-
-    //  CLOSE AND RE-DIRECT
-	close(childToParent[0]);	
-	dup2(childToParent[1], 1);
-
-	snprintf(wordIndexBuffer, sizeof(wordIndexBuffer), "%d", wordIndex);
-		
-	//  CALL PROGRAM_NAME WITH COMMAND LINE ARGUMENTS
-	execvp("./histogrammer", hist_args);
-	endOrErr = htonl(-1);
-	*((int *) wordCountBuffer) = endOrErr;
-	wordCountBuffer[4] = '\n';
-	write(childToParent[1], wordCountBuffer, 5);
-	
-    //  HANDLE ERROR CASE
-    exit(EXIT_FAILURE);
+    //  RE-DIRECT ('dup2()' leaves the copies open across 'exec')
+    dup2(parentToChild[0], 0);
+    dup2(childToParent[1], 1);
+
+    //  CALL PROGRAM_NAME, WHICH ANSWERS REQUESTS UNTIL ITS INPUT CLOSES
+    execvp(PROGRAM_NAME, hist_args);
+
+    //  HANDLE ERROR CASE (the parent reads end-of-file)
+    _exit(EXIT_FAILURE);
   }
 
-  //  CLOSE, HANG-OUT, SEND-SIGNAL
+  //  CLOSE THE CHILD'S ENDS
+  close(parentToChild[0]);
   close(childToParent[1]);
-  //dup2(childToParent[0], toClientFd);
-  
-  sleep(wordCount);
-  
-  kill(childPid, SIGINT);
-  
-  char	buffer[BUFFER_LEN];
-  FILE*	inputPtr	= fdopen(childToParent[0],"r");
-
-  while  (fgets(buffer,BUFFER_LEN,inputPtr) != NULL)
+
+  if  (childPid < 0)
   {
-    int		count;
-    char	word[BUFFER_LEN];
+    close(parentToChild[1]);
+    close(childToParent[0]);
+    return(0);
+  }
 
-    word[0]	= '\0';
+  //  WAIT UNTIL IT LOADED ITS CORPUS (or quit, if it could not)
+  char	readyBytes[sizeof(uint32_t)];
 
-    //  PARSE, CONVERT AND SEND TO CLIENT
-    sscanf( buffer, "%d %s", &count, word);
-	count = htonl(count);
-	write(toClientFd, &count, 4);
-	write(toClientFd, word, strlen(word));
-	write(toClientFd, "\n", 1);
+  if  ( !readAll(childToParent[0], readyBytes, sizeof(readyBytes))  ||
+	(getU32(readyBytes) != SERVE_READY_LEN)
+      )
+  {
+    close(parentToChild[1]);
+    close(childToParent[0]);
+    waitpid(childPid, NULL, 0);
+    return(0);
   }
 
-  endOrErr = htonl(0);
-  write(toClientFd, &endOrErr, 4);
-  write(toClientFd, "\n", 1);
-	
- 
-  close(childToParent[1]);
-  wait(NULL);
+  noteLatency(LATENCY_SPAWN, getNowNs() - startNs);
+
+  histogrammerPtr->pid		= childPid;
+  histogrammerPtr->toChildFd	= parentToChild[1];
+  histogrammerPtr->fromChildFd	= childToParent[0];
+  histogrammerPtr->version	= version;
+  return(1);
+}
+
+
+//  PURPOSE:  To return a new histogrammer whose process is started on the
+//	corpus 'corpusPathCPtr' as it is at version 'version', or 'NULL' if
+//	there is no memory.  If the process could not start, it is tried
+//	again at the first call.
+struct Histogrammer*
+		newHistogrammer	(const char*	corpusPathCPtr,
+				 uint64_t	version
+				)
+{
+  struct Histogrammer*	histogrammerPtr	= (struct Histogrammer*)calloc(1,sizeof(struct Histogrammer));
+
+  if  (histogrammerPtr == NULL)
+    return(NULL);
+
+  histogrammerPtr->corpusArgCPtr	= (char*)malloc(strlen("--corpus=") + strlen(corpusPathCPtr) + 1);
+
+  if  (histogrammerPtr->corpusArgCPtr == NULL)
+  {
+    free(histogrammerPtr);
+    return(NULL);
+  }
+
+  sprintf(histogrammerPtr->corpusArgCPtr,"--corpus=%s",corpusPathCPtr);
+  startHistogrammer(histogrammerPtr,version);
+  return(histogrammerPtr);
+}
+
+
+//  PURPOSE:  To have the process of '*histogrammerPtr' histogram 'wordCount'
+//  	words starting at 'wordIndex', and get the word histogram (or only
+//	its 'topK' most frequent words, if 'topK' is not '0') from it, adding
+//	it to '*replyPtr'.  The process is (re)started first if it is not
+//	running or was started on a version of the file other than
+//	'version'.  Returns the status of the reply.
+int		callHistogrammer(struct Histogrammer*	histogrammerPtr,
+				 uint64_t		version,
+				 int			wordIndex,
+				 int			wordCount,
+				 int			topK,
+				 struct Reply*		replyPtr
+				)
+{
+  //  RESTART IF NEEDED
+  if  ( (histogrammerPtr->pid > 0)  &&  (histogrammerPtr->version != version) )
+    stopHistogrammer(histogrammerPtr);
+
+  if  ( (histogrammerPtr->pid <= 0)  &&  !startHistogrammer(histogrammerPtr,version) )
+    return(STATUS_ERROR);
+
+  //  SEND THE REQUEST
+  char		line[3*BUFFER_LEN];
+  int		lineLen	= snprintf(line, sizeof(line), "%d %d %d\n", wordIndex, wordCount, topK);
+  char		lenBytes[sizeof(uint32_t)];
+
+  //  (a line this short goes down a pipe whole)
+  if  ( (write(histogrammerPtr->toChildFd, line, lineLen) != lineLen)	||
+	!readAll(histogrammerPtr->fromChildFd, lenBytes, sizeof(lenBytes))
+      )
+  {
+    //  It quit (or failed to start), so start a new one next time:
+    stopHistogrammer(histogrammerPtr);
+    return(STATUS_ERROR);
+  }
+
+  uint32_t	payloadLeft	= getU32(lenBytes);
+
+  if  (payloadLeft == SERVE_ERROR_LEN)
+    return(STATUS_ERROR);
+
+  //  READ EXACTLY THE PAYLOAD, so the next reply starts where it should.
+  //  The entries come packed, each a count, a word length and the word,
+  //  and are decoded as whole ones arrive.  'len' bytes of the buffer are
+  //  still to be decoded:
+  char		buffer[PIPE_READ_LEN];
+  size_t	len		= 0;
+  int		status		= STATUS_OK;
+
+  while  (payloadLeft > 0)
+  {
+    size_t	toRead	= sizeof(buffer) - len;
+
+    if  (toRead > payloadLeft)
+      toRead	= payloadLeft;
+
+    ssize_t	numRead	= read(histogrammerPtr->fromChildFd, buffer+len, toRead);
+
+    if  (numRead < 0)
+    {
+      if  (errno == EINTR)
+	continue;
+
+      stopHistogrammer(histogrammerPtr);
+      return(STATUS_ERROR);
+    }
+
+    if  (numRead == 0)
+    {
+      stopHistogrammer(histogrammerPtr);
+      return(STATUS_ERROR);
+    }
+
+    len		+= numRead;
+    payloadLeft	-= numRead;
+
+    //  DECODE AND ADD TO REPLY
+    size_t	pos	= 0;
+
+    while  (pos + PIPE_ENTRY_HEADER_LEN <= len)
+    {
+      uint32_t	count	= getU32(buffer+pos);
+      uint16_t	wordLen	= getU16(buffer+pos+sizeof(uint32_t));
+
+      if  (pos + PIPE_ENTRY_HEADER_LEN + wordLen > len)
+	break;
+
+      if  ( (wordLen >= BUFFER_LEN)  ||  ((int32_t)count < 0) )
+	status = STATUS_ERROR;
+      else
+	addReplyEntry(replyPtr, count, buffer+pos+PIPE_ENTRY_HEADER_LEN, wordLen);
+
+      pos	+= PIPE_ENTRY_HEADER_LEN + wordLen;
+    }
+
+    memmove(buffer, buffer+pos, len-pos);
+    len	-= pos;
+  }
+
+  //  A partial entry left over means the payload was not whole:
+  if  (len > 0)
+    status = STATUS_ERROR;
+
+  return(status);
 }
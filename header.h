@@ -36,3 +36,5 @@
 #define		PROGRAM_NAME		"./histogrammer"
 
 #define		FILENAME		"file.txt"
+
+#define		SEPARATORY_CHAR_ARRAY	" \t\n\r.!,:;?<>()[]{}\\\"|+-*%=^&/"
@@ -0,0 +1,1942 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		histogramBenchmark.cpp					---*
+ *---									---*
+ *---	    This file defines a program that times the word-counting	---*
+ *---	structures of the histogrammer.					---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"header.h"
+#include	<time.h>
+#include	<math.h>	// For pow()
+#include	<pthread.h>
+#include	<algorithm>
+#include	<malloc.h>	// For mallinfo2()
+#include	<sys/ioctl.h>	// For ioctl()
+#include	<sys/syscall.h>	// For syscall()
+#include	<linux/perf_event.h>	// For perf_event_open()
+#include	"Arena.h"
+#include	"Histogram.h"
+#include	"Node.h"
+#include	"WordTable.h"
+#include	"SpaceSaving.h"
+#include	"CountMinSketch.h"
+#include	"WordRing.h"
+#include	"Tokenizer.h"
+#include	"protocol.h"
+
+//	Compile with:
+//	$ g++ -O2 histogramBenchmark.cpp Tokenizer.cpp Histogram.cpp Node.cpp WordTable.cpp SpaceSaving.cpp CountMinSketch.cpp Arena.cpp -o histogramBenchmark -lpthread
+//
+//	Run with:
+//	$ ./histogramBenchmark tree [numWords]
+//	$ ./histogramBenchmark engines [megabytes]
+//	$ ./histogramBenchmark handoff [numWords]
+//	$ ./histogramBenchmark scaling [megabytes]
+//	$ ./histogramBenchmark tokenizer [megabytes]
+//	$ ./histogramBenchmark sketch [kilobytes]
+//	$ ./histogramBenchmark layout [numWords]
+//	$ ./histogramBenchmark stress [numWords]
+//	$ ./histogramBenchmark serialize [numWords]
+//	$ ./histogramBenchmark corpus [numWords [exponent [numDistinct [seed]]]] > zipf.txt
+//	$ ./histogramBenchmark suite [filename] > results.json
+
+
+
+//	----	----	----	----	----	----	----	----	//
+//									//
+//			Global constants:				//
+//									//
+//	----	----	----	----	----	----	----	----	//
+
+//  PURPOSE:  To tell the default number of words in each generated stream.
+const int	DEFAULT_NUM_WORDS	= 1000000;
+
+//  PURPOSE:  To tell the most words the unbalanced tree is given in sorted
+//	order.  It is quadratic there (and recurses once per word), so the
+//	per-word times are compared instead of the totals.
+const int	LEGACY_SORTED_LIMIT	= 50000;
+
+//  PURPOSE:  To tell the default number of megabytes that 'big.txt' is
+//	replicated to when comparing the engines.
+const int	DEFAULT_NUM_MEGABYTES	= 1024;
+
+//  PURPOSE:  To tell the default number of words handed from the reading
+//	thread to the counting thread when comparing the hand-offs.
+const int	DEFAULT_NUM_HANDOFF_WORDS	= 10000000;
+
+//  PURPOSE:  To tell the most counting threads the scaling benchmark tries.
+const int	MAX_SCALING_THREADS	= 32;
+
+//  PURPOSE:  To tell the length of the line buffer of the 'fgets()'/'strtok()'
+//	tokenizer that 'Tokenizer' replaced.
+const int	LEGACY_LINE_LEN		= 4096;
+
+//  PURPOSE:  To tell the default number of megabytes the tokenizers read.
+const int	DEFAULT_TOKENIZER_MEGABYTES	= 256;
+
+//  PURPOSE:  To tell the default number of kilobytes of the Count-Min sketch
+//	compared with exact counting.
+const int	DEFAULT_SKETCH_KILOBYTES	= 1024;
+
+//  PURPOSE:  To tell the number of distinct words of the synthetic corpus
+//	the Count-Min sketch is compared on, and its number of words, drawn
+//	with Zipf's law.
+const int	SYNTHETIC_NUM_DISTINCT	= 2000000;
+const int	SYNTHETIC_NUM_WORDS	= 20000000;
+
+//  PURPOSE:  To tell how many of the most frequent words the Count-Min
+//	sketch is checked to list.
+const int	SKETCH_NUM_CHECKED_TOP	= 100;
+
+//  PURPOSE:  To tell the default number of distinct words the node layouts
+//	are compared on.
+const int	DEFAULT_LAYOUT_NUM_WORDS	= 2000000;
+
+//  PURPOSE:  To tell the default number of distinct sorted words the tree is
+//	stress-tested with.
+const int	DEFAULT_STRESS_NUM_WORDS	= 10000000;
+
+//  PURPOSE:  To tell the default exponent of Zipf's law a generated corpus
+//	draws its words with.
+const double	DEFAULT_ZIPF_EXPONENT	= 1.0;
+
+//  PURPOSE:  To tell the number of words on each line of a generated corpus.
+const int	CORPUS_WORDS_PER_LINE	= 16;
+
+//  PURPOSE:  To tell the number of most frequent words the suite selects.
+const int	SUITE_TOP_K		= 100;
+
+//  PURPOSE:  To tell the name of the corpus the engines are compared on.
+#define		BENCHMARK_FILENAME	"big.txt"
+
+
+
+//	----	----	----	----	----	----	----	----	//
+//									//
+//			Global functions:				//
+//									//
+//	----	----	----	----	----	----	----	----	//
+
+//  PURPOSE:  To return the current monotonic time in seconds.  No
+//	parameters.
+double		now		()
+{
+  struct timespec	ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return(ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+
+//  PURPOSE:  To return an array of 'numWords' distinct words, each of
+//	length 'BUFFER_LEN' or less, in sorted order.  Word 'i' is 'i' printed
+//	with 'formatCPtr'.  If 'shouldShuffle' is 'true' then the array is
+//	shuffled instead.  The array is 'free()'d with 'freeWords()'.
+char**		makeWords	(int		numWords,
+				 bool		shouldShuffle,
+				 const char*	formatCPtr	= "word%09d"
+				)
+{
+  char**	wordArray	= (char**)malloc(numWords * sizeof(char*));
+
+  for  (int i = 0;  i < numWords;  i++)
+  {
+    char	buffer[BUFFER_LEN];
+
+    snprintf(buffer,BUFFER_LEN,formatCPtr,i);
+    wordArray[i]	= strdup(buffer);
+  }
+
+  if  (shouldShuffle)
+  {
+    srand(1);
+
+    for  (int i = numWords-1;  i > 0;  i--)
+    {
+      int	j	= rand() % (i+1);
+      char*	tmp	= wordArray[i];
+
+      wordArray[i]	= wordArray[j];
+      wordArray[j]	= tmp;
+    }
+  }
+
+  return(wordArray);
+}
+
+
+//  PURPOSE:  To release 'wordArray' of length 'numWords' made by
+//	'makeWords()'.  No return value.
+void		freeWords	(char**		wordArray,
+				 int		numWords
+				)
+{
+  for  (int i = 0;  i < numWords;  i++)
+    free(wordArray[i]);
+
+  free(wordArray);
+}
+
+
+//  PURPOSE:  To be the node of the unbalanced tree that 'WordTree' replaced,
+//	kept so the two may be compared.
+struct		LegacyNode
+{
+  LegacyNode*	leftPtr_;
+  LegacyNode*	rightPtr_;
+  char*		wordCPtr_;
+  int		count_;
+
+  LegacyNode			(const char*	wordCPtr
+				) :
+				leftPtr_(NULL),
+				rightPtr_(NULL),
+				wordCPtr_(strndup(wordCPtr,BUFFER_LEN-1)),
+				count_(1)
+				{ }
+
+  ~LegacyNode			()
+				{
+				  free(wordCPtr_);
+				  delete(leftPtr_);
+				  delete(rightPtr_);
+				}
+};
+
+
+//  PURPOSE:  To insert 'wordCPtr' under 'nodePtr' the way the unbalanced tree
+//	did.  No return value.
+void		legacyInsert	(LegacyNode*	nodePtr,
+				 const char*	wordCPtr
+				)
+{
+  int	compRes	= strcmp(nodePtr->wordCPtr_,wordCPtr);
+
+  if  (compRes > 0)
+  {
+    if  (nodePtr->leftPtr_ != NULL)
+      legacyInsert(nodePtr->leftPtr_,wordCPtr);
+    else
+      nodePtr->leftPtr_	= new LegacyNode(wordCPtr);
+  }
+  else
+  if  (compRes < 0)
+  {
+    if  (nodePtr->rightPtr_ != NULL)
+      legacyInsert(nodePtr->rightPtr_,wordCPtr);
+    else
+      nodePtr->rightPtr_	= new LegacyNode(wordCPtr);
+  }
+  else
+    nodePtr->count_++;
+}
+
+
+//  PURPOSE:  To time inserting the 'numWords' words of 'wordArray' into
+//	the unbalanced tree.  Returns the number of seconds taken, including
+//	tear-down.
+double		timeLegacyTree	(char**		wordArray,
+				 int		numWords
+				)
+{
+  double	start	= now();
+  LegacyNode*	rootPtr	= new LegacyNode(wordArray[0]);
+
+  for  (int i = 1;  i < numWords;  i++)
+    legacyInsert(rootPtr,wordArray[i]);
+
+  delete(rootPtr);
+  return(now() - start);
+}
+
+
+//  PURPOSE:  To time inserting the 'numWords' words of 'wordArray' into
+//	a 'WordTree'.  Returns the number of seconds taken, including
+//	tear-down.
+double		timeWordTree	(char**		wordArray,
+				 int		numWords
+				)
+{
+  double	start	= now();
+
+  {
+    WordTree	tree;
+
+    for  (int i = 0;  i < numWords;  i++)
+      insert(tree,wordArray[i]);
+  }
+
+  return(now() - start);
+}
+
+
+//  PURPOSE:  To compare 'WordTree' against the unbalanced tree on a sorted
+//	and a random stream of 'numWords' words.  No return value.
+void		benchmarkTree	(int		numWords
+				)
+{
+  for  (int shouldShuffle = 0;  shouldShuffle <= 1;  shouldShuffle++)
+  {
+    const char*	streamName	= shouldShuffle ? "random" : "sorted";
+    char**	wordArray	= makeWords(numWords,shouldShuffle);
+    int		numLegacy	= numWords;
+
+    if  ( !shouldShuffle  &&  (numLegacy > LEGACY_SORTED_LIMIT) )
+      numLegacy	= LEGACY_SORTED_LIMIT;
+
+    double	balancedSecs	= timeWordTree(wordArray,numWords);
+    double	legacySecs	= timeLegacyTree(wordArray,numLegacy);
+    double	balancedNs	= balancedSecs * 1e9 / numWords;
+    double	legacyNs	= legacySecs * 1e9 / numLegacy;
+
+    printf("%s:\tbalanced %d words %.3fs (%.1f ns/word)\t"
+	   "unbalanced %d words %.3fs (%.1f ns/word)\tspeedup %.1fx\n",
+	   streamName,
+	   numWords,balancedSecs,balancedNs,
+	   numLegacy,legacySecs,legacyNs,
+	   legacyNs / balancedNs
+	  );
+    freeWords(wordArray,numWords);
+  }
+}
+
+
+//  PURPOSE:  To read all of file 'filenameCPtr' and split it into words with
+//	'strtok()'.  Appends the words to 'wordVector' and sets '*numBytesPtr'
+//	to the length of the file.  Returns the text the words point into,
+//	which the caller 'free()'s, or 'NULL' on error.
+char*		readWords	(const char*			filenameCPtr,
+				 std::vector<const char*>&	wordVector,
+				 size_t*			numBytesPtr
+				)
+{
+  FILE*		filePtr	= fopen(filenameCPtr,"r");
+
+  if  (filePtr == NULL)
+    return(NULL);
+
+  fseek(filePtr,0,SEEK_END);
+  *numBytesPtr	= ftell(filePtr);
+  rewind(filePtr);
+
+  char*		textCPtr	= (char*)malloc(*numBytesPtr + 1);
+
+  textCPtr[fread(textCPtr,1,*numBytesPtr,filePtr)] = '\0';
+  fclose(filePtr);
+
+  for  (char* wordCPtr = strtok(textCPtr,SEPARATORY_CHAR_ARRAY);
+	wordCPtr != NULL;
+	wordCPtr = strtok(NULL,SEPARATORY_CHAR_ARRAY)
+       )
+    wordVector.push_back(wordCPtr);
+
+  return(textCPtr);
+}
+
+
+//  PURPOSE:  To time counting 'numPasses' passes over the words of
+//	'wordVector' into the empty 'histogram'.  Appends the sorted result
+//	to 'entryVector'.  Returns the number of seconds taken, including the
+//	sort.
+double		timeEngine	(Histogram&				histogram,
+				 const std::vector<const char*>&	wordVector,
+				 int					numPasses,
+				 std::vector<WordCount>&		entryVector
+				)
+{
+  double	start		= now();
+
+  for  (int pass = 0;  pass < numPasses;  pass++)
+    for  (size_t i = 0;  i < wordVector.size();  i++)
+      insert(histogram,wordVector[i]);
+
+  histogram.getSorted(entryVector);
+  return(now() - start);
+}
+
+
+//  PURPOSE:  To compare the "tree" and "hash" engines on 'BENCHMARK_FILENAME'
+//	replicated to 'numMegabytes' megabytes.  Returns 'EXIT_SUCCESS' if both
+//	engines agree, or 'EXIT_FAILURE' otherwise.
+int		benchmarkEngines(int		numMegabytes
+				)
+{
+  std::vector<const char*>	wordVector;
+  size_t			numBytes;
+  char*				textCPtr = readWords(BENCHMARK_FILENAME,wordVector,&numBytes);
+
+  if  ( (textCPtr == NULL)  ||  wordVector.empty() )
+  {
+    fprintf(stderr,"Cannot read words from " BENCHMARK_FILENAME "\n");
+    return(EXIT_FAILURE);
+  }
+
+  int		numPasses	= (int)(((double)numMegabytes * 1024 * 1024) / numBytes);
+
+  if  (numPasses < 1)
+    numPasses	= 1;
+
+  const char*	engineArray[]	= {"tree","hash"};
+  Histogram*	histogramPtrArray[2];
+  std::vector<WordCount>	entryVectorArray[2];
+
+  for  (int i = 0;  i < 2;  i++)
+  {
+    histogramPtrArray[i]	= newHistogram(engineArray[i]);
+
+    double	secs	= timeEngine(*histogramPtrArray[i],wordVector,numPasses,entryVectorArray[i]);
+    double	numWords = (double)numPasses * wordVector.size();
+
+    printf("%s:\t%d passes of " BENCHMARK_FILENAME " (%.0f MB, %.0f words) %.3fs"
+	   "\t(%.1f ns/word, %.1f MB/s)\n",
+	   engineArray[i],numPasses,(double)numPasses*numBytes/(1024*1024),
+	   numWords,secs,secs*1e9/numWords,(double)numPasses*numBytes/(1024*1024)/secs
+	  );
+  }
+
+  bool	isSame	= (entryVectorArray[0].size() == entryVectorArray[1].size());
+
+  for  (size_t i = 0;  isSame && (i < entryVectorArray[0].size());  i++)
+    isSame	= (entryVectorArray[0][i].count == entryVectorArray[1][i].count)  &&
+		  (strcmp(entryVectorArray[0][i].wordCPtr,entryVectorArray[1][i].wordCPtr) == 0);
+
+  printf("engines %s\n",isSame ? "agree" : "DISAGREE");
+  delete(histogramPtrArray[1]);
+  delete(histogramPtrArray[0]);
+  free(textCPtr);
+  return(isSame ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+//  PURPOSE:  To hold what the reading and counting threads of a hand-off
+//	benchmark share.
+struct		Handoff
+{
+  //  PURPOSE:  To hold the words to hand over, cycled through 'numWords'
+  //	times in all.
+  const std::vector<const char*>*	wordVectorPtr;
+  long					numWords;
+
+  //  PURPOSE:  To hold the table the counting thread counts into.
+  WordTable				table;
+
+  //  PURPOSE:  To hold the single-word hand-off the histogrammer used to
+  //	have: 'wordPtr' guarded by 'lock' and the two condition variables.
+  const char*				wordPtr;
+  bool					isDone;
+  pthread_mutex_t			lock;
+  pthread_cond_t			wordSet;
+  pthread_cond_t			wordClear;
+
+  //  PURPOSE:  To hold the batched hand-off.
+  WordRing				ring;
+};
+
+
+//  PURPOSE:  To count words handed over one at a time by 'pingPongReader()'.
+//	'vPtr' points to the 'Handoff'.  Returns 'NULL'.
+void*		pingPongCounter	(void*		vPtr
+				)
+{
+  Handoff*	handoffPtr	= (Handoff*)vPtr;
+
+  while  (true)
+  {
+    pthread_mutex_lock(&handoffPtr->lock);
+
+    while  ( (handoffPtr->wordPtr == NULL)  &&  !handoffPtr->isDone )
+      pthread_cond_wait(&handoffPtr->wordSet,&handoffPtr->lock);
+
+    if  (handoffPtr->wordPtr == NULL)
+    {
+      pthread_mutex_unlock(&handoffPtr->lock);
+      break;
+    }
+
+    insert(handoffPtr->table,handoffPtr->wordPtr);
+    handoffPtr->wordPtr	= NULL;
+
+    pthread_mutex_unlock(&handoffPtr->lock);
+    pthread_cond_signal(&handoffPtr->wordClear);
+  }
+
+  return(NULL);
+}
+
+
+//  PURPOSE:  To hand the words of 'handoff' to 'pingPongCounter()' one at a
+//	time.  No return value.
+void		pingPongReader	(Handoff&	handoff
+				)
+{
+  const std::vector<const char*>&	wordVector	= *handoff.wordVectorPtr;
+
+  for  (long i = 0;  i < handoff.numWords;  i++)
+  {
+    pthread_mutex_lock(&handoff.lock);
+
+    while  (handoff.wordPtr != NULL)
+      pthread_cond_wait(&handoff.wordClear,&handoff.lock);
+
+    handoff.wordPtr	= wordVector[i % wordVector.size()];
+
+    pthread_mutex_unlock(&handoff.lock);
+    pthread_cond_signal(&handoff.wordSet);
+  }
+
+  pthread_mutex_lock(&handoff.lock);
+  handoff.isDone	= true;
+  pthread_mutex_unlock(&handoff.lock);
+  pthread_cond_signal(&handoff.wordSet);
+}
+
+
+//  PURPOSE:  To count words handed over a batch at a time by
+//	'ringReader()'.  'vPtr' points to the 'Handoff'.  Returns 'NULL'.
+void*		ringCounter	(void*		vPtr
+				)
+{
+  Handoff*		handoffPtr	= (Handoff*)vPtr;
+  const WordBatch*	batchPtr;
+
+  while  ( (batchPtr = handoffPtr->ring.getFullBatch()) != NULL )
+  {
+    for  (int i = 0;  i < batchPtr->numWords;  i++)
+      handoffPtr->table.insert(batchPtr->text + batchPtr->startArray[i],
+			       batchPtr->lenArray[i]
+			      );
+
+    handoffPtr->ring.release();
+  }
+
+  return(NULL);
+}
+
+
+//  PURPOSE:  To hand the words of 'handoff' to 'ringCounter()' a batch at a
+//	time.  No return value.
+void		ringReader	(Handoff&	handoff
+				)
+{
+  const std::vector<const char*>&	wordVector	= *handoff.wordVectorPtr;
+  WordBatch*	batchPtr	= handoff.ring.getEmptyBatch();
+
+  for  (long i = 0;  i < handoff.numWords;  i++)
+  {
+    if  (!batchPtr->hasRoom())
+    {
+      handoff.ring.publish();
+      batchPtr	= handoff.ring.getEmptyBatch();
+    }
+
+    batchPtr->add(wordVector[i % wordVector.size()]);
+  }
+
+  handoff.ring.publish();
+  handoff.ring.finish();
+}
+
+
+//  PURPOSE:  To time handing 'numWords' words of 'wordVector' from a reading
+//	thread to a counting thread, either one at a time through a mutex and
+//	two condition variables or, if 'isBatched' is 'true', through a
+//	'WordRing'.  Returns the words/sec achieved.
+double		timeHandoff	(const std::vector<const char*>&	wordVector,
+				 long					numWords,
+				 bool					isBatched
+				)
+{
+  Handoff*	handoffPtr	= new Handoff;
+  pthread_t	counterThread;
+
+  handoffPtr->wordVectorPtr	= &wordVector;
+  handoffPtr->numWords		= numWords;
+  handoffPtr->wordPtr		= NULL;
+  handoffPtr->isDone		= false;
+  pthread_mutex_init(&handoffPtr->lock,NULL);
+  pthread_cond_init(&handoffPtr->wordSet,NULL);
+  pthread_cond_init(&handoffPtr->wordClear,NULL);
+
+  double	start	= now();
+
+  if  (isBatched)
+  {
+    pthread_create(&counterThread,NULL,ringCounter,handoffPtr);
+    ringReader(*handoffPtr);
+  }
+  else
+  {
+    pthread_create(&counterThread,NULL,pingPongCounter,handoffPtr);
+    pingPongReader(*handoffPtr);
+  }
+
+  pthread_join(counterThread,NULL);
+
+  double	secs	= now() - start;
+
+  pthread_cond_destroy(&handoffPtr->wordClear);
+  pthread_cond_destroy(&handoffPtr->wordSet);
+  pthread_mutex_destroy(&handoffPtr->lock);
+  delete(handoffPtr);
+  return(numWords / secs);
+}
+
+
+//  PURPOSE:  To compare the one-word condition-variable hand-off against
+//	the batched 'WordRing' on 'numWords' words of 'BENCHMARK_FILENAME'.
+//	Returns 'EXIT_SUCCESS' on success or 'EXIT_FAILURE' otherwise.
+int		benchmarkHandoff(int		numWords
+				)
+{
+  std::vector<const char*>	wordVector;
+  size_t			numBytes;
+  char*				textCPtr = readWords(BENCHMARK_FILENAME,wordVector,&numBytes);
+
+  if  ( (textCPtr == NULL)  ||  wordVector.empty() )
+  {
+    fprintf(stderr,"Cannot read words from " BENCHMARK_FILENAME "\n");
+    return(EXIT_FAILURE);
+  }
+
+  double	pingPongRate	= timeHandoff(wordVector,numWords,false);
+  double	ringRate	= timeHandoff(wordVector,numWords,true);
+
+  printf("condvar ping-pong:\t%d words %.0f words/sec\n",numWords,pingPongRate);
+  printf("batched ring:\t\t%d words %.0f words/sec\tspeedup %.1fx\n",
+	 numWords,ringRate,ringRate/pingPongRate
+	);
+  free(textCPtr);
+  return(EXIT_SUCCESS);
+}
+
+
+//  PURPOSE:  To hold what one counting thread of the scaling benchmark
+//	needs, the same way histogrammer's 'Counter' does.
+struct		ScalingCounter
+{
+  WordRing		ring;
+  WordTable		table;
+  std::vector<WordCount> sortedRun;
+  pthread_t		threadId;
+};
+
+
+//  PURPOSE:  To count the batches of the 'ScalingCounter' that 'vPtr'
+//	points to, and then to sort its table into its 'sortedRun'.  Returns
+//	'NULL'.
+void*		scalingCounter	(void*		vPtr
+				)
+{
+  ScalingCounter*	counterPtr	= (ScalingCounter*)vPtr;
+  const WordBatch*	batchPtr;
+
+  while  ( (batchPtr = counterPtr->ring.getFullBatch()) != NULL )
+  {
+    for  (int i = 0;  i < batchPtr->numWords;  i++)
+      counterPtr->table.insert(batchPtr->text + batchPtr->startArray[i],
+			       batchPtr->lenArray[i]
+			      );
+
+    counterPtr->ring.release();
+  }
+
+  counterPtr->table.getSorted(counterPtr->sortedRun);
+  return(NULL);
+}
+
+
+//  PURPOSE:  To time counting 'numPasses' passes over 'wordVector' with
+//	'numThreads' counting threads fed round-robin by one reading thread,
+//	and merging their sorted runs, as 'histogrammer -j' does.  Sets
+//	'*numDistinctPtr' to the number of distinct words.  Returns the
+//	number of seconds taken.
+double		timeSharded	(const std::vector<const char*>&	wordVector,
+				 int					numPasses,
+				 int					numThreads,
+				 size_t*				numDistinctPtr
+				)
+{
+  ScalingCounter*	counterArray	= new ScalingCounter[numThreads];
+  double		start		= now();
+
+  for  (int i = 0;  i < numThreads;  i++)
+    pthread_create(&counterArray[i].threadId,NULL,scalingCounter,&counterArray[i]);
+
+  int		counterIndex	= 0;
+  WordBatch*	batchPtr	= counterArray[0].ring.getEmptyBatch();
+
+  for  (int pass = 0;  pass < numPasses;  pass++)
+    for  (size_t i = 0;  i < wordVector.size();  i++)
+    {
+      if  (!batchPtr->hasRoom())
+      {
+	counterArray[counterIndex].ring.publish();
+	counterIndex	= (counterIndex + 1) % numThreads;
+	batchPtr	= counterArray[counterIndex].ring.getEmptyBatch();
+      }
+
+      batchPtr->add(wordVector[i]);
+    }
+
+  counterArray[counterIndex].ring.publish();
+
+  for  (int i = 0;  i < numThreads;  i++)
+    counterArray[i].ring.finish();
+
+  std::vector< std::vector<WordCount> >	runVector(numThreads);
+  std::vector<WordCount>		entryVector;
+
+  for  (int i = 0;  i < numThreads;  i++)
+  {
+    pthread_join(counterArray[i].threadId,NULL);
+    runVector[i].swap(counterArray[i].sortedRun);
+  }
+
+  mergeSorted(runVector,entryVector);
+
+  double	secs	= now() - start;
+
+  *numDistinctPtr	= entryVector.size();
+  delete[](counterArray);
+  return(secs);
+}
+
+
+//  PURPOSE:  To measure how sharded counting scales from 1 to
+//	'MAX_SCALING_THREADS' threads on 'BENCHMARK_FILENAME' replicated to
+//	'numMegabytes' megabytes.  Returns 'EXIT_SUCCESS' if every thread count
+//	gives the same number of distinct words, or 'EXIT_FAILURE' otherwise.
+int		benchmarkScaling(int		numMegabytes
+				)
+{
+  std::vector<const char*>	wordVector;
+  size_t			numBytes;
+  char*				textCPtr = readWords(BENCHMARK_FILENAME,wordVector,&numBytes);
+
+  if  ( (textCPtr == NULL)  ||  wordVector.empty() )
+  {
+    fprintf(stderr,"Cannot read words from " BENCHMARK_FILENAME "\n");
+    return(EXIT_FAILURE);
+  }
+
+  int		numPasses	= (int)(((double)numMegabytes * 1024 * 1024) / numBytes);
+  double	oneThreadSecs	= 0;
+  size_t	oneThreadDistinct = 0;
+  int		status		= EXIT_SUCCESS;
+
+  if  (numPasses < 1)
+    numPasses	= 1;
+
+  for  (int numThreads = 1;  numThreads <= MAX_SCALING_THREADS;  numThreads *= 2)
+  {
+    size_t	numDistinct;
+    double	secs	= timeSharded(wordVector,numPasses,numThreads,&numDistinct);
+
+    if  (numThreads == 1)
+    {
+      oneThreadSecs	= secs;
+      oneThreadDistinct	= numDistinct;
+    }
+    else
+    if  (numDistinct != oneThreadDistinct)
+      status	= EXIT_FAILURE;
+
+    printf("-j %d:\t%.0f MB %.3fs\t(%.1f MB/s, speedup %.2fx)\n",
+	   numThreads,(double)numPasses*numBytes/(1024*1024),secs,
+	   (double)numPasses*numBytes/(1024*1024)/secs,oneThreadSecs/secs
+	  );
+  }
+
+  free(textCPtr);
+  return(status);
+}
+
+
+//  PURPOSE:  To return the number of words in the file read by 'inputPtr',
+//	found the way the histogrammer's 'getNextWord()' used to: with
+//	'fgets()' into a fixed line buffer and 'strtok()'.  Adds the lengths
+//	of the words to '*sumPtr' so they are not optimized away.
+long		legacyTokenize	(FILE*		inputPtr,
+				 long*		sumPtr
+				)
+{
+  char	line[LEGACY_LINE_LEN];
+  long	numWords	= 0;
+
+  while  (fgets(line,LEGACY_LINE_LEN,inputPtr) != NULL)
+    for  (char* wordCPtr = strtok(line,SEPARATORY_CHAR_ARRAY);
+	  wordCPtr != NULL;
+	  wordCPtr = strtok(NULL,SEPARATORY_CHAR_ARRAY)
+	 )
+    {
+      *sumPtr	+= strlen(wordCPtr);
+      numWords++;
+    }
+
+  return(numWords);
+}
+
+
+//  PURPOSE:  To compare the bytes/sec of the old 'fgets()'/'strtok()'
+//	tokenizer and of 'Tokenizer' on 'BENCHMARK_FILENAME' replicated to
+//	'numMegabytes' megabytes in a temporary file.  Returns 'EXIT_SUCCESS'
+//	on success or 'EXIT_FAILURE' otherwise.
+int		benchmarkTokenizer
+				(int		numMegabytes
+				)
+{
+  std::vector<const char*>	wordVector;
+  size_t			numBytes;
+  char*				textCPtr = readWords(BENCHMARK_FILENAME,wordVector,&numBytes);
+  char				tmpName[] = "/tmp/histogramBenchmarkXXXXXX";
+  int				fd	 = mkstemp(tmpName);
+
+  if  ( (textCPtr == NULL)  ||  (fd < 0) )
+  {
+    fprintf(stderr,"Cannot set up the tokenizer benchmark\n");
+    return(EXIT_FAILURE);
+  }
+
+  //  Re-read the text, since 'strtok()' wrote '\0's into it:
+  FILE*		filePtr	= fopen(BENCHMARK_FILENAME,"r");
+
+  fread(textCPtr,1,numBytes,filePtr);
+  fclose(filePtr);
+
+  size_t	totalBytes	= 0;
+
+  while  (totalBytes < (size_t)numMegabytes * 1024 * 1024)
+  {
+    write(fd,textCPtr,numBytes);
+    totalBytes	+= numBytes;
+  }
+
+  close(fd);
+  free(textCPtr);
+
+  //  Time the old tokenizer (twice, the first time to warm the page cache):
+  long		legacySum	= 0;
+  long		numWords	= 0;
+  double	legacySecs	= 0;
+
+  for  (int i = 0;  i < 2;  i++)
+  {
+    FILE*	inputPtr	= fopen(tmpName,"r");
+    double	start		= now();
+
+    legacySum	= 0;
+    numWords	= legacyTokenize(inputPtr,&legacySum);
+    legacySecs	= now() - start;
+    fclose(inputPtr);
+  }
+
+  //  Time 'Tokenizer', including the mapping:
+  long		mappedSum	= 0;
+  double	start		= now();
+
+  {
+    Tokenizer	tokenizer;
+    const char*	wordCPtr;
+    int		wordLen	= 0;
+
+    tokenizer.open(tmpName);
+
+    for  (long i = 0;  i < numWords;  i++)
+    {
+      tokenizer.getNextWord(&wordCPtr,&wordLen);
+      mappedSum	+= wordLen;
+    }
+  }
+
+  double	mappedSecs	= now() - start;
+
+  unlink(tmpName);
+  printf("fgets/strtok:\t%.0f MB %ld words %.3fs\t(%.1f MB/s)\n",
+	 totalBytes/(1024.0*1024),numWords,legacySecs,totalBytes/(1024.0*1024)/legacySecs
+	);
+  printf("mmap/table:\t%.0f MB %ld words %.3fs\t(%.1f MB/s)\tspeedup %.1fx\n",
+	 totalBytes/(1024.0*1024),numWords,mappedSecs,totalBytes/(1024.0*1024)/mappedSecs,
+	 legacySecs/mappedSecs
+	);
+
+  if  (mappedSum != legacySum)
+  {
+    printf("tokenizers DISAGREE\n");
+    return(EXIT_FAILURE);
+  }
+
+  printf("tokenizers agree\n");
+  return(EXIT_SUCCESS);
+}
+
+
+//  PURPOSE:  To count the words of 'wordVector' exactly and in a Count-Min
+//	sketch of 'numKilobytes' kilobytes, and to print how far apart they
+//	are, under the name 'nameCPtr'.  Returns 'true' if no estimate is too
+//	low, and no more are too high by more than the sketch's bound than its
+//	odds allow, or 'false' otherwise.
+bool		compareSketch	(const char*				nameCPtr,
+				 const std::vector<const char*>&	wordVector,
+				 int					numKilobytes
+				)
+{
+  WordTable		table;
+  CountMinSketch	sketch((size_t)numKilobytes * 1024);
+  std::vector<WordCount>	exactVector;
+  std::vector<WordCount>	listedVector;
+  double		start	= now();
+
+  for  (size_t i = 0;  i < wordVector.size();  i++)
+    insert(table,wordVector[i]);
+
+  double		exactSecs	= now() - start;
+
+  start	= now();
+
+  for  (size_t i = 0;  i < wordVector.size();  i++)
+    insert(sketch,wordVector[i]);
+
+  double		sketchSecs	= now() - start;
+
+  //  Check every word's estimate against its count:
+  long		numTooLow	= 0;
+  long		numPastBound	= 0;
+  uint64_t	maxError	= sketch.getMaxError();
+  double	sumError	= 0;
+
+  table.getUnsorted(exactVector);
+
+  for  (size_t i = 0;  i < exactVector.size();  i++)
+  {
+    long	error	= (long)sketch.estimate(exactVector[i].wordCPtr,exactVector[i].wordLen)
+			  - exactVector[i].count;
+
+    if  (error < 0)
+      numTooLow++;
+    else
+    if  ((uint64_t)error > maxError)
+      numPastBound++;
+
+    sumError	+= error;
+  }
+
+  //  Check the words it lists against the most frequent ones:
+  std::vector<WordCount>	topVector;
+  int				numFound	= 0;
+
+  selectTop(exactVector,SKETCH_NUM_CHECKED_TOP,topVector);
+  sketch.getSorted(listedVector);
+
+  for  (size_t i = 0;  i < topVector.size();  i++)
+    numFound	+= std::binary_search(listedVector.begin(),listedVector.end(),
+				      topVector[i],isWordBefore
+				     );
+
+  printf("%s:\t%zu words, %zu distinct\n"
+	 "  exact:\t%.3fs\n"
+	 "  sketch:\t%.3fs\t%d KB, %d x %u cells, %d heavy hitters\n"
+	 "  error:\tmean %.2f, bound %lu (odds %.3f), %ld past it, %ld too low\n"
+	 "  top %d:\t%d listed\n",
+	 nameCPtr,wordVector.size(),exactVector.size(),exactSecs,sketchSecs,
+	 numKilobytes,COUNT_MIN_DEPTH,sketch.getWidth(),sketch.getNumDistinct(),
+	 sumError/exactVector.size(),(unsigned long)maxError,sketch.getFailureOdds(),
+	 numPastBound,numTooLow,(int)topVector.size(),numFound
+	);
+
+  return( (numTooLow == 0)  &&
+	  (numPastBound <= sketch.getFailureOdds() * exactVector.size())
+	);
+}
+
+
+//  PURPOSE:  To set 'cumulativeVector' to the running sums of the odds of
+//	ranks '0' to 'numDistinct-1' under Zipf's law with exponent
+//	'exponent', which gives rank 'i' odds proportional to
+//	'1/(i+1)^exponent'.  No return value.
+void		makeZipfOdds	(int			numDistinct,
+				 double			exponent,
+				 std::vector<double>&	cumulativeVector
+				)
+{
+  double	sum	= 0;
+
+  cumulativeVector.resize(numDistinct);
+
+  for  (int i = 0;  i < numDistinct;  i++)
+    cumulativeVector[i]	= (sum += 1.0 / pow(i+1,exponent));
+}
+
+
+//  PURPOSE:  To return a rank drawn with 'drand48()' with the odds whose
+//	running sums 'makeZipfOdds()' put in 'cumulativeVector'.
+size_t		drawZipfRank	(const std::vector<double>&	cumulativeVector
+				)
+{
+  size_t	rank	= std::upper_bound(cumulativeVector.begin(),cumulativeVector.end(),
+					   drand48() * cumulativeVector.back()
+					  )
+			  - cumulativeVector.begin();
+
+  return( (rank < cumulativeVector.size()) ? rank : cumulativeVector.size()-1 );
+}
+
+
+//  PURPOSE:  To compare approximate counting in a Count-Min sketch of
+//	'numKilobytes' kilobytes with exact counting, on 'BENCHMARK_FILENAME'
+//	and on a synthetic corpus of 'SYNTHETIC_NUM_WORDS' words drawn from
+//	'SYNTHETIC_NUM_DISTINCT' with Zipf's law.  Returns 'EXIT_SUCCESS' if
+//	the sketch keeps to its bounds on both, or 'EXIT_FAILURE' otherwise.
+int		benchmarkSketch	(int		numKilobytes
+				)
+{
+  std::vector<const char*>	wordVector;
+  size_t			numBytes;
+  char*				textCPtr = readWords(BENCHMARK_FILENAME,wordVector,&numBytes);
+
+  if  ( (textCPtr == NULL)  ||  wordVector.empty() )
+  {
+    fprintf(stderr,"Cannot read words from " BENCHMARK_FILENAME "\n");
+    return(EXIT_FAILURE);
+  }
+
+  bool	isWithinBounds	= compareSketch(BENCHMARK_FILENAME,wordVector,numKilobytes);
+
+  free(textCPtr);
+
+  //  Word 'i' (from '0') of the synthetic corpus has odds proportional to
+  //  '1/(i+1)':
+  char**		distinctArray	= makeWords(SYNTHETIC_NUM_DISTINCT,true);
+  std::vector<double>	cumulativeVector;
+
+  makeZipfOdds(SYNTHETIC_NUM_DISTINCT,DEFAULT_ZIPF_EXPONENT,cumulativeVector);
+  srand48(1);
+  wordVector.clear();
+
+  for  (int i = 0;  i < SYNTHETIC_NUM_WORDS;  i++)
+    wordVector.push_back(distinctArray[drawZipfRank(cumulativeVector)]);
+
+  isWithinBounds	= compareSketch("zipf",wordVector,numKilobytes)  &&  isWithinBounds;
+  freeWords(distinctArray,SYNTHETIC_NUM_DISTINCT);
+  printf("sketch %s\n",isWithinBounds ? "within bounds" : "OUT OF BOUNDS");
+  return(isWithinBounds ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+//  PURPOSE:  To be the node of the pointer-linked tree that the compact
+//	'Node' replaced: two child pointers and a pointer to a word interned
+//	in an 'Arena', kept so the two layouts may be compared.
+struct		PointerNode
+{
+  PointerNode*	leftPtr_;
+  PointerNode*	rightPtr_;
+  const char*	wordCPtr_;
+  int		count_;
+  int		height_;
+};
+
+
+//  PURPOSE:  To return the height of the subtree at 'nodePtr', or '0' if
+//	'nodePtr' is 'NULL'.
+inline
+int		pointerHeightOf	(const PointerNode*	nodePtr
+				)
+{
+  return( (nodePtr == NULL) ? 0 : nodePtr->height_ );
+}
+
+
+//  PURPOSE:  To recompute the height of 'nodePtr' from its children.  No
+//	return value.
+inline
+void		pointerUpdateHeight
+				(PointerNode*	nodePtr
+				)
+{
+  int	leftHeight	= pointerHeightOf(nodePtr->leftPtr_);
+  int	rightHeight	= pointerHeightOf(nodePtr->rightPtr_);
+
+  nodePtr->height_	= 1 + ((leftHeight > rightHeight) ? leftHeight : rightHeight);
+}
+
+
+//  PURPOSE:  To rotate the subtree at 'nodePtr' to the right if 'isRight',
+//	or else to the left.  Returns the new root of the subtree.
+PointerNode*	pointerRotate	(PointerNode*	nodePtr,
+				 bool		isRight
+				)
+{
+  PointerNode*	newRootPtr;
+
+  if  (isRight)
+  {
+    newRootPtr		= nodePtr->leftPtr_;
+    nodePtr->leftPtr_	= newRootPtr->rightPtr_;
+    newRootPtr->rightPtr_	= nodePtr;
+  }
+  else
+  {
+    newRootPtr		= nodePtr->rightPtr_;
+    nodePtr->rightPtr_	= newRootPtr->leftPtr_;
+    newRootPtr->leftPtr_	= nodePtr;
+  }
+
+  pointerUpdateHeight(nodePtr);
+  pointerUpdateHeight(newRootPtr);
+  return(newRootPtr);
+}
+
+
+//  PURPOSE:  To insert the 'wordLen' chars at 'wordCPtr' under 'nodePtr'
+//	the way the pointer-linked tree did, taking new nodes and words from
+//	'arena'.  Sets '*wasAddedPtr' to 'true' if a node was added.  Returns
+//	the new (re-balanced) root of the subtree.
+PointerNode*	pointerInsert	(PointerNode*	nodePtr,
+				 Arena&		arena,
+				 const char*	wordCPtr,
+				 int		wordLen,
+				 bool*		wasAddedPtr
+				)
+{
+  if  (nodePtr == NULL)
+  {
+    nodePtr		= (PointerNode*)arena.allocate(sizeof(PointerNode));
+    nodePtr->leftPtr_	= NULL;
+    nodePtr->rightPtr_	= NULL;
+    nodePtr->wordCPtr_	= arena.intern(wordCPtr,wordLen);
+    nodePtr->count_	= 1;
+    nodePtr->height_	= 1;
+    *wasAddedPtr	= true;
+    return(nodePtr);
+  }
+
+  int	compRes	= strncmp(nodePtr->wordCPtr_,wordCPtr,wordLen);
+
+  if  ( (compRes == 0)  &&  (nodePtr->wordCPtr_[wordLen] != '\0') )
+    compRes	= 1;
+
+  if  (compRes == 0)
+  {
+    nodePtr->count_++;
+    return(nodePtr);
+  }
+
+  if  (compRes > 0)
+    nodePtr->leftPtr_	= pointerInsert(nodePtr->leftPtr_,arena,wordCPtr,wordLen,wasAddedPtr);
+  else
+    nodePtr->rightPtr_	= pointerInsert(nodePtr->rightPtr_,arena,wordCPtr,wordLen,wasAddedPtr);
+
+  if  (!*wasAddedPtr)
+    return(nodePtr);
+
+  int	balance	= pointerHeightOf(nodePtr->leftPtr_) - pointerHeightOf(nodePtr->rightPtr_);
+
+  if  (balance > 1)
+  {
+    if  (pointerHeightOf(nodePtr->leftPtr_->leftPtr_) <
+	 pointerHeightOf(nodePtr->leftPtr_->rightPtr_)
+	)
+      nodePtr->leftPtr_	= pointerRotate(nodePtr->leftPtr_,false);
+
+    return(pointerRotate(nodePtr,true));
+  }
+
+  if  (balance < -1)
+  {
+    if  (pointerHeightOf(nodePtr->rightPtr_->rightPtr_) <
+	 pointerHeightOf(nodePtr->rightPtr_->leftPtr_)
+	)
+      nodePtr->rightPtr_	= pointerRotate(nodePtr->rightPtr_,true);
+
+    return(pointerRotate(nodePtr,false));
+  }
+
+  pointerUpdateHeight(nodePtr);
+  return(nodePtr);
+}
+
+
+//  PURPOSE:  To append to 'entryVector' an entry for each node at or under
+//	'nodePtr', in in-fix order.  No return value.
+void		pointerAppend	(const PointerNode*		nodePtr,
+				 std::vector<WordCount>&	entryVector
+				)
+{
+  if  (nodePtr == NULL)
+    return;
+
+  pointerAppend(nodePtr->leftPtr_,entryVector);
+
+  WordCount	entry;
+
+  entry.wordCPtr	= nodePtr->wordCPtr_;
+  entry.wordLen		= strlen(nodePtr->wordCPtr_);
+  entry.count		= nodePtr->count_;
+  entryVector.push_back(entry);
+
+  pointerAppend(nodePtr->rightPtr_,entryVector);
+}
+
+
+//  PURPOSE:  To count words in the pointer-linked layout that 'WordTree'
+//	had before its nodes were packed into a vector.
+class	PointerTree : public Histogram
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To hold the nodes and the words of '*this'.
+  Arena		arena_;
+
+  //  PURPOSE:  To point to the root of the balanced tree, or 'NULL'.
+  PointerNode*	rootPtr_;
+
+  //  PURPOSE:  To tell the number of distinct words in '*this'.
+  int		numDistinct_;
+
+public :
+  //  IV.  Constructor(s), op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to an empty tree.  No parameters.
+  PointerTree			() :
+				rootPtr_(NULL),
+				numDistinct_(0)
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of distinct words.  No parameters.
+  int		getNumDistinct	()
+				const
+				{
+				  return(numDistinct_);
+				}
+
+  //  PURPOSE:  To append to 'entryVector' one entry per distinct word, in
+  //	the in-fix order of the tree.  No return value.
+  void		getSorted	(std::vector<WordCount>&	entryVector
+				)
+				const
+				{
+				  pointerAppend(rootPtr_,entryVector);
+				}
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To note one more occurrence of the 'wordLen' chars starting
+  //	at 'wordCPtr'.  No return value.
+  void		insert		(const char*	wordCPtr,
+				 int		wordLen
+				)
+				{
+				  bool	wasAdded	= false;
+
+				  rootPtr_	= pointerInsert(rootPtr_,arena_,wordCPtr,wordLen,&wasAdded);
+				  numDistinct_	+= wasAdded;
+				}
+
+  //  PURPOSE:  To note 'count' more occurrences of the 'wordLen' chars
+  //	starting at 'wordCPtr'.  Only used one at a time here.  No return
+  //	value.
+  void		add		(const char*	wordCPtr,
+				 int		wordLen,
+				 int		count
+				)
+				{
+				  while  (count-- > 0)
+				    insert(wordCPtr,wordLen);
+				}
+
+};
+
+
+//  PURPOSE:  To return the number of bytes 'malloc()' has handed out and
+//	not yet had back.  No parameters.
+size_t		getNumHeapBytes	()
+{
+  struct mallinfo2	info	= mallinfo2();
+
+  return(info.uordblks + info.hblkhd);
+}
+
+
+//  PURPOSE:  To return a file descriptor counting the cache misses of this
+//	thread in user space, or '-1' if the hardware counters cannot be
+//	read here.  No parameters.
+int		openCacheMissCounter
+				()
+{
+  struct perf_event_attr	attr;
+
+  memset(&attr,0,sizeof(attr));
+  attr.size		= sizeof(attr);
+  attr.type		= PERF_TYPE_HARDWARE;
+  attr.config		= PERF_COUNT_HW_CACHE_MISSES;
+  attr.disabled		= 1;
+  attr.exclude_kernel	= 1;
+  attr.exclude_hv	= 1;
+
+  return(syscall(SYS_perf_event_open,&attr,0,-1,-1,0));
+}
+
+
+//  PURPOSE:  To insert the 'numWords' words of 'wordArray' into 'histogram'
+//	twice, and to print the bytes the first pass took per distinct word,
+//	and the time and cache misses per word of the second, which only
+//	finds words.  Appends the resulting histogram to 'entryVector'.  No
+//	return value.
+void		measureLayout	(const char*			nameCPtr,
+				 Histogram&			histogram,
+				 char**				wordArray,
+				 int				numWords,
+				 size_t				numHeapBytesBefore,
+				 std::vector<WordCount>&	entryVector
+				)
+{
+  for  (int i = 0;  i < numWords;  i++)
+    insert(histogram,wordArray[i]);
+
+  double	bytesPerWord	= (double)(getNumHeapBytes() - numHeapBytesBefore) / numWords;
+  int		counterFd	= openCacheMissCounter();
+  long long	numMisses	= 0;
+
+  if  (counterFd >= 0)
+  {
+    ioctl(counterFd,PERF_EVENT_IOC_RESET,0);
+    ioctl(counterFd,PERF_EVENT_IOC_ENABLE,0);
+  }
+
+  double	start		= now();
+
+  for  (int i = 0;  i < numWords;  i++)
+    insert(histogram,wordArray[i]);
+
+  double	lookupNs	= (now() - start) * 1e9 / numWords;
+
+  if  (counterFd >= 0)
+  {
+    ioctl(counterFd,PERF_EVENT_IOC_DISABLE,0);
+
+    if  (read(counterFd,&numMisses,sizeof(numMisses)) != sizeof(numMisses))
+      numMisses	= -1;
+
+    close(counterFd);
+  }
+
+  printf("  %-8s %6.1f bytes/word  %6.1f ns/lookup  ",nameCPtr,bytesPerWord,lookupNs);
+
+  if  ( (counterFd >= 0)  &&  (numMisses >= 0) )
+    printf("%5.2f cache misses/lookup\n",(double)numMisses / numWords);
+  else
+    printf("cache misses n/a\n");
+
+  histogram.getSorted(entryVector);
+}
+
+
+//  PURPOSE:  To compare the memory, lookup time and cache misses of the
+//	compact 'WordTree' with those of the pointer-linked layout it
+//	replaced, on 'numWords' distinct words short enough to be kept in the
+//	nodes and on as many too long to be.  Returns 'EXIT_SUCCESS' if both
+//	count the same, or 'EXIT_FAILURE' otherwise.
+int		benchmarkLayout	(int		numWords
+				)
+{
+  const char*	formatArray[]	= { "w%d", "word%09d" };
+  bool		isSame		= true;
+
+  printf("node: compact %zu bytes, pointer %zu bytes\n",sizeof(Node),sizeof(PointerNode));
+
+  for  (int format = 0;  format < 2;  format++)
+  {
+    char**			wordArray	= makeWords(numWords,true,formatArray[format]);
+    std::vector<WordCount>	compactVector;
+    std::vector<WordCount>	pointerVector;
+
+    printf("%d distinct words like \"%s\":\n",numWords,wordArray[0]);
+    compactVector.reserve(numWords);
+    pointerVector.reserve(numWords);
+
+    {
+      size_t	numHeapBytes	= getNumHeapBytes();
+      WordTree	tree;
+
+      measureLayout("compact",tree,wordArray,numWords,numHeapBytes,compactVector);
+
+      size_t	numHeapBytesBefore	= getNumHeapBytes();
+      PointerTree	pointerTree;
+
+      measureLayout("pointer",pointerTree,wordArray,numWords,numHeapBytesBefore,pointerVector);
+
+      for  (int i = 0;  i < numWords;  i++)
+	if  ( (compactVector[i].count != pointerVector[i].count)  ||
+	      (strcmp(compactVector[i].wordCPtr,pointerVector[i].wordCPtr) != 0)
+	    )
+	{
+	  isSame	= false;
+	  break;
+	}
+    }
+
+    freeWords(wordArray,numWords);
+  }
+
+  printf("layouts %s\n",isSame ? "agree" : "DISAGREE");
+  return(isSame ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+//  PURPOSE:  To tell what a stress-testing thread is given and reports.
+struct		StressTask
+{
+  int		numWords;
+  double	insertSecs;
+  double	walkSecs;
+  double	releaseSecs;
+  bool		isCorrect;
+};
+
+
+//  PURPOSE:  To insert the 'numWords' distinct words of '*(StressTask*)vPtr'
+//	into a 'WordTree' in sorted order, the order that would make a
+//	recursive tree recurse deepest, then to walk it and to release it,
+//	noting how long each took and whether the walk gave every word in
+//	order with count '1'.  Returns 'NULL'.
+void*		stressTree	(void*		vPtr
+				)
+{
+  StressTask&		task	= *(StressTask*)vPtr;
+  std::vector<WordCount>	entryVector;
+  char			buffer[BUFFER_LEN];
+  WordTree*		treePtr	= new WordTree;
+  double		start	= now();
+
+  for  (int i = 0;  i < task.numWords;  i++)
+  {
+    int		wordLen	= snprintf(buffer,BUFFER_LEN,"word%09d",i);
+
+    treePtr->insert(buffer,wordLen);
+  }
+
+  task.insertSecs	= now() - start;
+  start			= now();
+  treePtr->getSorted(entryVector);
+  task.walkSecs		= now() - start;
+  task.isCorrect	= (entryVector.size() == (size_t)task.numWords);
+
+  for  (int i = 0;  task.isCorrect && (i < task.numWords);  i++)
+  {
+    snprintf(buffer,BUFFER_LEN,"word%09d",i);
+    task.isCorrect	= (entryVector[i].count == 1)  &&
+			  (strcmp(entryVector[i].wordCPtr,buffer) == 0);
+  }
+
+  start			= now();
+  delete(treePtr);
+  task.releaseSecs	= now() - start;
+  return(NULL);
+}
+
+
+//  PURPOSE:  To stress 'WordTree' with 'numWords' distinct sorted words in
+//	a thread with the default stack size.  Returns 'EXIT_SUCCESS' if the
+//	tree counted them correctly, or 'EXIT_FAILURE' otherwise.
+int		benchmarkStress	(int		numWords
+				)
+{
+  StressTask	task;
+  pthread_t	thread;
+  size_t	stackLen	= 0;
+  pthread_attr_t	attr;
+
+  pthread_attr_init(&attr);
+  pthread_attr_getstacksize(&attr,&stackLen);
+  pthread_attr_destroy(&attr);
+
+  task.numWords		= numWords;
+  task.isCorrect	= false;
+
+  if  (pthread_create(&thread,NULL,stressTree,&task) != 0)
+  {
+    fprintf(stderr,"Cannot start the stress-testing thread.\n");
+    return(EXIT_FAILURE);
+  }
+
+  pthread_join(thread,NULL);
+  printf("%d sorted words on a %zu KB stack: insert %.3fs (%.1f ns/word)  "
+	 "walk %.3fs  release %.3fs  %s\n",
+	 numWords,stackLen / 1024,
+	 task.insertSecs,task.insertSecs * 1e9 / numWords,
+	 task.walkSecs,task.releaseSecs,
+	 task.isCorrect ? "correct" : "INCORRECT"
+	);
+  return(task.isCorrect ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+//  PURPOSE:  To tell how a histogram goes through a pipe in 'timeSerial()':
+//	printed with 'fprintf()' and parsed with 'fgets()' and 'sscanf()',
+//	as the histogrammer and the server once did, serialized as text and
+//	parsed the same way, or serialized in binary and decoded in chunks.
+const int	SERIAL_PRINTF		= 0;
+const int	SERIAL_TEXT		= 1;
+const int	SERIAL_BINARY		= 2;
+
+
+//  PURPOSE:  To tell what the reading end of the pipe is given and reports.
+struct		SerialReader
+{
+  int		fd;
+  int		mode;
+  long		numEntries;
+  long		countSum;
+};
+
+
+//  PURPOSE:  To read the entries written to 'fd' of '*(SerialReader*)vPtr'
+//	in its mode until the writer closes the pipe, noting their number and
+//	the sum of their counts.  Returns 'NULL'.
+void*		serialReader	(void*		vPtr
+				)
+{
+  SerialReader&	reader	= *(SerialReader*)vPtr;
+
+  if  (reader.mode != SERIAL_BINARY)
+  {
+    FILE*	inputPtr	= fdopen(reader.fd,"r");
+    char	buffer[2*BUFFER_LEN];
+    char	word[BUFFER_LEN];
+    int		count;
+
+    while  (fgets(buffer,sizeof(buffer),inputPtr) != NULL)
+      if  (sscanf(buffer,"%d %s",&count,word) == 2)
+      {
+	reader.numEntries++;
+	reader.countSum	+= count;
+      }
+
+    fclose(inputPtr);
+    return(NULL);
+  }
+
+  const size_t	headerLen	= sizeof(uint32_t) + sizeof(uint16_t);
+  char		buffer[SERIAL_CHUNK_LEN];
+  size_t	len		= 0;
+  ssize_t	numRead;
+
+  while  ( (numRead = read(reader.fd,buffer+len,sizeof(buffer)-len)) > 0 )
+  {
+    size_t	pos	= 0;
+
+    len	+= numRead;
+
+    while  ( (pos + headerLen <= len)  &&
+	     (pos + headerLen + getU16(buffer+pos+sizeof(uint32_t)) <= len)
+	   )
+    {
+      reader.numEntries++;
+      reader.countSum	+= getU32(buffer+pos);
+      pos		+= headerLen + getU16(buffer+pos+sizeof(uint32_t));
+    }
+
+    memmove(buffer,buffer+pos,len-pos);
+    len	-= pos;
+  }
+
+  close(reader.fd);
+  return(NULL);
+}
+
+
+//  PURPOSE:  To time sending the entries of 'entryVector' through a pipe in
+//	mode 'mode' to a thread reading them.  Sets '*countSumPtr' to the sum
+//	of the counts read.  Returns the number of seconds taken.
+double		timeSerial	(const std::vector<WordCount>&	entryVector,
+				 int				mode,
+				 long*				countSumPtr
+				)
+{
+  int		pipeFds[2];
+  SerialReader	reader;
+  pthread_t	thread;
+
+  if  (pipe(pipeFds) != 0)
+  {
+    fprintf(stderr,"Cannot make a pipe.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  reader.fd		= pipeFds[0];
+  reader.mode		= mode;
+  reader.numEntries	= 0;
+  reader.countSum	= 0;
+
+  double	start	= now();
+
+  pthread_create(&thread,NULL,serialReader,&reader);
+
+  if  (mode == SERIAL_PRINTF)
+  {
+    FILE*	outputPtr	= fdopen(pipeFds[1],"w");
+
+    for  (size_t i = 0;  i < entryVector.size();  i++)
+      fprintf(outputPtr,"%d\t%s\n",entryVector[i].count,entryVector[i].wordCPtr);
+
+    fclose(outputPtr);
+  }
+  else
+  {
+    bool	isBinary	= (mode == SERIAL_BINARY);
+    char*	bufferPtr	= (char*)malloc(getSerializedLen(entryVector,isBinary));
+
+    writeAll(pipeFds[1],bufferPtr,serialize(entryVector,isBinary,bufferPtr));
+    close(pipeFds[1]);
+    free(bufferPtr);
+  }
+
+  pthread_join(thread,NULL);
+
+  double	secs	= now() - start;
+
+  *countSumPtr	= (reader.numEntries == (long)entryVector.size())
+		  ? reader.countSum
+		  : -1;
+  return(secs);
+}
+
+
+//  PURPOSE:  To compare the results/sec of sending a histogram of
+//	'numWords' distinct words through a pipe with 'fprintf()' and
+//	'sscanf()', and with the serializer as text and in binary.  Returns
+//	'EXIT_SUCCESS' if every way delivers every count, or 'EXIT_FAILURE'
+//	otherwise.
+int		benchmarkSerialize
+				(int		numWords
+				)
+{
+  const char*			modeNameArray[]	= { "printf/sscanf", "text", "binary" };
+  char**			wordArray	= makeWords(numWords,false);
+  std::vector<WordCount>	entryVector(numWords);
+  long				countSum	= 0;
+  bool				isCorrect	= true;
+  double			printfSecs	= 0;
+
+  for  (int i = 0;  i < numWords;  i++)
+  {
+    entryVector[i].wordCPtr	= wordArray[i];
+    entryVector[i].wordLen	= strlen(wordArray[i]);
+    entryVector[i].count	= 1 + (i * 7919) % 100000;
+    countSum			+= entryVector[i].count;
+  }
+
+  for  (int mode = SERIAL_PRINTF;  mode <= SERIAL_BINARY;  mode++)
+  {
+    long	readSum;
+    double	secs	= timeSerial(entryVector,mode,&readSum);
+
+    if  (mode == SERIAL_PRINTF)
+      printfSecs	= secs;
+
+    printf("%-14s %d results %.3fs (%.2fM results/sec)  speedup %.1fx  %s\n",
+	   modeNameArray[mode],numWords,secs,numWords / secs / 1e6,printfSecs / secs,
+	   (readSum == countSum) ? "complete" : "INCOMPLETE"
+	  );
+    isCorrect	= isCorrect  &&  (readSum == countSum);
+  }
+
+  freeWords(wordArray,numWords);
+  return(isCorrect ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+//  PURPOSE:  To write to 'stdout' a corpus of 'numWords' words drawn with
+//	Zipf's law of exponent 'exponent' from 'numDistinct' ranks, with
+//	'srand48(seed)', so the same arguments always make the same corpus.
+//	The ranks are the words of 'BENCHMARK_FILENAME', most frequent first,
+//	and, past them, those words again with a number appended.  Returns
+//	'EXIT_SUCCESS' on success or 'EXIT_FAILURE' otherwise.
+int		generateCorpus	(long		numWords,
+				 double		exponent,
+				 int		numDistinct,
+				 long		seed
+				)
+{
+  //  I.  Rank the words of 'BENCHMARK_FILENAME':
+  std::vector<const char*>	wordVector;
+  size_t			numBytes;
+  char*				textCPtr = readWords(BENCHMARK_FILENAME,wordVector,&numBytes);
+
+  if  ( (textCPtr == NULL)  ||  wordVector.empty() )
+  {
+    fprintf(stderr,"Cannot read words from " BENCHMARK_FILENAME "\n");
+    return(EXIT_FAILURE);
+  }
+
+  WordTable			table;
+  std::vector<WordCount>	entryVector;
+  std::vector<WordCount>	rankVector;
+
+  for  (size_t i = 0;  i < wordVector.size();  i++)
+    insert(table,wordVector[i]);
+
+  table.getSorted(entryVector);
+  selectTop(entryVector,entryVector.size(),rankVector);
+
+  if  (numDistinct < 1)
+    numDistinct	= rankVector.size();
+
+  //  II.  Draw the words:
+  std::vector<double>	cumulativeVector;
+  static char		outBuffer[1 << 20];
+
+  makeZipfOdds(numDistinct,exponent,cumulativeVector);
+  srand48(seed);
+  setvbuf(stdout,outBuffer,_IOFBF,sizeof(outBuffer));
+
+  for  (long i = 0;  i < numWords;  i++)
+  {
+    size_t		rank		= drawZipfRank(cumulativeVector);
+    const WordCount&	entry		= rankVector[rank % rankVector.size()];
+    char		separator	= ((i+1) % CORPUS_WORDS_PER_LINE == 0) ? '\n' : ' ';
+
+    if  (rank < rankVector.size())
+      printf("%.*s%c",entry.wordLen,entry.wordCPtr,separator);
+    else
+      printf("%.*s%lu%c",entry.wordLen,entry.wordCPtr,
+	     (unsigned long)(rank / rankVector.size()),separator
+	    );
+  }
+
+  if  (numWords % CORPUS_WORDS_PER_LINE != 0)
+    putchar('\n');
+
+  fflush(stdout);
+  fprintf(stderr,"corpus: %ld words of %d ranks (%zu from " BENCHMARK_FILENAME
+		 "), exponent %g, seed %ld\n",
+	  numWords,numDistinct,rankVector.size(),exponent,seed
+	 );
+  free(textCPtr);
+  return(EXIT_SUCCESS);
+}
+
+
+//  PURPOSE:  To time, on the corpus in file 'filenameCPtr', tokenizing it,
+//	counting and sorting its words with each engine, selecting its top
+//	words and serializing its histogram, and to print the results on
+//	'stdout' as one JSON object, for runs to be compared by a script.
+//	Returns 'EXIT_SUCCESS' on success or 'EXIT_FAILURE' otherwise.
+int		benchmarkSuite	(const char*	filenameCPtr
+				)
+{
+  //  I.  Tokenize (twice, the first time to warm the page cache):
+  Tokenizer			tokenizer;
+  std::vector<const char*>	wordCPtrVector;
+  std::vector<int>		wordLenVector;
+  double			tokenizeSecs	= 0;
+
+  if  (!tokenizer.open(filenameCPtr))
+  {
+    fprintf(stderr,"Cannot open %s\n",filenameCPtr);
+    return(EXIT_FAILURE);
+  }
+
+  for  (int pass = 0;  pass < 2;  pass++)
+  {
+    const char*	wordCPtr;
+    int		wordLen;
+    double	start	= now();
+
+    wordCPtrVector.clear();
+    wordLenVector.clear();
+    tokenizer.setPosition(0);
+
+    while  (tokenizer.scanWord(&wordCPtr,&wordLen))
+    {
+      wordCPtrVector.push_back(wordCPtr);
+      wordLenVector.push_back( (wordLen < BUFFER_LEN) ? wordLen : BUFFER_LEN-1 );
+    }
+
+    tokenizeSecs	= now() - start;
+  }
+
+  size_t	numWords	= wordCPtrVector.size();
+  double	numMegabytes	= tokenizer.getTextLen() / (1024.0*1024);
+
+  if  (numWords == 0)
+  {
+    fprintf(stderr,"No words in %s\n",filenameCPtr);
+    return(EXIT_FAILURE);
+  }
+
+  printf("{\n"
+	 "  \"benchmark\": \"suite\",\n"
+	 "  \"corpus\": \"%s\",\n"
+	 "  \"megabytes\": %.3f,\n"
+	 "  \"words\": %zu,\n"
+	 "  \"tokenize\": { \"seconds\": %.6f, \"wordsPerSec\": %.0f, \"megabytesPerSec\": %.1f },\n",
+	 filenameCPtr,numMegabytes,numWords,
+	 tokenizeSecs,numWords/tokenizeSecs,numMegabytes/tokenizeSecs
+	);
+
+  //  II.  Count and sort with each engine:
+  const char*			engineArray[]	= {"tree","hash"};
+  std::vector<WordCount>	entryVector;
+  Histogram*			histogramPtr	= NULL;
+
+  printf("  \"engines\": {\n");
+
+  for  (int i = 0;  i < 2;  i++)
+  {
+    Histogram*	enginePtr	= newHistogram(engineArray[i]);
+    double	start		= now();
+
+    for  (size_t j = 0;  j < numWords;  j++)
+      enginePtr->insert(wordCPtrVector[j],wordLenVector[j]);
+
+    double	insertSecs	= now() - start;
+
+    entryVector.clear();
+    start	= now();
+    enginePtr->getSorted(entryVector);
+
+    double	sortSecs	= now() - start;
+
+    printf("    \"%s\": { \"insertSeconds\": %.6f, \"nsPerWord\": %.1f, \"wordsPerSec\": %.0f,"
+	   " \"sortSeconds\": %.6f, \"distinct\": %zu }%s\n",
+	   engineArray[i],insertSecs,insertSecs*1e9/numWords,numWords/insertSecs,
+	   sortSecs,entryVector.size(),(i == 0) ? "," : ""
+	  );
+
+    //  The entries of the last engine are kept, since they point into it:
+    delete(histogramPtr);
+    histogramPtr	= enginePtr;
+  }
+
+  printf("  },\n");
+
+  //  III.  Select the top words:
+  std::vector<WordCount>	topVector;
+  double			start		= now();
+
+  selectTop(entryVector,SUITE_TOP_K,topVector);
+
+  double			topSecs		= now() - start;
+
+  printf("  \"top\": { \"k\": %d, \"seconds\": %.6f },\n",SUITE_TOP_K,topSecs);
+
+  //  IV.  Serialize, as text and in binary:
+  printf("  \"serialize\": {\n");
+
+  for  (int binary = 0;  binary < 2;  binary++)
+  {
+    size_t	len		= getSerializedLen(entryVector,binary);
+    char*	bufferPtr	= (char*)malloc(len);
+
+    start	= now();
+    serialize(entryVector,binary,bufferPtr);
+
+    double	secs		= now() - start;
+
+    printf("    \"%s\": { \"seconds\": %.6f, \"entriesPerSec\": %.0f, \"megabytesPerSec\": %.1f }%s\n",
+	   binary ? "binary" : "text",secs,entryVector.size()/secs,
+	   len/(1024.0*1024)/secs,binary ? "" : ","
+	  );
+    free(bufferPtr);
+  }
+
+  printf("  }\n"
+	 "}\n"
+	);
+
+  delete(histogramPtr);
+  return(EXIT_SUCCESS);
+}
+
+
+int		main		(int		argc,
+				 char*		argv[]
+				)
+{
+  //  I.  Application validity check:
+  const char*	usageCPtr	= "Usage:\thistogramBenchmark tree [numWords]\n"
+				  "\thistogramBenchmark engines [megabytes]\n"
+				  "\thistogramBenchmark handoff [numWords]\n"
+				  "\thistogramBenchmark scaling [megabytes]\n"
+				  "\thistogramBenchmark tokenizer [megabytes]\n"
+				  "\thistogramBenchmark sketch [kilobytes]\n"
+				  "\thistogramBenchmark layout [numWords]\n"
+				  "\thistogramBenchmark stress [numWords]\n"
+				  "\thistogramBenchmark serialize [numWords]\n"
+				  "\thistogramBenchmark corpus [numWords [exponent [numDistinct [seed]]]]\n"
+				  "\thistogramBenchmark suite [filename]\n";
+
+  if  (argc < 2)
+  {
+    fprintf(stderr,"%s",usageCPtr);
+    return(EXIT_FAILURE);
+  }
+
+  //  The corpus and the suite take arguments of their own:
+  if  (strcmp(argv[1],"corpus") == 0)
+  {
+    long	numWords	= (argc >= 3) ? strtol(argv[2],NULL,0) : DEFAULT_NUM_WORDS;
+    double	exponent	= (argc >= 4) ? strtod(argv[3],NULL) : DEFAULT_ZIPF_EXPONENT;
+    int		numDistinct	= (argc >= 5) ? strtol(argv[4],NULL,0) : 0;
+    long	seed		= (argc >= 6) ? strtol(argv[5],NULL,0) : 1;
+
+    if  ( (numWords < 1)  ||  (exponent <= 0)  ||  (numDistinct < 0) )
+    {
+      fprintf(stderr,"The number of words and the exponent must be positive.\n");
+      return(EXIT_FAILURE);
+    }
+
+    return(generateCorpus(numWords,exponent,numDistinct,seed));
+  }
+
+  if  (strcmp(argv[1],"suite") == 0)
+    return(benchmarkSuite( (argc >= 3) ? argv[2] : BENCHMARK_FILENAME ));
+
+  int	number	= (argc >= 3) ? strtol(argv[2],NULL,0) : 0;
+
+  if  ( (argc >= 3)  &&  (number < 1) )
+  {
+    fprintf(stderr,"The size must be positive.\n");
+    return(EXIT_FAILURE);
+  }
+
+  //  II.  Run benchmark:
+  if  (strcmp(argv[1],"tree") == 0)
+    benchmarkTree( (number > 0) ? number : DEFAULT_NUM_WORDS );
+  else
+  if  (strcmp(argv[1],"engines") == 0)
+    return(benchmarkEngines( (number > 0) ? number : DEFAULT_NUM_MEGABYTES ));
+  else
+  if  (strcmp(argv[1],"handoff") == 0)
+    return(benchmarkHandoff( (number > 0) ? number : DEFAULT_NUM_HANDOFF_WORDS ));
+  else
+  if  (strcmp(argv[1],"scaling") == 0)
+    return(benchmarkScaling( (number > 0) ? number : 4 * DEFAULT_NUM_MEGABYTES ));
+  else
+  if  (strcmp(argv[1],"tokenizer") == 0)
+    return(benchmarkTokenizer( (number > 0) ? number : DEFAULT_TOKENIZER_MEGABYTES ));
+  else
+  if  (strcmp(argv[1],"sketch") == 0)
+    return(benchmarkSketch( (number > 0) ? number : DEFAULT_SKETCH_KILOBYTES ));
+  else
+  if  (strcmp(argv[1],"layout") == 0)
+    return(benchmarkLayout( (number > 0) ? number : DEFAULT_LAYOUT_NUM_WORDS ));
+  else
+  if  (strcmp(argv[1],"stress") == 0)
+    return(benchmarkStress( (number > 0) ? number : DEFAULT_STRESS_NUM_WORDS ));
+  else
+  if  (strcmp(argv[1],"serialize") == 0)
+    return(benchmarkSerialize( (number > 0) ? number : DEFAULT_NUM_WORDS ));
+  else
+  {
+    fprintf(stderr,"%s",usageCPtr);
+    return(EXIT_FAILURE);
+  }
+
+  //  III.  Finished:
+  return(EXIT_SUCCESS);
+}
@@ -0,0 +1,428 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		histogramEngine.cpp					---*
+ *---									---*
+ *---	    This file defines the C-callable functions with which the	---*
+ *---	server histograms words in its own process, instead of running	---*
+ *---	a histogrammer process per request.				---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//	Compile into a library (linked together with protocol.c) with:
+//	$ g++ -O2 -c histogramEngine.cpp Corpus.cpp Tokenizer.cpp Histogram.cpp Node.cpp WordTable.cpp SpaceSaving.cpp Arena.cpp
+//	$ ar rcs libhistogram.a histogramEngine.o Corpus.o Tokenizer.o Histogram.o Node.o WordTable.o SpaceSaving.o Arena.o
+
+#include	"header.h"
+#include	<pthread.h>	// For pthread_mutex_lock()
+#include	"Arena.h"
+#include	"Histogram.h"
+#include	"WordTable.h"
+#include	"SpaceSaving.h"
+#include	"Tokenizer.h"
+#include	"Corpus.h"
+#include	"protocol.h"
+
+
+//  PURPOSE:  To tell how many counters a 'SpaceSaving' sketch has per word
+//	asked for by an approximate top-K request.  More counters make the
+//	counts closer and the top words likelier right.
+const int		SKETCH_COUNTERS_PER_K	= 8;
+
+
+//  PURPOSE:  To point to the current snapshot of the corpus, or to be 'NULL'
+//	before the first one is loaded.  Holds one reference to it.
+static Corpus*		currentCorpusPtr	= NULL;
+
+//  PURPOSE:  To count the snapshots made current so far, which numbers them:
+//	snapshot 'corpusVersion' is the current one.
+static uint64_t		corpusVersion		= 0;
+
+//  PURPOSE:  To guard 'currentCorpusPtr' and 'corpusVersion' while they are
+//	read or replaced.
+static pthread_mutex_t	corpusLock		= PTHREAD_MUTEX_INITIALIZER;
+
+
+//  PURPOSE:  To return the current snapshot of the corpus with one more
+//	reference to it, which the caller must 'release()', or 'NULL' if none
+//	is loaded.  Sets '*versionPtr' to its version, if 'versionPtr' is not
+//	'NULL'.
+static
+Corpus*		acquireCorpus	(uint64_t*	versionPtr
+				)
+{
+  Corpus*	corpusPtr;
+
+  pthread_mutex_lock(&corpusLock);
+  corpusPtr	= currentCorpusPtr;
+
+  if  (versionPtr != NULL)
+    *versionPtr	= corpusVersion;
+
+  if  (corpusPtr != NULL)
+    corpusPtr->acquire();
+
+  pthread_mutex_unlock(&corpusLock);
+  return(corpusPtr);
+}
+
+
+//  PURPOSE:  To make 'corpusPtr' the current snapshot, handing it the
+//	caller's reference, and to drop the reference to the old one.
+//	Requests still using the old one keep it until they release it.  No
+//	return value.
+static
+void		replaceCorpus	(Corpus*	corpusPtr
+				)
+{
+  Corpus*	oldCorpusPtr;
+
+  pthread_mutex_lock(&corpusLock);
+  oldCorpusPtr		= currentCorpusPtr;
+  currentCorpusPtr	= corpusPtr;
+  corpusVersion++;
+  pthread_mutex_unlock(&corpusLock);
+
+  if  (oldCorpusPtr != NULL)
+    oldCorpusPtr->release();
+}
+
+
+//  PURPOSE:  To load the file (or the directory or list of files)
+//	'filenameCPtr' as the corpus that 'countInProcess()' histograms, if no
+//	corpus is loaded yet or the files changed since it was.  Returns '1'
+//	if the current corpus is up to date or '0' if the files could not be
+//	loaded (in which case the old snapshot, if any, is kept).
+extern "C"
+int		loadCorpus	(const char*	filenameCPtr
+				)
+{
+  Corpus*	corpusPtr	= acquireCorpus(NULL);
+  uint64_t	stamp		= getCorpusStamp(filenameCPtr);
+  bool		isCurrent	= (corpusPtr != NULL)	&&
+				  (stamp != 0)		&&
+				  !corpusPtr->isStale(stamp);
+
+  if  (corpusPtr != NULL)
+    corpusPtr->release();
+
+  if  (isCurrent)
+    return(1);
+
+  corpusPtr	= new Corpus;
+
+  if  (!corpusPtr->load(filenameCPtr))
+  {
+    corpusPtr->release();
+    return(0);
+  }
+
+  replaceCorpus(corpusPtr);
+  return(1);
+}
+
+
+//  PURPOSE:  To return the version of the current snapshot of the corpus,
+//	which changes whenever 'loadCorpus()' loads a new one.  No
+//	parameters.
+extern "C"
+uint64_t	getCorpusVersion()
+{
+  uint64_t	version;
+
+  pthread_mutex_lock(&corpusLock);
+  version	= corpusVersion;
+  pthread_mutex_unlock(&corpusLock);
+  return(version);
+}
+
+
+//  PURPOSE:  To hold a histogram being made in this process, of a range of
+//	words of one snapshot of the corpus, so that it can be made a few
+//	words at a time.
+struct		HistogramTask
+{
+  //  PURPOSE:  To point to the snapshot, of which '*this' holds a reference.
+  Corpus*	corpusPtr;
+
+  //  PURPOSE:  To hold the counts so far.
+  WordTable	table;
+
+  //  PURPOSE:  To point to the histogram counted into: 'table', or a sketch
+  //	that replaces it.
+  Histogram*	histogramPtr;
+
+  //  PURPOSE:  To tell the index of the next word to count.
+  uint64_t	index;
+
+  //  PURPOSE:  To tell the number of words left to count.
+  uint64_t	numLeft;
+};
+
+
+//  PURPOSE:  To count about 'numWords' more words of '*taskPtr' (more if a
+//	whole block ends past them, fewer if fewer are left).  The histograms
+//	of whole blocks are merged (each made once per snapshot, see
+//	'Corpus::getBlock()'), so only the words at the edges of a range are
+//	counted one by one.  Counts into '*taskPtr->histogramPtr'.  No return
+//	value.
+static
+void		countSome	(HistogramTask*	taskPtr,
+				 uint64_t	numWords
+				)
+{
+  Corpus*	corpusPtr	= taskPtr->corpusPtr;
+  Histogram&	histogram	= *taskPtr->histogramPtr;
+  uint64_t	numCorpusWords	= corpusPtr->getNumWords();
+  uint64_t	index		= taskPtr->index;
+  uint64_t	numLeft		= taskPtr->numLeft;
+  uint64_t	numGoal		= (numWords < numLeft) ? numLeft - numWords : 0;
+  const char*	wordCPtr;
+  int		wordLen;
+
+  //  Each whole pass over the corpus counts every block once more:
+  if  (numLeft - numGoal >= numCorpusWords)
+  {
+    uint64_t	numPasses	= (numLeft - numGoal) / numCorpusWords;
+
+    for  (uint64_t block = 0;  block < corpusPtr->getNumBlocks();  block++)
+      merge(histogram,corpusPtr->getBlock(block),numPasses);
+
+    numLeft	-= numPasses * numCorpusWords;
+  }
+
+  //  Merge the histograms of the whole blocks the rest covers, and count the
+  //  words at its edges one by one:
+  while  (numLeft > numGoal)
+  {
+    uint64_t	block		= index / CORPUS_BLOCK_WORDS;
+    uint64_t	blockEnd	= (block + 1) * CORPUS_BLOCK_WORDS;
+
+    if  (blockEnd > numCorpusWords)
+      blockEnd	= numCorpusWords;
+
+    if  ( (index == block * CORPUS_BLOCK_WORDS)  &&  (blockEnd - index <= numLeft) )
+    {
+      merge(histogram,corpusPtr->getBlock(block),1);
+      numLeft	-= blockEnd - index;
+      index	=  blockEnd;
+    }
+    else
+    {
+      uint64_t	numHere		= numLeft - numGoal;
+
+      if  (numHere > blockEnd - index)
+	numHere	= blockEnd - index;
+
+      numLeft	-= numHere;
+
+      for  (uint64_t endIndex = index + numHere;  index < endIndex;  index++)
+      {
+	corpusPtr->getWord(index,&wordCPtr,&wordLen);
+	histogram.insert(wordCPtr,(wordLen < BUFFER_LEN) ? wordLen : BUFFER_LEN-1);
+      }
+    }
+
+    if  (index == numCorpusWords)
+      index	= 0;
+  }
+
+  taskPtr->index	= index;
+  taskPtr->numLeft	= numLeft;
+}
+
+
+//  PURPOSE:  To start histogramming, in this process, the 'wordCount' words
+//	starting at word 'wordIndex' (modulo the number of words) of the
+//	corpus 'loadCorpus()' loaded.  If 'shouldTrackDirty' is not '0' then
+//	'continueHistogram()' tells the counts that changed.  Sets
+//	'*versionPtr' to the version of the snapshot histogrammed.  Returns
+//	the task, to be passed to 'endHistogram()', or 'NULL' after setting
+//	'*statusPtr' to the status of the reply on error.
+extern "C"
+HistogramTask*	beginHistogram	(int		wordIndex,
+				 int		wordCount,
+				 int		shouldTrackDirty,
+				 uint64_t*	versionPtr,
+				 int*		statusPtr
+				)
+{
+  if  ( (wordIndex < 0)  ||  (wordCount < 1) )
+  {
+    *statusPtr	= STATUS_BAD_REQUEST;
+    return(NULL);
+  }
+
+  Corpus*	corpusPtr	= acquireCorpus(versionPtr);
+
+  if  ( (corpusPtr == NULL)  ||  (corpusPtr->getNumWords() == 0) )
+  {
+    if  (corpusPtr != NULL)
+      corpusPtr->release();
+
+    *statusPtr	= STATUS_ERROR;
+    return(NULL);
+  }
+
+  HistogramTask*	taskPtr	= new HistogramTask;
+
+  taskPtr->corpusPtr	= corpusPtr;
+  taskPtr->histogramPtr	= &taskPtr->table;
+  taskPtr->index	= (uint64_t)wordIndex % corpusPtr->getNumWords();
+  taskPtr->numLeft	= (uint64_t)wordCount;
+
+  if  (shouldTrackDirty)
+    taskPtr->table.trackDirty();
+
+  return(taskPtr);
+}
+
+
+//  PURPOSE:  To count about 'numWords' more words of '*taskPtr', and, if it
+//	tracks them, to add to '*deltaPtr' the words whose counts changed
+//	since the last call, with their counts so far, in alphabetical
+//	order.  If 'deltaPtr' is 'NULL' then the changed words are left to
+//	the next call.  Returns the number of words left to count.
+extern "C"
+int		continueHistogram
+				(HistogramTask*	taskPtr,
+				 int		numWords,
+				 struct Reply*	deltaPtr
+				)
+{
+  std::vector<WordCount>	entryVector;
+
+  countSome(taskPtr,numWords);
+
+  if  (deltaPtr == NULL)
+    return((int)taskPtr->numLeft);
+
+  taskPtr->table.getDirty(entryVector);
+
+  for  (size_t i = 0;  i < entryVector.size();  i++)
+    addReplyEntry(deltaPtr,entryVector[i].count,entryVector[i].wordCPtr,entryVector[i].wordLen);
+
+  return((int)taskPtr->numLeft);
+}
+
+
+//  PURPOSE:  To count the words left of '*taskPtr', to add its whole
+//	histogram to '*replyPtr' in alphabetical order, and to free it.
+//	Returns the status of the reply.
+extern "C"
+int		endHistogram	(HistogramTask*	taskPtr,
+				 struct Reply*	replyPtr
+				)
+{
+  std::vector<WordCount>	entryVector;
+
+  countSome(taskPtr,taskPtr->numLeft);
+
+  //  'table' holds its own copies of the words, so the corpus is no longer
+  //  needed:
+  taskPtr->corpusPtr->release();
+  taskPtr->table.getSorted(entryVector);
+
+  for  (size_t i = 0;  i < entryVector.size();  i++)
+    addReplyEntry(replyPtr,entryVector[i].count,entryVector[i].wordCPtr,entryVector[i].wordLen);
+
+  delete(taskPtr);
+  return(STATUS_OK);
+}
+
+
+//  PURPOSE:  To free '*taskPtr' without counting the words left of it.  No
+//	return value.
+extern "C"
+void		cancelHistogram	(HistogramTask*	taskPtr
+				)
+{
+  taskPtr->corpusPtr->release();
+  delete(taskPtr);
+}
+
+
+//  PURPOSE:  To histogram, in this process, the 'wordCount' words starting
+//	at word 'wordIndex' (modulo the number of words) of the corpus
+//	'loadCorpus()' loaded, and to add the histogram to '*replyPtr' in
+//	alphabetical order.  Sets '*versionPtr' to the version of the
+//	snapshot histogrammed.  Does no file I/O.  Returns the status of the
+//	reply.
+extern "C"
+int		histogramInProcess
+				(int		wordIndex,
+				 int		wordCount,
+				 struct Reply*	replyPtr,
+				 uint64_t*	versionPtr
+				)
+{
+  int			status;
+  HistogramTask*	taskPtr	= beginHistogram(wordIndex,wordCount,0,versionPtr,&status);
+
+  return( (taskPtr == NULL) ? status : endHistogram(taskPtr,replyPtr) );
+}
+
+
+//  PURPOSE:  To add to '*replyPtr' the 'k' most frequent of the 'wordCount'
+//	words starting at word 'wordIndex' (modulo the number of words) of
+//	the corpus 'loadCorpus()' loaded, the most frequent first, in this
+//	process.  If 'isApproximate' is '0' then they are picked exactly from
+//	the whole histogram.  Otherwise they are counted in a 'SpaceSaving'
+//	sketch of 'SKETCH_COUNTERS_PER_K*k' counters, so the request takes
+//	memory for that many words however many distinct words there are,
+//	and each count may be too high by at most 'wordCount' divided by the
+//	number of counters.  Sets '*versionPtr' to the version of the
+//	snapshot histogrammed.  Returns the status of the reply.
+extern "C"
+int		topInProcess	(int		wordIndex,
+				 int		wordCount,
+				 int		k,
+				 int		isApproximate,
+				 struct Reply*	replyPtr,
+				 uint64_t*	versionPtr
+				)
+{
+  if  (k < 1)
+    return(STATUS_BAD_REQUEST);
+
+  int			status;
+  HistogramTask*	taskPtr	= beginHistogram(wordIndex,wordCount,0,versionPtr,&status);
+
+  if  (taskPtr == NULL)
+    return(status);
+
+  std::vector<WordCount>	entryVector;
+  std::vector<WordCount>	topVector;
+  SpaceSaving*			sketchPtr	= NULL;
+
+  if  (isApproximate)
+  {
+    //  Fewer counters than words would do, if there are fewer words:
+    int	numCounters	= (k < wordCount / SKETCH_COUNTERS_PER_K)
+			  ? SKETCH_COUNTERS_PER_K * k
+			  : wordCount;
+
+    sketchPtr			= new SpaceSaving(numCounters);
+    taskPtr->histogramPtr	= sketchPtr;
+  }
+
+  countSome(taskPtr,taskPtr->numLeft);
+  taskPtr->corpusPtr->release();
+
+  if  (sketchPtr != NULL)
+    sketchPtr->getSorted(entryVector);
+  else
+    taskPtr->table.getUnsorted(entryVector);
+
+  selectTop(entryVector,k,topVector);
+
+  for  (size_t i = 0;  i < topVector.size();  i++)
+    addReplyEntry(replyPtr,topVector[i].count,topVector[i].wordCPtr,topVector[i].wordLen);
+
+  delete(sketchPtr);
+  delete(taskPtr);
+  return(STATUS_OK);
+}
@@ -13,10 +13,18 @@
 
 #include	"header.h"
 #include	<pthread.h>
-#include	"Node.h"
+#include	<time.h>
+#include	"Arena.h"
+#include	"Histogram.h"
+#include	"SpaceSaving.h"
+#include	"CountMinSketch.h"
+#include	"WordRing.h"
+#include	"Tokenizer.h"
+#include	"WordOffsetIndex.h"
+#include	"protocol.h"
 
 //	Compile with:
-//	$ g++ histogrammer.cpp Node.cpp -o histogrammer -lpthread
+//	$ g++ histogrammer.cpp WordOffsetIndex.cpp Tokenizer.cpp Histogram.cpp Node.cpp WordTable.cpp SpaceSaving.cpp CountMinSketch.cpp Arena.cpp -o histogrammer -lpthread
 
 
 
@@ -26,9 +34,12 @@
 //									//
 //	----	----	----	----	----	----	----	----	//
 
-const int	LINE_LEN		= 4096;
+//  PURPOSE:  To tell the most counting threads that may be asked for.
+const int	MAX_NUM_COUNTERS	= 256;
 
-#define		SEPARATORY_CHAR_ARRAY	" \t\n\r.!,:;?<>()[]{}\\\"|+-*%=^&/"
+//  PURPOSE:  To tell that no word count was given, and so words are read
+//	until 'SIGINT' is received.
+const int	UNTIL_SIGINT		= -1;
 
 
 
@@ -42,21 +53,61 @@ const int	LINE_LEN		= 4096;
 //  PURPOSE:  To tell the index of the word at which to start.
 int		wordIndex;
 
-//  PURPOSE:  To hold the address of the next word to histogram.
-const char*	wordPtr	= NULL;
+//  PURPOSE:  To tell the number of words to histogram, or 'UNTIL_SIGINT' if
+//	words should be histogrammed until 'SIGINT' is received.
+int		wordCount	= UNTIL_SIGINT;
+
+//  PURPOSE:  To tell the file whose words are histogrammed, or the directory
+//	or "@listFile" list of files whose words, one file after the other,
+//	are.
+const char*	corpusCPtr	= FILENAME;
+
+//  PURPOSE:  To tell the name of the counting engine ("tree" or "hash").
+const char*	engineCPtr	= "tree";
+
+//  PURPOSE:  To tell the number of kilobytes that approximate counting may
+//	use, shared by the counting threads, or '0' if words should be
+//	counted exactly.
+int		sketchKilobytes	= 0;
+
+//  PURPOSE:  To tell the number of most frequent words to print, or '0' if
+//	the whole histogram should be printed.
+int		topK		= 0;
+
+//  PURPOSE:  To hold 'true' if the histogram should be printed as binary
+//	entries (a 'u32' count, a 'u16' word length and the word), or 'false'
+//	if as "count\tword" lines.
+bool		isBinary	= false;
+
+//  PURPOSE:  To hold 'true' if requests should be read from standard input
+//	and answered one after the other until it closes (as the server's
+//	pool of histogrammers does), or 'false' if the command line tells the
+//	one range to histogram.
+bool		shouldServe	= false;
+
+//  PURPOSE:  To hold 'true' if the words/sec of the reading and counting
+//	should be reported on 'stderr', or 'false' otherwise.
+bool		shouldReportStats	= false;
 
 //  PURPOSE:  To hold 'true' while the program should still run,
 //	or 'false' otherwise.
-bool		shouldRun	= true;
+volatile bool	shouldRun	= true;
 
-//  PURPOSE:  To control access to 'wordPtr'.
-pthread_mutex_t	wordPtrLock;
+//  PURPOSE:  To tell the number of counting threads.
+int		numCounters	= 1;
 
-//  PURPOSE:  To be signaled on when 'wordPtr' is set to the address of a word.
-pthread_cond_t	wordPtrSet;
 
-//  PURPOSE:  To be signaled on when 'wordPtr' is set to 'NULL'
-pthread_cond_t	wordPtrClear;
+//  PURPOSE:  To hold what one counting thread needs: the ring its batches
+//	come in on, the histogram it counts into, and, once counting is done,
+//	that histogram as a sorted run.
+struct		Counter
+{
+  WordRing		ring;
+  Histogram*		histogramPtr;
+  std::vector<WordCount> sortedRun;
+  long			numWordsCounted;
+  pthread_t		threadId;
+};
 
 
 //	----	----	----	----	----	----	----	----	//
@@ -71,155 +122,232 @@ void		exitFailure	(const char*	errorMsgCPtr
 				)
 {
   fprintf(stderr,"%s\n",errorMsgCPtr);
-  printf("-1\n");
+
+  //  Only a reader of text can tell the '-1' of an error:
+  if  ( !isBinary  &&  !shouldServe )
+    printf("-1\n");
+
   exit(EXIT_FAILURE);
 }
 
 
-//  PURPOSE:  To return the next word in the file being read by 'inputPtr'.  If
-//	at end of file then 'rewind()'s to beginning of file and re-reads first.
-//	If there are no words then 'exit()'s process with 'EXIT_FAILURE'.  No
-//	parameters.
-const char*	getNextWord	(FILE*		inputPtr
+//  PURPOSE:  To return the next word from 'tokenizer' in '*wordCPtrPtr' and
+//	its length in '*wordLenPtr'.  If at end of file then wraps to the
+//	beginning of file.  If there are no words then 'exit()'s process with
+//	'EXIT_FAILURE'.  No return value.
+void		getNextWord	(Tokenizer&	tokenizer,
+				 const char**	wordCPtrPtr,
+				 int*		wordLenPtr
 				)
 {
-  static
-  char		line[LINE_LEN];
-  static
-  char*		localTokenPtr	= NULL;
-  const char*	toReturn;
-  int		rewindCount	= 0;
-
-  while  (localTokenPtr == NULL)
+  if  (!tokenizer.getNextWord(wordCPtrPtr,wordLenPtr))
   {
-    if  (fgets(line,LINE_LEN,inputPtr) == NULL)
+    exitFailure( (tokenizer.getTextLen() == 0) ? "Empty file!" : "No words in file!" );
+  }
+}
+
+
+//  PURPOSE:  To set global vars 'wordIndex', 'wordCount', 'corpusCPtr',
+//	'engineCPtr', 'numCounters', 'topK', 'sketchKilobytes', 'isBinary',
+//	'shouldServe' and 'shouldReportStats' to legal values from the 'argc' command line
+//	arguments given in 'argv[]'.  With "--serve", 'wordIndex',
+//	'wordCount' and 'topK' come later, with each request.
+//	Prints error message and 'exit()'s with 'EXIT_FAILURE' on error.  No
+//	return value.
+void		initializeWordIndexAndCount
+				(int		argc,
+				 char*		argv[]
+				)
+{
+  const char*	usageCPtr	= "Usage:\thistogrammer [--corpus=path] [--engine=tree|hash] [-j numThreads] [--top=K] [--sketch=kilobytes] [--binary] [--stats] 'wordIndex' ['wordCount']\n"
+				  "\thistogrammer --serve [--corpus=path] [--engine=tree|hash] [-j numThreads] [--stats]\n"
+				  "(path is a file, a directory or @listFile, " FILENAME " by default)";
+  int		argIndex	= 1;
+
+  for  ( ;  (argIndex < argc) && (argv[argIndex][0] == '-');  argIndex++)
+  {
+    if  ( (strcmp(argv[argIndex],"-j") == 0)  &&  (argIndex+1 < argc) )
     {
-      if  (rewindCount > 0)
+      numCounters	= strtol(argv[++argIndex],NULL,0);
+
+      if  ( (numCounters < 1)  ||  (numCounters > MAX_NUM_COUNTERS) )
       {
-        exitFailure("No words in file!");
+        exitFailure("'numThreads' must be from 1 to 256.");
       }
+    }
+    else
+    if  (strncmp(argv[argIndex],"--engine=",9) == 0)
+      engineCPtr	= argv[argIndex] + 9;
+    else
+    if  (strncmp(argv[argIndex],"--corpus=",9) == 0)
+      corpusCPtr	= argv[argIndex] + 9;
+    else
+    if  (strcmp(argv[argIndex],"--stats") == 0)
+      shouldReportStats	= true;
+    else
+    if  (strcmp(argv[argIndex],"--binary") == 0)
+      isBinary	= true;
+    else
+    if  (strcmp(argv[argIndex],"--serve") == 0)
+      shouldServe	= true;
+    else
+    if  (strncmp(argv[argIndex],"--sketch=",9) == 0)
+    {
+      sketchKilobytes	= strtol(argv[argIndex] + 9,NULL,0);
 
-      rewind(inputPtr);
-      rewindCount++;
-
-      if  (fgets(line,LINE_LEN,inputPtr) == NULL)
+      if  (sketchKilobytes < 1)
       {
-        exitFailure("Empty file!");
+        exitFailure("'kilobytes' must be positive.");
       }
-
     }
+    else
+    if  (strncmp(argv[argIndex],"--top=",6) == 0)
+    {
+      topK	= strtol(argv[argIndex] + 6,NULL,0);
 
-    localTokenPtr	= strtok(line,SEPARATORY_CHAR_ARRAY);
+      if  (topK < 1)
+      {
+        exitFailure("'K' must be positive.");
+      }
+    }
+    else
+      exitFailure(usageCPtr);
   }
 
-  toReturn	= localTokenPtr;
-  localTokenPtr	= strtok(NULL,SEPARATORY_CHAR_ARRAY);
-  return(toReturn);
-}
+  if  (shouldServe)
+  {
+    if  ( (argIndex < argc)  ||  (sketchKilobytes > 0) )
+    {
+      exitFailure(usageCPtr);
+    }
 
+    return;
+  }
 
-//  PURPOSE:  To set global vars 'wordIndex' to a legal value from
-//	the 'argc' command line arguments given in 'argv[]'.  Prints error
-//	message and 'exit()'s with 'EXIT_FAILURE' on error.  No return value.
-void		initializeWordIndexAndCount
-				(int		argc,
-				 char*		argv[]
-				)
-{
-  if  (argc < 2)
+  if  (argIndex >= argc)
   {
-    exitFailure("Usage:\thistogrammer 'wordIndex'");
+    exitFailure(usageCPtr);
   }
 
-  wordIndex	= strtol(argv[1],NULL,0);
+  wordIndex	= strtol(argv[argIndex],NULL,0);
 
   if  (wordIndex < 0)
   {
     exitFailure("'wordIndex' must be non-negative.");
   }
 
+  if  (++argIndex < argc)
+  {
+    wordCount	= strtol(argv[argIndex],NULL,0);
+
+    if  (wordCount < 1)
+    {
+      exitFailure("'wordCount' must be positive.");
+    }
+  }
+
 }
 
 
-//  PURPOSE:  To attempt to initialize 'inputPtr' by fopen()ing 'FILENAME'.
-//	Prints error message and 'exit()'s with 'EXIT_FAILURE' on error.
-//	Return ptr to open file.
-FILE*		initializeFilePtr
-				()
+//  PURPOSE:  To attempt to initialize 'tokenizer' by memory-mapping the
+//	files 'corpusCPtr' names, one after the other, and 'index' by loading
+//	(or making, a file per thread) their word-offset indices.  Prints
+//	error message and 'exit()'s with 'EXIT_FAILURE' on error.  No return
+//	value.
+void		initializeTokenizer
+				(Tokenizer&		tokenizer,
+				 WordOffsetIndex&	index
+				)
 {
-  FILE*	inputPtr	= fopen(FILENAME,"r");
+  std::vector<std::string>	filenameVector;
 
-  if  (inputPtr == NULL)
+  if  ( !listCorpusFiles(corpusCPtr,filenameVector)	||
+	!tokenizer.open(filenameVector)			||
+	!index.loadOrBuild(filenameVector,tokenizer)
+      )
   {
-    exitFailure("Cannot open " FILENAME);
+    exitFailure( (std::string("Cannot open ") + corpusCPtr).c_str() );
   }
-
-  return(inputPtr);
 }
 
 
-//  PURPOSE:  To be run by the histogram-making thread, which makes a tree
+//  PURPOSE:  To be run by each histogram-making thread, which makes a tree
 //	that represents a map (in C++ terms) or a dictionary (in Java terms)
-//	of words to the number of times that they have been read.  Ignores
-//	'vPtr'.  Returns 'NULL'.
+//	of words to the number of times that they have been read.  Words come
+//	a batch at a time from the ring of the 'Counter' that 'vPtr' points
+//	to.  When there are no more, the histogram is sorted into the
+//	counter's 'sortedRun', so the threads sort in parallel.  Returns
+//	'NULL'.
 void*		histogramMaker	(void*		vPtr
 				)
 {
-  Node*	rootPtr	= NULL;
+  Counter*		counterPtr	= (Counter*)vPtr;
+  Histogram*		histogramPtr	= counterPtr->histogramPtr;
+  const WordBatch*	batchPtr;
 
-  while  (shouldRun)
+  while  ( (batchPtr = counterPtr->ring.getFullBatch()) != NULL )
   {
+    for  (int i = 0;  i < batchPtr->numWords;  i++)
+      histogramPtr->insert(batchPtr->text + batchPtr->startArray[i],
+			   batchPtr->lenArray[i]
+			  );
 
-
-	pthread_mutex_lock(&wordPtrLock);
-	if (wordPtr == NULL)
-		pthread_cond_wait(&wordPtrSet, &wordPtrLock);
-	
-   
-    if  (rootPtr == NULL)
-      rootPtr	= new Node(wordPtr);
-    else
-      insert(rootPtr,wordPtr);
-
-    wordPtr	= NULL;
-
-	
-	pthread_mutex_unlock(&wordPtrLock);
-	pthread_cond_signal(&wordPtrClear);
-	
-  
+    counterPtr->numWordsCounted	+= batchPtr->numWords;
+    counterPtr->ring.release();
   }
 
-  print(rootPtr);
-  delete(rootPtr);
+  histogramPtr->getSorted(counterPtr->sortedRun);
   return(NULL);
 }
 
 
-//  PURPOSE:  To keep reading words until 'shouldRun' becomes 'false'.  Words
-//  	read from 'inputPtr', and 'wordPtr' set to point to them, so the
-//	counting thread can count them.  No return value.
-void		reader		(FILE*		inputPtr
+//  PURPOSE:  To read 'wordCount' words, or to keep reading words until
+//	'shouldRun' becomes 'false' if 'wordCount' is 'UNTIL_SIGINT'.  Words
+//  	read from 'tokenizer' are copied into batches, and each full batch
+//	is published to the ring of the next of the 'numCounters' counters of
+//	'counterArray', round-robin, so each counting thread gets an equal
+//	share of the word range.  No return value.
+void		reader		(Tokenizer&	tokenizer,
+				 Counter*	counterArray
 				)
 {
-  while  (shouldRun)
+  int		counterIndex	= 0;
+  WordBatch*	batchPtr	= counterArray[0].ring.getEmptyBatch();
+
+  for  (int numRead = 0;
+	(wordCount == UNTIL_SIGINT) ? shouldRun : (numRead < wordCount);
+	numRead++
+       )
   {
-    sleep(1);	
+    if  (!batchPtr->hasRoom())
+    {
+      counterArray[counterIndex].ring.publish();
+      counterIndex	= (counterIndex + 1) % numCounters;
+      batchPtr		= counterArray[counterIndex].ring.getEmptyBatch();
+    }
 
-  
-	
-	pthread_mutex_lock(&wordPtrLock);
-	if (wordPtr != NULL)
-		pthread_cond_wait(&wordPtrClear, &wordPtrLock);
-	
-   
-    wordPtr	= getNextWord(inputPtr);
-
-	pthread_mutex_unlock(&wordPtrLock);
-	pthread_cond_signal(&wordPtrSet);
-	
-   
+    const char*	wordCPtr;
+    int		wordLen;
+
+    getNextWord(tokenizer,&wordCPtr,&wordLen);
+    batchPtr->add(wordCPtr,wordLen);
   }
+
+  counterArray[counterIndex].ring.publish();
+
+  for  (int i = 0;  i < numCounters;  i++)
+    counterArray[i].ring.finish();
+}
+
+
+//  PURPOSE:  To return the current monotonic time in seconds.  No
+//	parameters.
+double		now		()
+{
+  struct timespec	ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return(ts.tv_sec + ts.tv_nsec / 1e9);
 }
 
 
@@ -249,42 +377,199 @@ void		installSigIntHandler
 }
 
 
+//  PURPOSE:  To print out the sorted entries of 'entryVector': on their own,
+//	as 'isBinary' says, or, when serving, in binary after their length.
+//	No return value.
+void		output		(const std::vector<WordCount>&	entryVector
+				)
+{
+  if  (!shouldServe)
+  {
+    print(entryVector,isBinary);
+    return;
+  }
+
+  size_t	len		= getSerializedLen(entryVector,true);
+  char*		bufferPtr	= (char*)malloc(sizeof(uint32_t) + len);
+
+  if  (bufferPtr == NULL)
+  {
+    exitFailure("Out of memory");
+  }
+
+  putU32(bufferPtr,len);
+  serialize(entryVector,true,bufferPtr+sizeof(uint32_t));
+  writeAll(STDOUT_FILENO,bufferPtr,sizeof(uint32_t) + len);
+  free(bufferPtr);
+}
+
+
+//  PURPOSE:  To histogram 'wordCount' words (or until 'SIGINT') starting at
+//	word 'wordIndex' of 'tokenizer', found through 'index', with
+//	'numCounters' counting threads, and to print out the histogram (or
+//	its 'topK' most frequent words).  No return value.
+void		histogramRange	(Tokenizer&		tokenizer,
+				 WordOffsetIndex&	index
+				)
+{
+  Counter*		counterArray;
+  double		startTime;
+  long			numWordsCounted	= 0;
+
+  //  I.  Initialize vars:
+  counterArray	= new Counter[numCounters];
+
+  for  (int i = 0;  i < numCounters;  i++)
+  {
+    //  Every sketch gets the same share, so that they can be added up:
+    counterArray[i].histogramPtr	= (sketchKilobytes > 0)
+					  ? new CountMinSketch((size_t)sketchKilobytes*1024/numCounters)
+					  : newHistogram(engineCPtr);
+    counterArray[i].numWordsCounted	= 0;
+
+    if  (counterArray[i].histogramPtr == NULL)
+    {
+      exitFailure("'engine' must be \"tree\" or \"hash\".");
+    }
+  }
+
+  //  II.  Fast-forward for first indexed word, wrapping around the end of
+  //	   the file, from the nearest checkpoint of the index:
+  if  (!index.seek(tokenizer,wordIndex))
+  {
+    exitFailure( (tokenizer.getTextLen() == 0) ? "Empty file!" : "No words in file!" );
+  }
+
+  //  III.  Start histogramming threads:
+  startTime	= now();
+
+  for  (int i = 0;  i < numCounters;  i++)
+    pthread_create(&counterArray[i].threadId,NULL,histogramMaker,&counterArray[i]);
+
+  //  IV.  The parent reads 'wordCount' words, or until 'shouldRun' set to
+  //	   'false':
+  reader(tokenizer,counterArray);
+
+  //  V.  Reading is over, wait for child threads to count the rest:
+  for  (int i = 0;  i < numCounters;  i++)
+  {
+    pthread_join(counterArray[i].threadId,NULL);
+    numWordsCounted	+= counterArray[i].numWordsCounted;
+  }
+
+  if  (shouldReportStats)
+  {
+    double	secs	= now() - startTime;
+
+    fprintf(stderr,"histogrammer: %ld words in %.3f s (%.0f words/sec)\n",
+	    numWordsCounted,secs,(secs > 0) ? numWordsCounted/secs : 0.0
+	   );
+  }
+
+  //  VI.  Output histogram (or its most frequent words), merging the sorted
+  //	   runs of the threads, or their sketches:
+  std::vector<WordCount>	entryVector;
+  CountMinSketch*		sketchPtr	= NULL;
+
+  if  (sketchKilobytes > 0)
+  {
+    sketchPtr	= (CountMinSketch*)counterArray[0].histogramPtr;
+
+    for  (int i = 1;  i < numCounters;  i++)
+      sketchPtr->absorb(*(CountMinSketch*)counterArray[i].histogramPtr);
+
+    sketchPtr->getSorted(entryVector);
+  }
+  else
+  if  (numCounters == 1)
+    entryVector.swap(counterArray[0].sortedRun);
+  else
+  {
+    std::vector< std::vector<WordCount> >	runVector(numCounters);
+
+    for  (int i = 0;  i < numCounters;  i++)
+      runVector[i].swap(counterArray[i].sortedRun);
+
+    mergeSorted(runVector,entryVector);
+  }
+
+  if  (topK > 0)
+  {
+    std::vector<WordCount>	topVector;
+
+    selectTop(entryVector,topK,topVector);
+    output(topVector);
+  }
+  else
+    output(entryVector);
+
+  if  ( (sketchPtr != NULL)  &&  !isBinary )
+    printf("#\tapproximate: of %lu words, only the %d most frequent are listed, "
+	   "each count too high by at most %lu, with probability %.3f\n",
+	   (unsigned long)sketchPtr->getNumWords(),sketchPtr->getNumDistinct(),
+	   (unsigned long)sketchPtr->getMaxError(),1 - sketchPtr->getFailureOdds()
+	  );
+
+  //  VII.  Release resources:
+  for  (int i = 0;  i < numCounters;  i++)
+    delete(counterArray[i].histogramPtr);
+
+  delete[](counterArray);
+}
+
+
+//  PURPOSE:  To tell the server with 'SERVE_READY_LEN' that 'tokenizer' and
+//	'index' are loaded, and then to answer, one after the other, the
+//	requests that come on standard input as "wordIndex wordCount topK"
+//	lines, until it closes.  Each is answered on standard output as
+//	'output()' serves it, or with 'SERVE_ERROR_LEN' if it is not legal.
+//	'tokenizer' and 'index' stay loaded in between.  No return value.
+void		serve		(Tokenizer&		tokenizer,
+				 WordOffsetIndex&	index
+				)
+{
+  char	line[BUFFER_LEN];
+  char	readyBytes[sizeof(uint32_t)];
+
+  putU32(readyBytes,SERVE_READY_LEN);
+  writeAll(STDOUT_FILENO,readyBytes,sizeof(readyBytes));
+
+  while  (fgets(line,sizeof(line),stdin) != NULL)
+  {
+    if  ( (sscanf(line,"%d %d %d",&wordIndex,&wordCount,&topK) != 3)	||
+	  (wordIndex < 0)  ||  (wordCount < 1)  ||  (topK < 0)
+	)
+    {
+      char	errorBytes[sizeof(uint32_t)];
+
+      putU32(errorBytes,SERVE_ERROR_LEN);
+      writeAll(STDOUT_FILENO,errorBytes,sizeof(errorBytes));
+      continue;
+    }
+
+    histogramRange(tokenizer,index);
+  }
+}
+
+
 int		main		(int		argc,
 				 char*		argv[]
 				)
 {
   //  I.  Application validity check (done below):
 
-  //  II.  Make histogram:
-  pthread_t		histogramThread;
-  FILE*			inputPtr;
+  //  II.  Make histogram(s):
+  Tokenizer		tokenizer;
+  WordOffsetIndex	index;
 
-  //  II.A.  Initialize vars:
-  pthread_mutex_init(&wordPtrLock,NULL);
-  pthread_cond_init(&wordPtrSet,NULL);
-  pthread_cond_init(&wordPtrClear,NULL);
   initializeWordIndexAndCount(argc,argv);
   installSigIntHandler();
-  inputPtr	= initializeFilePtr();
-
-  //  II.B.  Fast-forward for first indexed word:
-  while  (wordIndex-- > 0)
-    getNextWord(inputPtr);
-
-  //  II.C.   Start histogramming thread:
-  pthread_create(&histogramThread,NULL,histogramMaker,NULL);
-
-  //  II.D.   The parent reads words until 'shouldRun' set to 'false':
-  reader(inputPtr);
-
-  //  II.E.  Reading is over, tell child thread to stop, and wait for it:
-  pthread_join(histogramThread,NULL);
+  initializeTokenizer(tokenizer,index);
 
-  //  II.F.  Release resources:
-  pthread_cond_destroy(&wordPtrClear);
-  pthread_cond_destroy(&wordPtrSet);
-  pthread_mutex_destroy(&wordPtrLock);
-  fclose(inputPtr);
+  if  (shouldServe)
+    serve(tokenizer,index);
+  else
+    histogramRange(tokenizer,index);
 
   //  III. Finished:
   return(EXIT_SUCCESS);  
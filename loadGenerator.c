@@ -0,0 +1,856 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		loadGenerator.c						---*
+ *---									---*
+ *---	    This file defines a C program that runs many concurrent	---*
+ *---	clients against wordHistogramServer and reports the number of	---*
+ *---	requests it served per second and their latency.		---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//	Compile with:
+//	$ gcc -O2 loadGenerator.c protocol.c -o loadGenerator -lm
+
+//	Run with, for example:
+//	$ ./loadGenerator --v2 localhost 20001 10000 2 0 1000
+//	$ ./loadGenerator --pipeline=16 localhost 20001 32 1000 0 1000
+//	$ ./loadGenerator --cold --v2 localhost 20001 32 100 0 100000
+//	$ ./loadGenerator --rate=200 --json --v2 localhost 20001 64 100 0 10000
+
+//---		Header file inclusion					---//
+
+#include	"header.h"
+#include	"protocol.h"
+#include	<getopt.h>	// For getopt_long()
+#include	<time.h>	// For clock_gettime()
+#include	<sys/epoll.h>	// For epoll_create1(), epoll_ctl(), epoll_wait()
+#include	<sys/resource.h>	// For setrlimit()
+#include	<math.h>	// For log()
+
+
+//---		Definition of constants:				---//
+
+//  PURPOSE:  To tell the most events one 'epoll_wait()' returns.
+#define		EPOLL_MAX_EVENTS	256
+
+//  PURPOSE:  To tell the number of bytes read from a socket at once.
+#define		READ_BUFFER_LEN		65536
+
+//  PURPOSE:  To tell the most requests one client keeps under way at once,
+//	which is as many as the server reads ahead on one connection.
+#define		PIPELINE_MAX_DEPTH	64
+
+
+//---		Definition of global vars:				---//
+
+//  PURPOSE:  To hold the address of the server.
+struct sockaddr_in	serverAddr;
+
+//  PURPOSE:  To tell the number of requests each client makes.
+int		requestsPerClient;
+
+//  PURPOSE:  To tell the index of the first word each request histograms,
+//	or the first request if 'isCold'.
+int		wordIndex;
+
+//  PURPOSE:  To be non-zero if every request should histogram a different
+//	range of words (starting one word after the one before), so that none
+//	is served from the server's cache, or '0' if all should histogram the
+//	same range.
+int		isCold		= 0;
+
+//  PURPOSE:  To tell the number of words each request histograms.
+int		wordCount;
+
+//  PURPOSE:  To tell the protocol version of the requests.
+int		protocolVersion	= PROTOCOL_V1;
+
+//  PURPOSE:  To tell the number of requests each client keeps under way at
+//	once over one persistent (version 2) connection, or '0' if each
+//	request gets its own connection.
+int		pipelineDepth	= 0;
+
+//  PURPOSE:  To tell the number of requests per second to start, whether or
+//	not earlier ones were answered (an open loop), or '0' if each client
+//	starts its next request when its last one is answered (a closed loop).
+double		requestRate	= 0;
+
+//  PURPOSE:  To be non-zero if the results should be printed as one JSON
+//	object, or '0' if they should be printed as text.
+int		shouldPrintJson	= 0;
+
+//  PURPOSE:  To hold the clients with no request under way, in an open
+//	loop, and to tell their number.
+struct Client**	idleArray;
+int		numIdle		= 0;
+
+//  PURPOSE:  To hold the epoll instance that watches every client.
+int		epollFd;
+
+//  PURPOSE:  To hold the latency, in seconds, of every served request.
+double*		latencyArray;
+
+//  PURPOSE:  To tell the number of latencies in 'latencyArray'.
+int		numServed	= 0;
+
+//  PURPOSE:  To tell the number of requests that failed.
+int		numFailed	= 0;
+
+//  PURPOSE:  To tell the number of the failed requests that the server
+//	was too busy to queue.
+int		numBusy		= 0;
+
+
+//---		Definition of types:					---//
+
+//  PURPOSE:  To hold the state of one client.  A client makes
+//	'requestsPerClient' requests one after the other, each over its own
+//	connection, or, if 'pipelineDepth' is not '0', all over one
+//	connection with up to 'pipelineDepth' of them under way at once.
+struct		Client
+{
+  int		fd;
+  int		numMade;
+  int		numReceived;
+  double*	sendTimeArray;
+  int		isConnected;
+  double	startTime;
+  unsigned char	countBytes[sizeof(int)];
+  int		countLen;
+  int		count;
+  int		isInWord;
+  char		header[PROTOCOL_V2_HEADER_LEN];
+  size_t	headerLen;
+  size_t	payloadLeft;
+};
+
+
+//---		Definition of functions:				---//
+
+//  PURPOSE:  To return the index of the first word the next request should
+//	histogram.  No parameters.
+int		getNextWordIndex()
+{
+  static int	numAsked	= 0;
+
+  return( isCold ? wordIndex + numAsked++ : wordIndex );
+}
+
+
+//  PURPOSE:  To return the current time in seconds.  No parameters.
+double		now		()
+{
+  struct timespec	ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return(ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+
+//  PURPOSE:  To begin a request of 'clientPtr' due at time 'startTime', by
+//	beginning a non-blocking connect to the server.  Returns '1' on
+//	success or '0' (counting the request as failed) otherwise.
+int		beginRequest	(struct Client*	clientPtr,
+				 double		startTime
+				)
+{
+  struct epoll_event	event;
+  int			fd	= socket(AF_INET,SOCK_STREAM | SOCK_NONBLOCK,0);
+
+  if  (fd < 0)
+  {
+    numFailed++;
+    return(0);
+  }
+
+  if  ( (connect(fd,(struct sockaddr*)&serverAddr,sizeof(serverAddr)) < 0)  &&
+	(errno != EINPROGRESS)
+      )
+  {
+    close(fd);
+    numFailed++;
+    return(0);
+  }
+
+  clientPtr->fd		= fd;
+  clientPtr->isConnected	= 0;
+  clientPtr->startTime	= startTime;
+  clientPtr->countLen		= 0;
+  clientPtr->isInWord		= 0;
+  clientPtr->headerLen	= 0;
+  event.events		= EPOLLOUT;
+  event.data.ptr	= clientPtr;
+  epoll_ctl(epollFd,EPOLL_CTL_ADD,fd,&event);
+  return(1);
+}
+
+
+//  PURPOSE:  To start the next request of 'clientPtr', if it has one left.
+//	In an open loop, 'clientPtr' instead goes idle until 'main()' starts
+//	the next request due.  Returns '1' if a request was started or '0' if
+//	'clientPtr' is done (or idle).
+int		startRequest	(struct Client*	clientPtr
+				)
+{
+  if  (requestRate > 0)
+  {
+    idleArray[numIdle++]	= clientPtr;
+    return(0);
+  }
+
+  while  (clientPtr->numMade < requestsPerClient)
+  {
+    clientPtr->numMade++;
+
+    if  (beginRequest(clientPtr,now()))
+      return(1);
+  }
+
+  return(0);
+}
+
+
+//  PURPOSE:  To end the current request of 'clientPtr', noting its latency
+//	(from when it was due) if 'isOk' is non-zero or its failure
+//	otherwise, and to start its next one.  Returns '1' if 'clientPtr' started another request or '0' if it
+//	is done.
+int		endRequest	(struct Client*	clientPtr,
+				 int		isOk
+				)
+{
+  close(clientPtr->fd);
+
+  if  (isOk)
+    latencyArray[numServed++]	= now() - clientPtr->startTime;
+  else
+    numFailed++;
+
+  return(startRequest(clientPtr));
+}
+
+
+//  PURPOSE:  To send the request of 'clientPtr' once its connection is up.
+//	Returns '1' if 'clientPtr' still has requests under way or '0' if it
+//	is done.
+int		sendRequest	(struct Client*	clientPtr
+				)
+{
+  int			error		= 0;
+  socklen_t		errorLen	= sizeof(error);
+  struct Request	request;
+  char			requestBytes[PROTOCOL_MAX_REQUEST_LEN];
+
+  getsockopt(clientPtr->fd,SOL_SOCKET,SO_ERROR,&error,&errorLen);
+
+  if  (error != 0)
+    return(endRequest(clientPtr,0));
+
+  memset(&request,'\0',sizeof(request));
+  request.version	= protocolVersion;
+  request.opcode	= OPCODE_HISTOGRAM;
+  request.wordIndex	= getNextWordIndex();
+  request.wordCount	= wordCount;
+
+  size_t		requestLen	= encodeRequest(&request,requestBytes);
+
+  //  A request always fits in a new socket's send buffer:
+  if  (write(clientPtr->fd,requestBytes,requestLen) != (ssize_t)requestLen)
+    return(endRequest(clientPtr,0));
+
+  struct epoll_event	event;
+
+  clientPtr->isConnected	= 1;
+  event.events			= EPOLLIN;
+  event.data.ptr		= clientPtr;
+  epoll_ctl(epollFd,EPOLL_CTL_MOD,clientPtr->fd,&event);
+  return(1);
+}
+
+
+//  PURPOSE:  To note the 'numBytes' bytes at 'bytePtr' of a version 2 reply
+//	to 'clientPtr': its header, then as many payload bytes as the header
+//	tells.  Returns '-1' if the reply needs more bytes, or else (it ended)
+//	'1' if 'clientPtr' still has requests under way or '0' if it is done.
+int		readV2Reply	(struct Client*	clientPtr,
+				 const char*	bytePtr,
+				 size_t		numBytes
+				)
+{
+  if  (clientPtr->headerLen < PROTOCOL_V2_HEADER_LEN)
+  {
+    size_t	len	= PROTOCOL_V2_HEADER_LEN - clientPtr->headerLen;
+
+    if  (len > numBytes)
+      len	= numBytes;
+
+    memcpy(clientPtr->header + clientPtr->headerLen,bytePtr,len);
+    clientPtr->headerLen	+= len;
+    bytePtr			+= len;
+    numBytes			-= len;
+
+    if  (clientPtr->headerLen < PROTOCOL_V2_HEADER_LEN)
+      return(-1);
+
+    if  (getU32(clientPtr->header) != PROTOCOL_MAGIC)
+      return(endRequest(clientPtr,0));
+
+    clientPtr->payloadLeft	= getU32(clientPtr->header+16);
+  }
+
+  clientPtr->payloadLeft	-= (numBytes < clientPtr->payloadLeft)
+				   ? numBytes
+				   : clientPtr->payloadLeft;
+
+  if  (clientPtr->payloadLeft > 0)
+    return(-1);
+
+  if  (getU16(clientPtr->header+4) == STATUS_BUSY)
+    numBusy++;
+
+  return(endRequest(clientPtr,getU16(clientPtr->header+4) == STATUS_OK));
+}
+
+
+//  PURPOSE:  To read what is available of the reply to 'clientPtr'.  In
+//	version 1 each entry is a count in network byte order, then chars up
+//	to and including '\n', and the count '0' ends the reply.  Returns
+//	'1' if 'clientPtr' still has requests under way or '0' if it is done.
+int		readReply	(struct Client*	clientPtr
+				)
+{
+  static char	buffer[READ_BUFFER_LEN];
+
+  while  (1)
+  {
+    ssize_t	numRead	= read(clientPtr->fd,buffer,sizeof(buffer));
+
+    if  (numRead < 0)
+    {
+      if  (errno == EINTR)
+	continue;
+
+      if  ( (errno == EAGAIN)  ||  (errno == EWOULDBLOCK) )
+	return(1);
+    }
+
+    if  (numRead <= 0)
+      return(endRequest(clientPtr,0));
+
+    if  (protocolVersion == PROTOCOL_V2)
+    {
+      int	result	= readV2Reply(clientPtr,buffer,numRead);
+
+      if  (result >= 0)
+	return(result);
+
+      continue;
+    }
+
+    for  (ssize_t i = 0;  i < numRead;  i++)
+    {
+      if  (clientPtr->isInWord)
+      {
+	if  (buffer[i] != '\n')
+	  continue;
+
+	clientPtr->isInWord	= 0;
+
+	if  (clientPtr->count <= 0)
+	  return(endRequest(clientPtr,clientPtr->count == 0));
+      }
+      else
+      {
+	clientPtr->countBytes[clientPtr->countLen++]	= buffer[i];
+
+	if  (clientPtr->countLen == sizeof(int))
+	{
+	  int	netCount;
+
+	  memcpy(&netCount,clientPtr->countBytes,sizeof(netCount));
+	  clientPtr->count	= ntohl(netCount);
+	  clientPtr->countLen	= 0;
+	  clientPtr->isInWord	= 1;
+	}
+      }
+    }
+  }
+}
+
+
+//  PURPOSE:  To send as many more requests over the persistent connection
+//	of 'clientPtr' as 'pipelineDepth' allows, with one 'write()'.  Returns
+//	'1' on success or '0' otherwise.
+int		sendPipelined	(struct Client*	clientPtr
+				)
+{
+  char			buffer[PROTOCOL_MAX_REQUEST_LEN * PIPELINE_MAX_DEPTH];
+  size_t		len	= 0;
+  struct Request	request;
+
+  memset(&request,'\0',sizeof(request));
+  request.version	= PROTOCOL_V2;
+  request.opcode	= OPCODE_HISTOGRAM;
+  request.wordCount	= wordCount;
+
+  while  ( (clientPtr->numMade < requestsPerClient)  &&
+	   (clientPtr->numMade - clientPtr->numReceived < pipelineDepth)
+	 )
+  {
+    request.requestId	= clientPtr->numMade;
+    request.wordIndex	= getNextWordIndex();
+    clientPtr->sendTimeArray[clientPtr->numMade++]	= now();
+    len	+= encodeRequest(&request,buffer+len);
+  }
+
+  //  At most 'pipelineDepth' requests are unanswered, so they fit in the
+  //  socket's send buffer:
+  return( (len == 0)  ||  (write(clientPtr->fd,buffer,len) == (ssize_t)len) );
+}
+
+
+//  PURPOSE:  To give up on the persistent connection of 'clientPtr',
+//	counting every request not yet answered as failed.  Returns '0'.
+int		failPipelined	(struct Client*	clientPtr
+				)
+{
+  close(clientPtr->fd);
+  numFailed	+= requestsPerClient - clientPtr->numReceived;
+  return(0);
+}
+
+
+//  PURPOSE:  To start the persistent connection of 'clientPtr'.  Returns '1'
+//	on success or '0' otherwise.
+int		startPipelined	(struct Client*	clientPtr
+				)
+{
+  struct epoll_event	event;
+
+  clientPtr->sendTimeArray	= calloc(requestsPerClient,sizeof(double));
+  clientPtr->fd			= socket(AF_INET,SOCK_STREAM | SOCK_NONBLOCK,0);
+
+  if  (clientPtr->fd < 0)
+  {
+    numFailed	+= requestsPerClient;
+    return(0);
+  }
+
+  if  ( (connect(clientPtr->fd,(struct sockaddr*)&serverAddr,sizeof(serverAddr)) < 0)  &&
+	(errno != EINPROGRESS)
+      )
+    return(failPipelined(clientPtr));
+
+  event.events		= EPOLLOUT;
+  event.data.ptr	= clientPtr;
+  epoll_ctl(epollFd,EPOLL_CTL_ADD,clientPtr->fd,&event);
+  return(1);
+}
+
+
+//  PURPOSE:  To send the first requests of 'clientPtr' once its persistent
+//	connection is up.  Returns '1' if 'clientPtr' still has requests under
+//	way or '0' if it is done.
+int		connectPipelined(struct Client*	clientPtr
+				)
+{
+  int			error		= 0;
+  socklen_t		errorLen	= sizeof(error);
+  struct epoll_event	event;
+
+  getsockopt(clientPtr->fd,SOL_SOCKET,SO_ERROR,&error,&errorLen);
+
+  if  ( (error != 0)  ||  !sendPipelined(clientPtr) )
+    return(failPipelined(clientPtr));
+
+  clientPtr->isConnected	= 1;
+  event.events			= EPOLLIN;
+  event.data.ptr		= clientPtr;
+  epoll_ctl(epollFd,EPOLL_CTL_MOD,clientPtr->fd,&event);
+  return(1);
+}
+
+
+//  PURPOSE:  To read what is available of the replies to 'clientPtr' over
+//	its persistent connection, which may come in any order, and to send
+//	a new request for each one answered.  Returns '1' if 'clientPtr'
+//	still has requests under way or '0' if it is done.
+int		readPipelined	(struct Client*	clientPtr
+				)
+{
+  static char	buffer[READ_BUFFER_LEN];
+
+  while  (1)
+  {
+    ssize_t	numRead	= read(clientPtr->fd,buffer,sizeof(buffer));
+
+    if  (numRead < 0)
+    {
+      if  (errno == EINTR)
+	continue;
+
+      if  ( (errno == EAGAIN)  ||  (errno == EWOULDBLOCK) )
+	break;
+    }
+
+    if  (numRead <= 0)
+      return(failPipelined(clientPtr));
+
+    const char*	cPtr	= buffer;
+    size_t	numLeft	= numRead;
+
+    while  (1)
+    {
+      //  Get the header of the next reply:
+      if  (clientPtr->headerLen < PROTOCOL_V2_HEADER_LEN)
+      {
+	size_t	len	= PROTOCOL_V2_HEADER_LEN - clientPtr->headerLen;
+
+	if  (numLeft == 0)
+	  break;
+
+	if  (len > numLeft)
+	  len	= numLeft;
+
+	memcpy(clientPtr->header + clientPtr->headerLen,cPtr,len);
+	clientPtr->headerLen	+= len;
+	cPtr			+= len;
+	numLeft			-= len;
+
+	if  (clientPtr->headerLen < PROTOCOL_V2_HEADER_LEN)
+	  break;
+
+	if  (getU32(clientPtr->header) != PROTOCOL_MAGIC)
+	  return(failPipelined(clientPtr));
+
+	clientPtr->payloadLeft	= getU32(clientPtr->header+16);
+      }
+
+      //  Skip its payload:
+      size_t	len	= (numLeft < clientPtr->payloadLeft)
+			  ? numLeft
+			  : clientPtr->payloadLeft;
+
+      clientPtr->payloadLeft	-= len;
+      cPtr			+= len;
+      numLeft			-= len;
+
+      if  (clientPtr->payloadLeft > 0)
+	break;
+
+      //  Note it:
+      uint32_t	requestId	= getU32(clientPtr->header+8);
+
+      if  ( (getU16(clientPtr->header+4) == STATUS_OK)  &&
+	    (requestId < (uint32_t)clientPtr->numMade)
+	  )
+	latencyArray[numServed++]	= now() - clientPtr->sendTimeArray[requestId];
+      else
+      {
+	numFailed++;
+
+	if  (getU16(clientPtr->header+4) == STATUS_BUSY)
+	  numBusy++;
+      }
+
+      clientPtr->headerLen	= 0;
+
+      if  (++clientPtr->numReceived == requestsPerClient)
+      {
+	close(clientPtr->fd);
+	return(0);
+      }
+    }
+  }
+
+  if  (!sendPipelined(clientPtr))
+    return(failPipelined(clientPtr));
+
+  return(1);
+}
+
+
+//  PURPOSE:  To set 'serverAddr' to the address of server 'hostname' at port
+//	'port'.  Returns '1' on success or '0' otherwise.
+int		obtainServerAddr(const char*	hostname,
+				 int		port
+				)
+{
+  struct addrinfo*	hostPtr;
+  int			status	= getaddrinfo(hostname,NULL,NULL,&hostPtr);
+
+  if  (status != 0)
+  {
+    fprintf(stderr,"%s\n",gai_strerror(status));
+    return(0);
+  }
+
+  memset(&serverAddr,0,sizeof(serverAddr));
+  serverAddr.sin_family		= AF_INET;
+  serverAddr.sin_port		= htons(port);
+  serverAddr.sin_addr.s_addr	=
+	((struct sockaddr_in*)hostPtr->ai_addr)->sin_addr.s_addr;
+  freeaddrinfo(hostPtr);
+  return(1);
+}
+
+
+//  PURPOSE:  To compare the latencies pointed to by 'lhs' and 'rhs' for
+//	'qsort()'.
+int		compareLatency	(const void*	lhs,
+				 const void*	rhs
+				)
+{
+  double	l	= *(const double*)lhs;
+  double	r	= *(const double*)rhs;
+
+  return( (l < r) ? -1 : (l > r) ? 1 : 0 );
+}
+
+
+//  PURPOSE:  To return the latency, in milliseconds, below which fraction
+//	'fraction' of the 'numServed' sorted latencies in 'latencyArray' are.
+double		percentile	(double		fraction
+				)
+{
+  int	i	= (int)(fraction * numServed);
+
+  if  (i >= numServed)
+    i	= numServed - 1;
+
+  return(latencyArray[i] * 1000);
+}
+
+
+//  PURPOSE:  To run the clients the command line arguments 'argc' and
+//	'argv[]' tell of, all of them at once, and to report the requests/sec
+//	they were served and their latency.  Returns 'EXIT_SUCCESS' to OS if
+//	every request was served or 'EXIT_FAILURE' otherwise.
+int		main		(int	argc,
+				 char*	argv[]
+				)
+{
+  //  I.  Application validity check:
+  static struct option	optionArray[]	=
+  {
+    {"v2",		no_argument,		NULL,	'2'},
+    {"pipeline",	required_argument,	NULL,	'p'},
+    {"cold",		no_argument,		NULL,	'c'},
+    {"rate",		required_argument,	NULL,	'r'},
+    {"json",		no_argument,		NULL,	'j'},
+    {NULL,		0,			NULL,	0}
+  };
+  int			option;
+
+  while  ( (option = getopt_long(argc,argv,"",optionArray,NULL)) != -1 )
+    if  (option == '2')
+      protocolVersion	= PROTOCOL_V2;
+    else
+    if  (option == 'c')
+      isCold		= 1;
+    else
+    if  (option == 'j')
+      shouldPrintJson	= 1;
+    else
+    if  (option == 'r')
+    {
+      requestRate	= strtod(optarg,NULL);
+
+      if  (requestRate <= 0)
+	argc	= 0;
+    }
+    else
+    if  (option == 'p')
+    {
+      protocolVersion	= PROTOCOL_V2;
+      pipelineDepth	= strtol(optarg,NULL,0);
+
+      if  ( (pipelineDepth < 1)  ||  (pipelineDepth > PIPELINE_MAX_DEPTH) )
+	argc	= 0;
+    }
+    else
+      argc	= 0;
+
+  argc	-= optind - 1;
+  argv	+= optind - 1;
+
+  if  ( (argc < 7)  ||  ((requestRate > 0)  &&  (pipelineDepth > 0)) )
+  {
+    fprintf(stderr,
+	    "Usage:\tloadGenerator [--v2] [--pipeline=depth | --rate=requestsPerSec]"
+	    " [--cold] [--json] host port"
+	    " numClients requestsPerClient wordIndex wordCount\n"
+	    "\t(1 <= depth <= %d)\n",
+	    PIPELINE_MAX_DEPTH
+	   );
+    exit(EXIT_FAILURE);
+  }
+
+  int		numClients	= strtol(argv[3],NULL,0);
+  struct rlimit	fdLimit;
+
+  requestsPerClient	= strtol(argv[4],NULL,0);
+  wordIndex		= strtol(argv[5],NULL,0);
+  wordCount		= strtol(argv[6],NULL,0);
+
+  if  (getrlimit(RLIMIT_NOFILE,&fdLimit) == 0)
+  {
+    fdLimit.rlim_cur	= fdLimit.rlim_max;
+    setrlimit(RLIMIT_NOFILE,&fdLimit);
+  }
+
+  if  ( (numClients < 1)  ||  ((rlim_t)numClients + 16 > fdLimit.rlim_cur)  ||
+	(requestsPerClient < 1)  ||  (wordIndex < 0)  ||  (wordCount < 1)
+      )
+  {
+    fprintf(stderr,"Need 1 <= numClients <= %d, requestsPerClient >= 1,"
+		   " wordIndex >= 0 and wordCount >= 1.\n",
+	    (int)fdLimit.rlim_cur - 16
+	   );
+    exit(EXIT_FAILURE);
+  }
+
+  if  (!obtainServerAddr(argv[1],strtol(argv[2],NULL,0)))
+    exit(EXIT_FAILURE);
+
+  //  II.  Run clients:
+  struct Client*	clientArray	= calloc(numClients,sizeof(struct Client));
+  struct epoll_event	eventArray[EPOLL_MAX_EVENTS];
+  int			numRunning	= 0;
+
+  latencyArray	= calloc((size_t)numClients * requestsPerClient,sizeof(double));
+  idleArray	= calloc(numClients,sizeof(struct Client*));
+  epollFd	= epoll_create1(0);
+
+  double		startTime	= now();
+
+  //  In an open loop, the requests are due at the times of a Poisson
+  //  process, the same ones every run.  The clients are the most
+  //  connections open at once; a request due while none is idle waits for
+  //  one, and that wait counts in its latency:
+  int			numLeft		= numClients * requestsPerClient;
+  double		dueTime		= startTime;
+
+  srand48(1);
+
+  for  (int i = 0;  i < numClients;  i++)
+    if  (pipelineDepth > 0)
+      numRunning	+= startPipelined(&clientArray[i]);
+    else
+      numRunning	+= startRequest(&clientArray[i]);
+
+  while  ( (numRunning > 0)  ||  ((requestRate > 0)  &&  (numLeft > 0)) )
+  {
+    int	timeoutMs	= -1;
+
+    if  ( (requestRate > 0)  &&  (numLeft > 0)  &&  (numIdle > 0) )
+    {
+      double	time	= now();
+
+      while  ( (numLeft > 0)  &&  (numIdle > 0)  &&  (dueTime <= time) )
+      {
+	struct Client*	clientPtr	= idleArray[--numIdle];
+
+	numLeft--;
+
+	if  (beginRequest(clientPtr,dueTime))
+	  numRunning++;
+	else
+	  idleArray[numIdle++]	= clientPtr;
+
+	dueTime		-= log(1 - drand48()) / requestRate;
+      }
+
+      if  ( (numLeft > 0)  &&  (numIdle > 0) )
+	timeoutMs	= (int)ceil((dueTime - time) * 1000);
+    }
+
+    int	numEvents	= epoll_wait(epollFd,eventArray,EPOLL_MAX_EVENTS,timeoutMs);
+
+    for  (int i = 0;  i < numEvents;  i++)
+    {
+      struct Client*	clientPtr	= (struct Client*)eventArray[i].data.ptr;
+      int		isRunning;
+
+      if  (pipelineDepth > 0)
+	isRunning	= clientPtr->isConnected
+			  ? readPipelined(clientPtr)
+			  : connectPipelined(clientPtr);
+      else
+      if  (clientPtr->isConnected)
+	isRunning	= readReply(clientPtr);
+      else
+	isRunning	= sendRequest(clientPtr);
+
+      if  (!isRunning)
+	numRunning--;
+    }
+  }
+
+  double		elapsed		= now() - startTime;
+
+  qsort(latencyArray,numServed,sizeof(double),compareLatency);
+
+  if  (shouldPrintJson)
+  {
+    printf("{\n"
+	   "  \"benchmark\": \"load\",\n"
+	   "  \"loop\": \"%s\",\n"
+	   "  \"targetRequestsPerSec\": %.1f,\n"
+	   "  \"protocolVersion\": %d,\n"
+	   "  \"pipelineDepth\": %d,\n"
+	   "  \"cold\": %s,\n"
+	   "  \"clients\": %d,\n"
+	   "  \"requestsPerClient\": %d,\n"
+	   "  \"wordIndex\": %d,\n"
+	   "  \"wordCount\": %d,\n"
+	   "  \"served\": %d,\n"
+	   "  \"failed\": %d,\n"
+	   "  \"busy\": %d,\n"
+	   "  \"seconds\": %.6f,\n"
+	   "  \"requestsPerSec\": %.1f,\n",
+	   (requestRate > 0) ? "open" : "closed",requestRate,
+	   (protocolVersion == PROTOCOL_V2) ? 2 : 1,pipelineDepth,
+	   isCold ? "true" : "false",numClients,requestsPerClient,wordIndex,wordCount,
+	   numServed,numFailed,numBusy,elapsed,numServed / elapsed
+	  );
+
+    if  (numServed > 0)
+      printf("  \"latencyMs\": { \"p50\": %.3f, \"p99\": %.3f, \"p999\": %.3f, \"max\": %.3f }\n",
+	     percentile(0.5),percentile(0.99),percentile(0.999),
+	     latencyArray[numServed-1] * 1000
+	    );
+    else
+      printf("  \"latencyMs\": null\n");
+
+    printf("}\n");
+  }
+  else
+  {
+    printf("%d clients x %d requests of %d words: %d served, %d failed"
+	   " (%d busy), %.2f s, %.1f requests/sec\n",
+	   numClients,requestsPerClient,wordCount,numServed,numFailed,numBusy,
+	   elapsed,numServed / elapsed
+	  );
+
+    if  (numServed > 0)
+      printf("latency ms: p50 %.2f, p99 %.2f, p99.9 %.2f, max %.2f\n",
+	     percentile(0.5),percentile(0.99),percentile(0.999),
+	     latencyArray[numServed-1] * 1000
+	    );
+  }
+
+  //  III.  Finished:
+  close(epollFd);
+
+  for  (int i = 0;  i < numClients;  i++)
+    free(clientArray[i].sendTimeArray);
+
+  free(latencyArray);
+  free(idleArray);
+  free(clientArray);
+  return( (numFailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE );
+}
@@ -0,0 +1,212 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		protocol.c						---*
+ *---									---*
+ *---	    This file defines the functions that encode and decode	---*
+ *---	requests and build replies, as protocol.h describes.		---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//	Compiled into wordHistogramServer, see wordHistogramServer.c.
+
+//---		Header file inclusion					---//
+
+#include	"header.h"
+#include	"protocol.h"
+
+
+//---		Definition of constants:				---//
+
+//  PURPOSE:  To tell the number of bytes a new reply has room for.
+#define		REPLY_INIT_CAPACITY	4096
+
+
+//---		Definition of functions:				---//
+
+//  PURPOSE:  To return the length of the request whose first 4 bytes are at
+//	'bytePtr'.
+size_t		getRequestLen	(const char*		bytePtr
+				)
+{
+  return( (getU32(bytePtr) == PROTOCOL_MAGIC)
+	  ? PROTOCOL_V2_REQUEST_LEN
+	  : PROTOCOL_V1_REQUEST_LEN
+	);
+}
+
+
+//  PURPOSE:  To set '*requestPtr' to the request whose 'getRequestLen()'
+//	bytes are at 'bytePtr'.  No return value.
+void		decodeRequest	(struct Request*	requestPtr,
+				 const char*		bytePtr
+				)
+{
+  memset(requestPtr,'\0',sizeof(*requestPtr));
+
+  if  (getU32(bytePtr) != PROTOCOL_MAGIC)
+  {
+    requestPtr->version		= PROTOCOL_V1;
+    requestPtr->opcode		= OPCODE_HISTOGRAM;
+    requestPtr->wordIndex	= (int32_t)getU32(bytePtr);
+    requestPtr->wordCount	= (int32_t)getU32(bytePtr+4);
+    return;
+  }
+
+  requestPtr->version		= PROTOCOL_V2;
+  requestPtr->opcode		= getU16(bytePtr+4);
+  requestPtr->flags		= getU16(bytePtr+6);
+  requestPtr->requestId		= getU32(bytePtr+8);
+  requestPtr->wordIndex		= (int32_t)getU32(bytePtr+12);
+  requestPtr->wordCount		= (int32_t)getU32(bytePtr+16);
+  requestPtr->argument		= getU32(bytePtr+20);
+}
+
+
+//  PURPOSE:  To write '*requestPtr' at 'bytePtr', which has room for
+//	'PROTOCOL_MAX_REQUEST_LEN' bytes, in the form of its version.
+//	Returns the number of bytes written.
+size_t		encodeRequest	(const struct Request*	requestPtr,
+				 char*			bytePtr
+				)
+{
+  if  (requestPtr->version == PROTOCOL_V1)
+  {
+    putU32(bytePtr,  requestPtr->wordIndex);
+    putU32(bytePtr+4,requestPtr->wordCount);
+    return(PROTOCOL_V1_REQUEST_LEN);
+  }
+
+  putU32(bytePtr,   PROTOCOL_MAGIC);
+  putU16(bytePtr+4, requestPtr->opcode);
+  putU16(bytePtr+6, requestPtr->flags);
+  putU32(bytePtr+8, requestPtr->requestId);
+  putU32(bytePtr+12,requestPtr->wordIndex);
+  putU32(bytePtr+16,requestPtr->wordCount);
+  putU32(bytePtr+20,requestPtr->argument);
+  return(PROTOCOL_V2_REQUEST_LEN);
+}
+
+
+//  PURPOSE:  To return a pointer to 'numBytes' more bytes at the end of
+//	'*replyPtr', growing its buffer as needed.
+static
+char*		extendReply	(struct Reply*		replyPtr,
+				 size_t			numBytes
+				)
+{
+  if  (replyPtr->len + numBytes > replyPtr->capacity)
+  {
+    size_t	capacity	= (replyPtr->capacity == 0)
+				  ? REPLY_INIT_CAPACITY
+				  : replyPtr->capacity;
+
+    while  (replyPtr->len + numBytes > capacity)
+      capacity	*= 2;
+
+    replyPtr->bytes	= (char*)realloc(replyPtr->bytes,capacity);
+    replyPtr->capacity	= capacity;
+
+    if  (replyPtr->bytes == NULL)
+    {
+      fprintf(stderr,"Out of memory building a reply.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  char*	bytePtr	= replyPtr->bytes + replyPtr->len;
+
+  replyPtr->len	+= numBytes;
+  return(bytePtr);
+}
+
+
+//  PURPOSE:  To return the length of the start of a reply of version
+//	'version' that precedes its entries.
+static
+size_t		getReplyHeaderLen
+				(int			version
+				)
+{
+  return( (version == PROTOCOL_V2) ? PROTOCOL_V2_HEADER_LEN : 0 );
+}
+
+
+//  PURPOSE:  To start building in '*replyPtr' an empty reply to 'request'.
+//	No return value.
+void		beginReply	(struct Reply*		replyPtr,
+				 const struct Request*	requestPtr
+				)
+{
+  memset(replyPtr,'\0',sizeof(*replyPtr));
+  replyPtr->version	= requestPtr->version;
+  replyPtr->requestId	= requestPtr->requestId;
+  extendReply(replyPtr,getReplyHeaderLen(replyPtr->version));
+}
+
+
+//  PURPOSE:  To add to '*replyPtr' the entry telling that the 'wordLen'
+//	chars at 'wordCPtr' were seen 'count' times.  No return value.
+void		addReplyEntry	(struct Reply*		replyPtr,
+				 int			count,
+				 const char*		wordCPtr,
+				 int			wordLen
+				)
+{
+  char*	bytePtr;
+
+  if  (replyPtr->version == PROTOCOL_V1)
+  {
+    bytePtr	= extendReply(replyPtr,sizeof(uint32_t) + wordLen + 1);
+    putU32(bytePtr,count);
+    memcpy(bytePtr+sizeof(uint32_t),wordCPtr,wordLen);
+    bytePtr[sizeof(uint32_t)+wordLen]	= '\n';
+  }
+  else
+  {
+    bytePtr	= extendReply(replyPtr,sizeof(uint32_t) + sizeof(uint16_t) + wordLen);
+    putU32(bytePtr,count);
+    putU16(bytePtr+sizeof(uint32_t),wordLen);
+    memcpy(bytePtr+sizeof(uint32_t)+sizeof(uint16_t),wordCPtr,wordLen);
+  }
+
+  replyPtr->numEntries++;
+}
+
+
+//  PURPOSE:  To finish '*replyPtr' with status 'status'.  If 'status' is not
+//	'STATUS_OK' then the entries added so far are dropped.  No return
+//	value.
+void		endReply	(struct Reply*		replyPtr,
+				 int			status
+				)
+{
+  size_t	headerLen	= getReplyHeaderLen(replyPtr->version);
+
+  if  (status != STATUS_OK)
+  {
+    replyPtr->len		= headerLen;
+    replyPtr->numEntries	= 0;
+  }
+
+  if  (replyPtr->version == PROTOCOL_V1)
+  {
+    if  (status != STATUS_OK)
+      addReplyEntry(replyPtr,-1,"",0);
+
+    addReplyEntry(replyPtr,0,"",0);
+    return;
+  }
+
+  char*	bytePtr	= replyPtr->bytes;
+
+  putU32(bytePtr,   PROTOCOL_MAGIC);
+  putU16(bytePtr+4, status);
+  putU16(bytePtr+6, replyPtr->flags);
+  putU32(bytePtr+8, replyPtr->requestId);
+  putU32(bytePtr+12,replyPtr->numEntries);
+  putU32(bytePtr+16,replyPtr->len - headerLen);
+}
@@ -0,0 +1,258 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		protocol.h						---*
+ *---									---*
+ *---	    This file declares the wire protocol between client and	---*
+ *---	server: the requests, and the replies the server builds.	---*
+ *---									---*
+ *---	    Version 1 (the original) requests are two ints, wordIndex	---*
+ *---	and wordCount.  The reply is one entry per distinct word: the	---*
+ *---	count, the word and a '\n', and then the count 0 and a '\n'	---*
+ *---	(the count -1 and a '\n' before that tell of an error).		---*
+ *---									---*
+ *---	    Version 2 requests start with 'PROTOCOL_MAGIC', which is	---*
+ *---	how the server tells them apart, and are followed by a reply	---*
+ *---	header telling the status, the number of entries and the size	---*
+ *---	of the payload, and then the packed entries.  Every number is	---*
+ *---	in network byte order.						---*
+ *---									---*
+ *---	    Request v2 (PROTOCOL_V2_REQUEST_LEN bytes):			---*
+ *---		u32 magic, u16 opcode, u16 flags, u32 requestId,	---*
+ *---		i32 wordIndex, i32 wordCount, u32 argument		---*
+ *---	    Reply v2 header (PROTOCOL_V2_HEADER_LEN bytes):		---*
+ *---		u32 magic, u16 status, u16 flags, u32 requestId,	---*
+ *---		u32 entryCount, u32 payloadBytes			---*
+ *---	    Reply v2 entry:						---*
+ *---		u32 count, u16 wordLen, wordLen bytes of word		---*
+ *---									---*
+ *---	    A request with 'REQUEST_FLAG_STREAM' gets, before its	---*
+ *---	reply, any number of delta replies with 'REPLY_FLAG_DELTA'	---*
+ *---	and the same requestId.  Each one holds the words whose		---*
+ *---	counts changed since the delta before it, with their counts	---*
+ *---	so far.  The reply without 'REPLY_FLAG_DELTA' is the whole	---*
+ *---	histogram, as without streaming.				---*
+ *---									---*
+ *---	    A request the server has no room to queue gets at once a	---*
+ *---	reply with status 'STATUS_BUSY' (or, in version 1, the count	---*
+ *---	-1 of an error) and should be retried later.			---*
+ *---									---*
+ *---	    "histogrammer --serve" answers the server over a pipe: it	---*
+ *---	writes a u32 'SERVE_READY_LEN' once its corpus is loaded, then	---*
+ *---	reads lines "wordIndex wordCount topK" and answers each with a	---*
+ *---	u32 payloadBytes (or 'SERVE_ERROR_LEN') and then that many	---*
+ *---	bytes of version 2 reply entries.				---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	<stdint.h>
+#include	<string.h>
+#include	<arpa/inet.h>	// For htonl(), ntohl()
+
+
+//---		Definition of constants:				---//
+
+//  PURPOSE:  To start every version 2 request and reply ("WHV2").
+#define		PROTOCOL_MAGIC		0x57485632
+
+//  PURPOSE:  To tell the length of a version 1 request.
+#define		PROTOCOL_V1_REQUEST_LEN	8
+
+//  PURPOSE:  To tell the length of a version 2 request.
+#define		PROTOCOL_V2_REQUEST_LEN	24
+
+//  PURPOSE:  To tell the length of the header of a version 2 reply.
+#define		PROTOCOL_V2_HEADER_LEN	20
+
+//  PURPOSE:  To tell the longest request of any version.
+#define		PROTOCOL_MAX_REQUEST_LEN	PROTOCOL_V2_REQUEST_LEN
+
+//  PURPOSE:  To tell the protocol versions.
+#define		PROTOCOL_V1		1
+#define		PROTOCOL_V2		2
+
+//  PURPOSE:  To tell what a request asks for.  'OPCODE_STATS' asks for the
+//	counters of the server, one entry per counter with its name as the
+//	word (wordIndex and wordCount are ignored).  'OPCODE_TOP' asks for
+//	only the 'argument' most frequent words of the histogram, the most
+//	frequent first (and those with the same count by word).
+#define		OPCODE_HISTOGRAM	1
+#define		OPCODE_STATS		2
+#define		OPCODE_TOP		3
+
+//  PURPOSE:  To ask, in the flags of a version 2 'OPCODE_HISTOGRAM'
+//	request, for a delta reply every 'argument' words counted (or every
+//	'PROTOCOL_DEFAULT_STREAM_WORDS' words if 'argument' is '0', and every
+//	'PROTOCOL_MIN_STREAM_WORDS' words if it is fewer).
+#define		REQUEST_FLAG_STREAM	0x0001
+
+//  PURPOSE:  To allow, in the flags of an 'OPCODE_TOP' request, approximate
+//	counts made in memory that depends only on 'argument'.  A count may
+//	then be too high, and a word just out of the top 'argument' may
+//	take the place of one just in.
+#define		REQUEST_FLAG_APPROXIMATE	0x0002
+
+//  PURPOSE:  To tell the default number of words counted between deltas.
+#define		PROTOCOL_DEFAULT_STREAM_WORDS	65536
+
+//  PURPOSE:  To tell the fewest words counted between deltas.  Words are
+//	merged a block at a time, so fewer would give no more deltas.
+#define		PROTOCOL_MIN_STREAM_WORDS	8192
+
+//  PURPOSE:  To tell, in the flags of a version 2 reply, that it is a delta
+//	and that more replies to the same request follow.
+#define		REPLY_FLAG_DELTA	0x0001
+
+//  PURPOSE:  To tell the outcome of a request.
+#define		STATUS_OK		0
+#define		STATUS_BAD_REQUEST	1
+#define		STATUS_ERROR		2
+#define		STATUS_BUSY		3
+
+//  PURPOSE:  To tell, in place of the payload length "histogrammer --serve"
+//	answers a request with, that the request failed.
+#define		SERVE_ERROR_LEN		0xFFFFFFFF
+
+//  PURPOSE:  To tell, before its first answer, that "histogrammer --serve"
+//	has loaded its corpus and reads requests.
+#define		SERVE_READY_LEN		0xFFFFFFFE
+
+
+//---		Definition of types:					---//
+
+//  PURPOSE:  To hold a decoded request of either version.  A version 1
+//	request has opcode 'OPCODE_HISTOGRAM' and '0' for the other fields
+//	it does not send.
+struct		Request
+{
+  int		version;
+  uint16_t	opcode;
+  uint16_t	flags;
+  uint32_t	requestId;
+  int32_t	wordIndex;
+  int32_t	wordCount;
+  uint32_t	argument;
+};
+
+
+//  PURPOSE:  To hold a reply while it is built, in the form its version
+//	sends it.  'bytes' is 'malloc()'-ed.  'flags' is only sent by
+//	version 2.
+struct		Reply
+{
+  int		version;
+  uint16_t	flags;
+  uint32_t	requestId;
+  uint32_t	numEntries;
+  char*		bytes;
+  size_t	len;
+  size_t	capacity;
+};
+
+
+//---		Definition of functions:				---//
+
+//  PURPOSE:  To write 'value' in network byte order at 'bytePtr'.  No return
+//	value.
+static inline
+void		putU32		(char*		bytePtr,
+				 uint32_t	value
+				)
+{
+  value	= htonl(value);
+  memcpy(bytePtr,&value,sizeof(value));
+}
+
+
+//  PURPOSE:  To write 'value' in network byte order at 'bytePtr'.  No return
+//	value.
+static inline
+void		putU16		(char*		bytePtr,
+				 uint16_t	value
+				)
+{
+  value	= htons(value);
+  memcpy(bytePtr,&value,sizeof(value));
+}
+
+
+//  PURPOSE:  To return the number in network byte order at 'bytePtr'.
+static inline
+uint32_t	getU32		(const char*	bytePtr
+				)
+{
+  uint32_t	value;
+
+  memcpy(&value,bytePtr,sizeof(value));
+  return(ntohl(value));
+}
+
+
+//  PURPOSE:  To return the number in network byte order at 'bytePtr'.
+static inline
+uint16_t	getU16		(const char*	bytePtr
+				)
+{
+  uint16_t	value;
+
+  memcpy(&value,bytePtr,sizeof(value));
+  return(ntohs(value));
+}
+
+
+#ifdef	__cplusplus
+extern "C"
+{
+#endif
+
+//  PURPOSE:  To return the length of the request whose first 4 bytes are at
+//	'bytePtr'.
+extern
+size_t		getRequestLen	(const char*		bytePtr
+				);
+
+//  PURPOSE:  To set '*requestPtr' to the request whose 'getRequestLen()'
+//	bytes are at 'bytePtr'.  No return value.
+extern
+void		decodeRequest	(struct Request*	requestPtr,
+				 const char*		bytePtr
+				);
+
+//  PURPOSE:  To write '*requestPtr' at 'bytePtr', which has room for
+//	'PROTOCOL_MAX_REQUEST_LEN' bytes, in the form of its version.
+//	Returns the number of bytes written.
+extern
+size_t		encodeRequest	(const struct Request*	requestPtr,
+				 char*			bytePtr
+				);
+
+//  PURPOSE:  To start building in '*replyPtr' an empty reply to 'request'.
+//	No return value.
+extern
+void		beginReply	(struct Reply*		replyPtr,
+				 const struct Request*	requestPtr
+				);
+
+//  PURPOSE:  To add to '*replyPtr' the entry telling that the 'wordLen'
+//	chars at 'wordCPtr' were seen 'count' times.  No return value.
+extern
+void		addReplyEntry	(struct Reply*		replyPtr,
+				 int			count,
+				 const char*		wordCPtr,
+				 int			wordLen
+				);
+
+//  PURPOSE:  To finish '*replyPtr' with status 'status'.  If 'status' is not
+//	'STATUS_OK' then the entries added so far are dropped.  No return
+//	value.
+extern
+void		endReply	(struct Reply*		replyPtr,
+				 int			status
+				);
+
+#ifdef	__cplusplus
+}
+#endif
@@ -0,0 +1,412 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		resultCache.c						---*
+ *---									---*
+ *---	    This file defines the server's cache of finished replies,	---*
+ *---	as resultCache.h describes.  The entries are chained in a	---*
+ *---	hash table to be found, and in a doubly-linked list from most	---*
+ *---	to least recently used to be evicted, all under one mutex.	---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//	Compiled into wordHistogramServer, see wordHistogramServer.c.
+
+//---		Header file inclusion					---//
+
+#include	"header.h"
+#include	"protocol.h"
+#include	"resultCache.h"
+#include	<pthread.h>	// For pthread_mutex_lock()
+
+
+//---		Definition of constants:				---//
+
+//  PURPOSE:  To tell the number of hash buckets the cache starts with.  It
+//	doubles them whenever it has more entries than buckets.
+#define		CACHE_INIT_NUM_BUCKETS	1024
+
+
+//---		Definition of types:					---//
+
+//  PURPOSE:  To hold one cached reply, with its request ID left out.
+struct		CacheEntry
+{
+  struct Request	key;
+  uint64_t		hash;
+  char*			bytes;
+  size_t		len;
+  uint32_t		numEntries;
+  struct CacheEntry*	chainPtr;
+  struct CacheEntry*	newerPtr;
+  struct CacheEntry*	olderPtr;
+};
+
+
+//---		Definition of global vars:				---//
+
+//  PURPOSE:  To hold the hash buckets, each the head of a chain of entries.
+static struct CacheEntry**	bucketArray	= NULL;
+
+//  PURPOSE:  To tell the number of hash buckets, a power of 2.
+static size_t			numBuckets	= 0;
+
+//  PURPOSE:  To point to the most and the least recently used entries.
+static struct CacheEntry*	newestPtr	= NULL;
+static struct CacheEntry*	oldestPtr	= NULL;
+
+//  PURPOSE:  To tell the version of the corpus of the cached replies.
+static uint64_t			cacheVersion	= 0;
+
+//  PURPOSE:  To hold the counters, and the budget in 'stats.maxBytes'.
+static struct CacheStats	stats;
+
+//  PURPOSE:  To guard all of the above.
+static pthread_mutex_t		cacheLock	= PTHREAD_MUTEX_INITIALIZER;
+
+
+//---		Definition of functions:				---//
+
+//  PURPOSE:  To return the hash of the request '*requestPtr', leaving out
+//	its request ID.
+static
+uint64_t	hashRequest	(const struct Request*	requestPtr
+				)
+{
+  uint64_t	hash	= (uint64_t)requestPtr->version;
+
+  hash	= hash * 0x9E3779B97F4A7C15ULL + requestPtr->opcode;
+  hash	= hash * 0x9E3779B97F4A7C15ULL + requestPtr->flags;
+  hash	= hash * 0x9E3779B97F4A7C15ULL + (uint32_t)requestPtr->wordIndex;
+  hash	= hash * 0x9E3779B97F4A7C15ULL + (uint32_t)requestPtr->wordCount;
+  hash	= hash * 0x9E3779B97F4A7C15ULL + requestPtr->argument;
+  return(hash ^ (hash >> 29));
+}
+
+
+//  PURPOSE:  To return '1' if '*lhsPtr' and '*rhsPtr' ask for the same reply,
+//	whatever their request IDs, or '0' otherwise.
+static
+int		isSameRequest	(const struct Request*	lhsPtr,
+				 const struct Request*	rhsPtr
+				)
+{
+  return( (lhsPtr->version	== rhsPtr->version)	&&
+	  (lhsPtr->opcode	== rhsPtr->opcode)	&&
+	  (lhsPtr->flags	== rhsPtr->flags)	&&
+	  (lhsPtr->wordIndex	== rhsPtr->wordIndex)	&&
+	  (lhsPtr->wordCount	== rhsPtr->wordCount)	&&
+	  (lhsPtr->argument	== rhsPtr->argument)
+	);
+}
+
+
+//  PURPOSE:  To return the number of bytes of the budget 'entryPtr' uses.
+static
+size_t		getEntryCost	(const struct CacheEntry*	entryPtr
+				)
+{
+  return(sizeof(*entryPtr) + entryPtr->len);
+}
+
+
+//  PURPOSE:  To take 'entryPtr' out of the list of recently used entries.
+//	No return value.
+static
+void		unlinkEntry	(struct CacheEntry*	entryPtr
+				)
+{
+  if  (entryPtr->newerPtr == NULL)
+    newestPtr			= entryPtr->olderPtr;
+  else
+    entryPtr->newerPtr->olderPtr	= entryPtr->olderPtr;
+
+  if  (entryPtr->olderPtr == NULL)
+    oldestPtr			= entryPtr->newerPtr;
+  else
+    entryPtr->olderPtr->newerPtr	= entryPtr->newerPtr;
+}
+
+
+//  PURPOSE:  To put 'entryPtr' at the most recently used end of the list.
+//	No return value.
+static
+void		linkNewest	(struct CacheEntry*	entryPtr
+				)
+{
+  entryPtr->newerPtr	= NULL;
+  entryPtr->olderPtr	= newestPtr;
+
+  if  (newestPtr == NULL)
+    oldestPtr		= entryPtr;
+  else
+    newestPtr->newerPtr	= entryPtr;
+
+  newestPtr		= entryPtr;
+}
+
+
+//  PURPOSE:  To return the address of the link that points to the entry for
+//	'*requestPtr' of hash 'hash', which points to 'NULL' if there is none.
+static
+struct CacheEntry**
+		findLink	(const struct Request*	requestPtr,
+				 uint64_t		hash
+				)
+{
+  struct CacheEntry**	linkPtr	= &bucketArray[hash & (numBuckets-1)];
+
+  while  ( (*linkPtr != NULL)					&&
+	   ( ((*linkPtr)->hash != hash)				||
+	     !isSameRequest(&(*linkPtr)->key,requestPtr)
+	   )
+	 )
+    linkPtr	= &(*linkPtr)->chainPtr;
+
+  return(linkPtr);
+}
+
+
+//  PURPOSE:  To remove 'entryPtr' from the cache and free it.  No return
+//	value.
+static
+void		removeEntry	(struct CacheEntry*	entryPtr
+				)
+{
+  struct CacheEntry**	linkPtr	= findLink(&entryPtr->key,entryPtr->hash);
+
+  *linkPtr		= entryPtr->chainPtr;
+  unlinkEntry(entryPtr);
+  stats.numEntries--;
+  stats.numBytes	-= getEntryCost(entryPtr);
+  free(entryPtr->bytes);
+  free(entryPtr);
+}
+
+
+//  PURPOSE:  To double the number of hash buckets, moving every entry to
+//	its new bucket.  No return value.
+static
+void		growBuckets	()
+{
+  size_t		newNumBuckets	= 2 * numBuckets;
+  struct CacheEntry**	newBucketArray	= (struct CacheEntry**)
+					  calloc(newNumBuckets,sizeof(struct CacheEntry*));
+
+  //  Keep chains long rather than fail:
+  if  (newBucketArray == NULL)
+    return;
+
+  for  (size_t i = 0;  i < numBuckets;  i++)
+  {
+    struct CacheEntry*	entryPtr	= bucketArray[i];
+
+    while  (entryPtr != NULL)
+    {
+      struct CacheEntry*	nextPtr	= entryPtr->chainPtr;
+      size_t			bucket	= entryPtr->hash & (newNumBuckets-1);
+
+      entryPtr->chainPtr	= newBucketArray[bucket];
+      newBucketArray[bucket]	= entryPtr;
+      entryPtr			= nextPtr;
+    }
+  }
+
+  free(bucketArray);
+  bucketArray	= newBucketArray;
+  numBuckets	= newNumBuckets;
+}
+
+
+//  PURPOSE:  To make the cache hold at most 'maxBytes' bytes of replies and
+//	bookkeeping, or to disable it if 'maxBytes' is '0'.  Must be called
+//	before any other cache function.  No return value.
+void		initCache	(size_t			maxBytes
+				)
+{
+  memset(&stats,'\0',sizeof(stats));
+  stats.maxBytes	= maxBytes;
+
+  if  (maxBytes == 0)
+    return;
+
+  numBuckets	= CACHE_INIT_NUM_BUCKETS;
+  bucketArray	= (struct CacheEntry**)calloc(numBuckets,sizeof(struct CacheEntry*));
+
+  if  (bucketArray == NULL)
+  {
+    fprintf(stderr,"Out of memory making the cache.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+
+//  PURPOSE:  To return the version of the corpus the cached replies were
+//	histogrammed from.  No parameters.
+uint64_t	getCacheVersion	()
+{
+  uint64_t	version;
+
+  pthread_mutex_lock(&cacheLock);
+  version	= cacheVersion;
+  pthread_mutex_unlock(&cacheLock);
+  return(version);
+}
+
+
+//  PURPOSE:  To note that the corpus is now at version 'version', emptying
+//	the cache if it was at another one.  No return value.
+void		setCacheVersion	(uint64_t		version
+				)
+{
+  pthread_mutex_lock(&cacheLock);
+
+  if  (version != cacheVersion)
+  {
+    //  Version '0' means no corpus was noted yet:
+    if  (cacheVersion != 0)
+      stats.numInvalidations++;
+
+    cacheVersion	= version;
+
+    while  (oldestPtr != NULL)
+      removeEntry(oldestPtr);
+  }
+
+  pthread_mutex_unlock(&cacheLock);
+}
+
+
+//  PURPOSE:  To set '*replyPtr' to a copy of the cached reply to
+//	'*requestPtr', tagged with its request ID, if there is one.  Returns
+//	'1' on a hit (in which case '*replyPtr' holds a 'malloc()'-ed
+//	buffer) or '0' on a miss.
+int		lookupCache	(const struct Request*	requestPtr,
+				 struct Reply*		replyPtr
+				)
+{
+  if  (stats.maxBytes == 0)
+    return(0);
+
+  uint64_t		hash	= hashRequest(requestPtr);
+  struct CacheEntry*	entryPtr;
+
+  pthread_mutex_lock(&cacheLock);
+  entryPtr	= *findLink(requestPtr,hash);
+
+  if  (entryPtr == NULL)
+  {
+    stats.numMisses++;
+    pthread_mutex_unlock(&cacheLock);
+    return(0);
+  }
+
+  stats.numHits++;
+  unlinkEntry(entryPtr);
+  linkNewest(entryPtr);
+
+  memset(replyPtr,'\0',sizeof(*replyPtr));
+  replyPtr->version	= requestPtr->version;
+  replyPtr->requestId	= requestPtr->requestId;
+  replyPtr->numEntries	= entryPtr->numEntries;
+  replyPtr->len		= entryPtr->len;
+  replyPtr->capacity	= entryPtr->len;
+  replyPtr->bytes	= (char*)malloc(entryPtr->len);
+
+  if  (replyPtr->bytes == NULL)
+  {
+    fprintf(stderr,"Out of memory copying a cached reply.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  memcpy(replyPtr->bytes,entryPtr->bytes,entryPtr->len);
+  pthread_mutex_unlock(&cacheLock);
+
+  //  Only a version 2 reply tells its request ID:
+  if  (replyPtr->version == PROTOCOL_V2)
+    putU32(replyPtr->bytes+8,replyPtr->requestId);
+
+  return(1);
+}
+
+
+//  PURPOSE:  To cache a copy of the finished reply '*replyPtr' to
+//	'*requestPtr', histogrammed from version 'version' of the corpus.
+//	Does nothing if the corpus changed since, or if the reply does not
+//	fit.  No return value.
+void		insertCache	(const struct Request*	requestPtr,
+				 uint64_t		version,
+				 const struct Reply*	replyPtr
+				)
+{
+  if  ( (stats.maxBytes == 0)  ||
+	(sizeof(struct CacheEntry) + replyPtr->len > stats.maxBytes)
+      )
+    return;
+
+  //  Copy outside the lock:
+  struct CacheEntry*	entryPtr	= (struct CacheEntry*)
+					  calloc(1,sizeof(struct CacheEntry));
+
+  if  (entryPtr == NULL)
+    return;
+
+  entryPtr->bytes	= (char*)malloc(replyPtr->len);
+
+  if  (entryPtr->bytes == NULL)
+  {
+    free(entryPtr);
+    return;
+  }
+
+  entryPtr->key			= *requestPtr;
+  entryPtr->key.requestId	= 0;
+  entryPtr->hash		= hashRequest(requestPtr);
+  entryPtr->len			= replyPtr->len;
+  entryPtr->numEntries		= replyPtr->numEntries;
+  memcpy(entryPtr->bytes,replyPtr->bytes,replyPtr->len);
+
+  pthread_mutex_lock(&cacheLock);
+
+  //  Another worker may have cached the same reply meanwhile:
+  struct CacheEntry**	linkPtr		= findLink(requestPtr,entryPtr->hash);
+
+  if  ( (version != cacheVersion)  ||  (*linkPtr != NULL) )
+  {
+    pthread_mutex_unlock(&cacheLock);
+    free(entryPtr->bytes);
+    free(entryPtr);
+    return;
+  }
+
+  *linkPtr		= entryPtr;
+  linkNewest(entryPtr);
+  stats.numInserts++;
+  stats.numEntries++;
+  stats.numBytes	+= getEntryCost(entryPtr);
+
+  while  (stats.numBytes > stats.maxBytes)
+  {
+    removeEntry(oldestPtr);
+    stats.numEvictions++;
+  }
+
+  if  (stats.numEntries > numBuckets)
+    growBuckets();
+
+  pthread_mutex_unlock(&cacheLock);
+}
+
+
+//  PURPOSE:  To set '*statsPtr' to the current counters of the cache.  No
+//	return value.
+void		getCacheStats	(struct CacheStats*	statsPtr
+				)
+{
+  pthread_mutex_lock(&cacheLock);
+  *statsPtr	= stats;
+  pthread_mutex_unlock(&cacheLock);
+}
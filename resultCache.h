@@ -0,0 +1,79 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		resultCache.h						---*
+ *---									---*
+ *---	    This file declares the server's cache of finished replies,	---*
+ *---	shared by the event loop and every worker.  A reply is kept	---*
+ *---	in the form it is sent, and is found again by its request	---*
+ *---	(version, opcode, flags, wordIndex, wordCount and argument)	---*
+ *---	and the version of the corpus it was histogrammed from.  The	---*
+ *---	least recently used replies are evicted to keep the cache	---*
+ *---	within its byte budget, and the whole cache is emptied when	---*
+ *---	the corpus changes.						---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//---		Definition of types:					---//
+
+//  PURPOSE:  To hold the counters of the cache.
+struct		CacheStats
+{
+  uint64_t	numHits;
+  uint64_t	numMisses;
+  uint64_t	numInserts;
+  uint64_t	numEvictions;
+  uint64_t	numInvalidations;
+  uint64_t	numEntries;
+  uint64_t	numBytes;
+  uint64_t	maxBytes;
+};
+
+
+//---		Definition of functions:				---//
+
+//  PURPOSE:  To make the cache hold at most 'maxBytes' bytes of replies and
+//	bookkeeping, or to disable it if 'maxBytes' is '0'.  Must be called
+//	before any other cache function.  No return value.
+extern
+void		initCache	(size_t			maxBytes
+				);
+
+//  PURPOSE:  To return the version of the corpus the cached replies were
+//	histogrammed from.  No parameters.
+extern
+uint64_t	getCacheVersion	();
+
+//  PURPOSE:  To note that the corpus is now at version 'version', emptying
+//	the cache if it was at another one.  No return value.
+extern
+void		setCacheVersion	(uint64_t		version
+				);
+
+//  PURPOSE:  To set '*replyPtr' to a copy of the cached reply to
+//	'*requestPtr', tagged with its request ID, if there is one.  Returns
+//	'1' on a hit (in which case '*replyPtr' holds a 'malloc()'-ed
+//	buffer) or '0' on a miss.
+extern
+int		lookupCache	(const struct Request*	requestPtr,
+				 struct Reply*		replyPtr
+				);
+
+//  PURPOSE:  To cache a copy of the finished reply '*replyPtr' to
+//	'*requestPtr', histogrammed from version 'version' of the corpus.
+//	Does nothing if the corpus changed since, or if the reply does not
+//	fit.  No return value.
+extern
+void		insertCache	(const struct Request*	requestPtr,
+				 uint64_t		version,
+				 const struct Reply*	replyPtr
+				);
+
+//  PURPOSE:  To set '*statsPtr' to the current counters of the cache.  No
+//	return value.
+extern
+void		getCacheStats	(struct CacheStats*	statsPtr
+				);
@@ -0,0 +1,305 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		serverMetrics.c						---*
+ *---									---*
+ *---	    This file defines the server's metrics, as serverMetrics.h	---*
+ *---	describes.							---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//	Compiled into wordHistogramServer, see wordHistogramServer.c.
+
+//---		Header file inclusion					---//
+
+#include	"header.h"
+#include	<stdint.h>	// For uint64_t
+#include	<time.h>	// For clock_gettime()
+#include	"serverMetrics.h"
+
+
+//---		Definition of constants:				---//
+
+//  PURPOSE:  To tell the name of each latency, in the order of
+//	'enum LatencyKind'.
+static const char*	latencyNameArray[NUM_LATENCY_KINDS]
+			= { "firstByte", "replyFirstByte", "queueWait", "spawn", "count", "service", "send" };
+
+//  PURPOSE:  To tell the name of each counter, in the order of
+//	'enum CounterKind'.
+static const char*	counterNameArray[NUM_COUNTER_KINDS]
+			= { "requests", "wordsCounted", "bytesSent" };
+
+
+//---		Definition of types:					---//
+
+//  PURPOSE:  To hold the metrics one thread notes.  It starts on a cache
+//	line of its own, so threads noting metrics do not slow each other.
+struct		ThreadMetrics
+{
+  uint64_t	bucketArray[NUM_LATENCY_KINDS][METRICS_NUM_BUCKETS];
+  uint64_t	maxNsArray[NUM_LATENCY_KINDS];
+  uint64_t	counterArray[NUM_COUNTER_KINDS];
+}
+__attribute__((aligned(64)));
+
+
+//---		Definition of global vars:				---//
+
+//  PURPOSE:  To hold the slot of each thread.
+static struct ThreadMetrics*	slotArray	= NULL;
+
+//  PURPOSE:  To tell the number of slots in 'slotArray'.
+static int			numSlots	= 0;
+
+//  PURPOSE:  To point to the slot of the calling thread, or 'NULL' if it has
+//	none.
+static __thread struct ThreadMetrics*	threadSlotPtr	= NULL;
+
+//  PURPOSE:  To tell the time the server started, in nanoseconds.
+static uint64_t			startNs		= 0;
+
+//  PURPOSE:  To tell the time of the last 'reportMetrics()', in
+//	nanoseconds, and the words and bytes counted up to then.
+static uint64_t			lastReportNs	= 0;
+static uint64_t			lastNumWords	= 0;
+static uint64_t			lastNumBytes	= 0;
+
+
+//---		Definition of functions:				---//
+
+//  PURPOSE:  To add 'amount' to '*valuePtr', which only the calling thread
+//	writes.  A relaxed load and store are enough for that, and readers in
+//	other threads see either the old or the new value, never a torn one.
+//	No return value.
+static
+inline
+void		bump		(uint64_t*	valuePtr,
+				 uint64_t	amount
+				)
+{
+  __atomic_store_n(valuePtr,
+		   __atomic_load_n(valuePtr,__ATOMIC_RELAXED) + amount,
+		   __ATOMIC_RELAXED
+		  );
+}
+
+
+//  PURPOSE:  To return the index of the bucket of 'ns'.  The values below
+//	'METRICS_SUB_BUCKETS' have a bucket each, and every power of 2 above
+//	is cut in 'METRICS_SUB_BUCKETS' buckets by its next bits.
+static
+inline
+int		getBucket	(uint64_t	ns
+				)
+{
+  if  (ns < METRICS_SUB_BUCKETS)
+    return((int)ns);
+
+  int	shift	= 63 - __builtin_clzll(ns) - METRICS_SUB_BUCKET_BITS;
+
+  return( (shift + 1) * METRICS_SUB_BUCKETS  +
+	  (int)((ns >> shift) & (METRICS_SUB_BUCKETS - 1))
+	);
+}
+
+
+//  PURPOSE:  To return the highest value in bucket 'bucket'.
+static
+uint64_t	getBucketHighNs	(int		bucket
+				)
+{
+  if  (bucket < METRICS_SUB_BUCKETS)
+    return(bucket);
+
+  int	shift	= bucket / METRICS_SUB_BUCKETS - 1;
+  int	sub	= bucket % METRICS_SUB_BUCKETS;
+
+  return( (((uint64_t)(METRICS_SUB_BUCKETS + sub + 1)) << shift) - 1 );
+}
+
+
+//  PURPOSE:  To return the value that 'quantile' of the 'numValues' values
+//	noted in 'bucketArray[]' are at most (to within their bucket), but
+//	never more than 'maxNs'.
+static
+uint64_t	getQuantileNs	(const uint64_t	bucketArray[METRICS_NUM_BUCKETS],
+				 uint64_t	numValues,
+				 uint64_t	maxNs,
+				 double		quantile
+				)
+{
+  uint64_t	rank	= (uint64_t)(quantile * numValues + 0.999999);
+  uint64_t	seen	= 0;
+
+  if  (rank < 1)
+    rank	= 1;
+
+  for  (int bucket = 0;  bucket < METRICS_NUM_BUCKETS;  bucket++)
+  {
+    seen	+= bucketArray[bucket];
+
+    if  (seen >= rank)
+    {
+      uint64_t	ns	= getBucketHighNs(bucket);
+
+      return( (ns < maxNs) ? ns : maxNs );
+    }
+  }
+
+  return(maxNs);
+}
+
+
+//  PURPOSE:  To make a slot for each of 'numThreads' threads, and to note
+//	the time the server started.  Must be called before any other metrics
+//	function.  No return value.
+void		initMetrics	(int		numThreads
+				)
+{
+  slotArray	= (struct ThreadMetrics*)aligned_alloc(64,numThreads * sizeof(struct ThreadMetrics));
+
+  if  (slotArray == NULL)
+  {
+    fprintf(stderr,"Out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+
+  memset(slotArray,'\0',numThreads * sizeof(struct ThreadMetrics));
+  numSlots	= numThreads;
+  startNs	= getNowNs();
+  lastReportNs	= startNs;
+}
+
+
+//  PURPOSE:  To make the calling thread note its metrics in slot
+//	'threadIndex', which no other thread may use.  Until it does, the
+//	metrics it notes are dropped.  No return value.
+void		setThreadMetrics(int		threadIndex
+				)
+{
+  threadSlotPtr	= &slotArray[threadIndex];
+}
+
+
+//  PURPOSE:  To return the current monotonic time in nanoseconds.  No
+//	parameters.
+uint64_t	getNowNs	()
+{
+  struct timespec	ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+
+//  PURPOSE:  To note, in the slot of the calling thread, one latency of kind
+//	'kind' that took 'ns' nanoseconds.  No return value.
+void		noteLatency	(enum LatencyKind	kind,
+				 uint64_t		ns
+				)
+{
+  struct ThreadMetrics*	slotPtr	= threadSlotPtr;
+
+  if  (slotPtr == NULL)
+    return;
+
+  bump(&slotPtr->bucketArray[kind][getBucket(ns)],1);
+
+  if  (ns > slotPtr->maxNsArray[kind])
+    __atomic_store_n(&slotPtr->maxNsArray[kind],ns,__ATOMIC_RELAXED);
+}
+
+
+//  PURPOSE:  To add 'amount' to the counter of kind 'kind' in the slot of
+//	the calling thread.  No return value.
+void		addCounter	(enum CounterKind	kind,
+				 uint64_t		amount
+				)
+{
+  if  (threadSlotPtr != NULL)
+    bump(&threadSlotPtr->counterArray[kind],amount);
+}
+
+
+//  PURPOSE:  To give 'sink' (with 'sinkPtr') every metric, added up over
+//	all slots: the counters with the number of seconds they took, the
+//	words and bytes per second since the last call, and the count, p50,
+//	p99, p99.9 and maximum of each latency in microseconds.  Only called
+//	by one thread at a time.  No return value.
+void		reportMetrics	(MetricSink	sink,
+				 void*		sinkPtr
+				)
+{
+  //  I.  Counters and rates:
+  uint64_t	nowNs	= getNowNs();
+  uint64_t	counterArray[NUM_COUNTER_KINDS];
+
+  for  (int kind = 0;  kind < NUM_COUNTER_KINDS;  kind++)
+  {
+    counterArray[kind]	= 0;
+
+    for  (int i = 0;  i < numSlots;  i++)
+      counterArray[kind] += __atomic_load_n(&slotArray[i].counterArray[kind],__ATOMIC_RELAXED);
+
+    (*sink)(sinkPtr,counterNameArray[kind],counterArray[kind]);
+  }
+
+  double	secs	= (nowNs - lastReportNs) / 1e9;
+
+  (*sink)(sinkPtr,"uptimeSecs",(nowNs - startNs) / 1000000000);
+  (*sink)(sinkPtr,"wordsPerSec",
+	  (secs > 0) ? (uint64_t)((counterArray[COUNTER_WORDS] - lastNumWords) / secs) : 0
+	 );
+  (*sink)(sinkPtr,"bytesSentPerSec",
+	  (secs > 0) ? (uint64_t)((counterArray[COUNTER_BYTES_SENT] - lastNumBytes) / secs) : 0
+	 );
+
+  lastReportNs	= nowNs;
+  lastNumWords	= counterArray[COUNTER_WORDS];
+  lastNumBytes	= counterArray[COUNTER_BYTES_SENT];
+
+  //  II.  Latencies, one histogram at a time:
+  uint64_t	bucketArray[METRICS_NUM_BUCKETS];
+  char		name[BUFFER_LEN];
+
+  for  (int kind = 0;  kind < NUM_LATENCY_KINDS;  kind++)
+  {
+    uint64_t	numValues	= 0;
+    uint64_t	maxNs		= 0;
+
+    memset(bucketArray,'\0',sizeof(bucketArray));
+
+    for  (int i = 0;  i < numSlots;  i++)
+    {
+      uint64_t	slotMaxNs	= __atomic_load_n(&slotArray[i].maxNsArray[kind],__ATOMIC_RELAXED);
+
+      for  (int bucket = 0;  bucket < METRICS_NUM_BUCKETS;  bucket++)
+      {
+	uint64_t	count	= __atomic_load_n(&slotArray[i].bucketArray[kind][bucket],
+						  __ATOMIC_RELAXED
+						 );
+
+	bucketArray[bucket]	+= count;
+	numValues		+= count;
+      }
+
+      if  (maxNs < slotMaxNs)
+	maxNs	= slotMaxNs;
+    }
+
+    snprintf(name,sizeof(name),"%sCount",latencyNameArray[kind]);
+    (*sink)(sinkPtr,name,numValues);
+    snprintf(name,sizeof(name),"%sP50Us",latencyNameArray[kind]);
+    (*sink)(sinkPtr,name,getQuantileNs(bucketArray,numValues,maxNs,0.5) / 1000);
+    snprintf(name,sizeof(name),"%sP99Us",latencyNameArray[kind]);
+    (*sink)(sinkPtr,name,getQuantileNs(bucketArray,numValues,maxNs,0.99) / 1000);
+    snprintf(name,sizeof(name),"%sP999Us",latencyNameArray[kind]);
+    (*sink)(sinkPtr,name,getQuantileNs(bucketArray,numValues,maxNs,0.999) / 1000);
+    snprintf(name,sizeof(name),"%sMaxUs",latencyNameArray[kind]);
+    (*sink)(sinkPtr,name,maxNs / 1000);
+  }
+}
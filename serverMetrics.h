@@ -0,0 +1,117 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		serverMetrics.h						---*
+ *---									---*
+ *---	    This file declares the server's metrics: counters and	---*
+ *---	latency histograms kept by each thread in its own slot, which	---*
+ *---	only it writes, so noting one takes no lock and no locked	---*
+ *---	instruction.  They are added up over all slots only when asked	---*
+ *---	for.  A latency histogram has, like an HDR histogram, a fixed	---*
+ *---	number of buckets per power of 2, so each value is kept to	---*
+ *---	within 1/'METRICS_SUB_BUCKETS' of itself from nanoseconds to	---*
+ *---	centuries in a fixed number of bytes.				---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1a		2021 August 16		Huseyn Mammadov	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//---		Definition of constants:				---//
+
+//  PURPOSE:  To tell the number of bits of a value its bucket keeps, and so
+//	the number of buckets per power of 2.
+#define		METRICS_SUB_BUCKET_BITS	5
+#define		METRICS_SUB_BUCKETS	(1 << METRICS_SUB_BUCKET_BITS)
+
+//  PURPOSE:  To tell the number of buckets of a latency histogram, enough
+//	for any 64-bit number of nanoseconds.
+#define		METRICS_NUM_BUCKETS	((65 - METRICS_SUB_BUCKET_BITS) * METRICS_SUB_BUCKETS)
+
+//  PURPOSE:  To tell which latency is noted.  'LATENCY_FIRST_BYTE' runs
+//	from when a connection was accepted until the first byte of its first
+//	reply was sent, 'LATENCY_REPLY_FIRST_BYTE' from when the event loop
+//	read a request until the first byte of its reply was sent,
+//	'LATENCY_QUEUE_WAIT' until a worker took it,
+//	'LATENCY_SPAWN' runs from before the fork() of a histogrammer
+//	until it has loaded its corpus and is ready for requests,
+//	'LATENCY_COUNT' the time a worker spent histogramming a request,
+//	'LATENCY_SERVICE' runs from when a worker took a request until its
+//	reply was finished and handed back, and 'LATENCY_SEND' runs from when its reply was finished until its last
+//	byte was sent.
+enum		LatencyKind
+{
+  LATENCY_FIRST_BYTE,
+  LATENCY_REPLY_FIRST_BYTE,
+  LATENCY_QUEUE_WAIT,
+  LATENCY_SPAWN,
+  LATENCY_COUNT,
+  LATENCY_SERVICE,
+  LATENCY_SEND,
+  NUM_LATENCY_KINDS
+};
+
+//  PURPOSE:  To tell which counter is added to.
+enum		CounterKind
+{
+  COUNTER_REQUESTS,
+  COUNTER_WORDS,
+  COUNTER_BYTES_SENT,
+  NUM_COUNTER_KINDS
+};
+
+
+//---		Definition of types:					---//
+
+//  PURPOSE:  To be given each metric by 'reportMetrics()', with the
+//	'sinkPtr' given to it, its name 'nameCPtr' and its value 'value'.
+typedef	void	(*MetricSink)	(void*		sinkPtr,
+				 const char*	nameCPtr,
+				 uint64_t	value
+				);
+
+
+//---		Definition of functions:				---//
+
+//  PURPOSE:  To make a slot for each of 'numThreads' threads, and to note
+//	the time the server started.  Must be called before any other metrics
+//	function.  No return value.
+extern
+void		initMetrics	(int		numThreads
+				);
+
+//  PURPOSE:  To make the calling thread note its metrics in slot
+//	'threadIndex', which no other thread may use.  Until it does, the
+//	metrics it notes are dropped.  No return value.
+extern
+void		setThreadMetrics(int		threadIndex
+				);
+
+//  PURPOSE:  To return the current monotonic time in nanoseconds.  No
+//	parameters.
+extern
+uint64_t	getNowNs	();
+
+//  PURPOSE:  To note, in the slot of the calling thread, one latency of kind
+//	'kind' that took 'ns' nanoseconds.  No return value.
+extern
+void		noteLatency	(enum LatencyKind	kind,
+				 uint64_t		ns
+				);
+
+//  PURPOSE:  To add 'amount' to the counter of kind 'kind' in the slot of
+//	the calling thread.  No return value.
+extern
+void		addCounter	(enum CounterKind	kind,
+				 uint64_t		amount
+				);
+
+//  PURPOSE:  To give 'sink' (with 'sinkPtr') every metric, added up over
+//	all slots: the counters with the number of seconds they took, the
+//	words and bytes per second since the last call, and the count, p50,
+//	p99, p99.9 and maximum of each latency in microseconds.  Only called
+//	by one thread at a time.  No return value.
+extern
+void		reportMetrics	(MetricSink	sink,
+				 void*		sinkPtr
+				);
@@ -3,8 +3,9 @@
  *---		wordHistogramClient.c					---*
  *---									---*
  *---	    This file defines a C program that gets commands from the	---*
- *---	user, and sends them to a server via a socket, waits for a	---*
- *---	reply, and outputs the response to the user.			---*
+ *---	user or its command line, and sends them to a server via a	---*
+ *---	socket, waits for a reply, and outputs the response to the	---*
+ *---	user.								---*
  *---									---*
  *---	----	----	----	----	----	----	----	----	---*
  *---									---*
@@ -13,24 +14,35 @@
  *-------------------------------------------------------------------------*/
 
 //	Compile with:
-//	$ gcc wordHistogramClient.c -o wordHistogramClient
+//	$ gcc wordHistogramClient.c protocol.c -o wordHistogramClient -lpthread
 
 //---		Header file inclusion					---//
 
 #include	"header.h"
+#include	"protocol.h"
+#include	<pthread.h>	// For pthread_create()
+#include	<getopt.h>	// For getopt_long()
+#include	<time.h>	// For clock_gettime()
 
 
 //---		Definition of constants:				---//
 
 #define	DEFAULT_HOSTNAME	"localhost"
 
+//  PURPOSE:  To tell the most batch requests sent with one 'write()'.
+#define	BATCH_REQUESTS_PER_WRITE	256
+
+//  PURPOSE:  To mark a batch request that got no reply in 'latencyNsArray'.
+#define	NO_LATENCY			UINT64_MAX
 
 
 //---		Definition of functions:				---//
 
-//  PURPOSE:  To ask the user for the name and the port of the server.  The
-//	server name is returned in 'url' up to length 'urlLen'.  The port
-//	number is returned in '*portPtr'.  No return value.
+//  PURPOSE:  To ask the user for the name and the port of the server, unless
+//	they were given on the command line.  The server name is returned in
+//	'url' up to length 'urlLen', and is asked for if 'url' is empty.  The
+//	port number is returned in '*portPtr', and is asked for if it is not
+//	positive.  No return value.
 void	obtainUrlAndPort	(int		urlLen,
 				 char*		url,
 				 int*		portPtr
@@ -51,24 +63,37 @@ void	obtainUrlAndPort	(int		urlLen,
 
   //  II.  Get server name and port number:
   //  II.A.  Get server name:
-  printf("Machine name [%s]? ",DEFAULT_HOSTNAME);
-  fgets(url,urlLen,stdin);
+  if  (url[0] == '\0')
+  {
+    printf("Machine name [%s]? ",DEFAULT_HOSTNAME);
 
-  char*	cPtr	= strchr(url,'\n');
+    if  (fgets(url,urlLen,stdin) == NULL)
+      url[0]	= '\0';
 
-  if  (cPtr != NULL)
-    *cPtr = '\0';
+    char*	cPtr	= strchr(url,'\n');
 
-  if  (url[0] == '\0')
-    strncpy(url,DEFAULT_HOSTNAME,urlLen);
+    if  (cPtr != NULL)
+      *cPtr = '\0';
+
+    if  (url[0] == '\0')
+      strncpy(url,DEFAULT_HOSTNAME,urlLen);
+  }
 
   //  II.B.  Get port numbe:
   char	buffer[BUFFER_LEN];
 
-  printf("Port number? ");
-  fgets(buffer,BUFFER_LEN,stdin);
+  if  (*portPtr <= 0)
+  {
+    printf("Port number? ");
+
+    if  (fgets(buffer,BUFFER_LEN,stdin) == NULL)
+    {
+      fprintf(stderr,"No port number\n");
+      exit(EXIT_FAILURE);
+    }
 
-  *portPtr = strtol(buffer,NULL,10);
+    *portPtr = strtol(buffer,NULL,10);
+  }
 
   //  III.  Finished:
 }
@@ -100,7 +125,7 @@ int	attemptToConnectToServer	(const char*	url,
 
   if (status != 0)
   {
-    fprintf(stderr,gai_strerror(status));
+    fprintf(stderr,"%s\n",gai_strerror(status));
     return(-1);
   }
 
@@ -134,11 +159,88 @@ int	attemptToConnectToServer	(const char*	url,
 }
 
 
+//  PURPOSE:  To read one version 2 reply from 'inputPtr'.  Sets '*statusPtr',
+//	'*flagsPtr', '*requestIdPtr' and '*numEntriesPtr' from its header, and
+//	'*payloadPtr' to a 'malloc()'-ed copy of its '*payloadLenPtr' bytes of
+//	payload, which the caller must 'free()'.  Returns '1' on success or
+//	'0' on error or end of file.
+int		receiveReply	(FILE*		inputPtr,
+				 int*		statusPtr,
+				 int*		flagsPtr,
+				 uint32_t*	requestIdPtr,
+				 uint32_t*	numEntriesPtr,
+				 char**		payloadPtr,
+				 uint32_t*	payloadLenPtr
+				)
+{
+  char		header[PROTOCOL_V2_HEADER_LEN];
+
+  if  ( (fread(header,sizeof(header),1,inputPtr) != 1)  ||
+	(getU32(header) != PROTOCOL_MAGIC)
+      )
+    return(0);
+
+  *statusPtr		= getU16(header+4);
+  *flagsPtr		= getU16(header+6);
+  *requestIdPtr		= getU32(header+8);
+  *numEntriesPtr	= getU32(header+12);
+  *payloadLenPtr	= getU32(header+16);
+  *payloadPtr		= (char*)malloc(*payloadLenPtr + 1);
+
+  if  ( (*payloadPtr == NULL)  ||
+	( (*payloadLenPtr > 0)  &&
+	  (fread(*payloadPtr,*payloadLenPtr,1,inputPtr) != 1)
+	)
+      )
+  {
+    free(*payloadPtr);
+    return(0);
+  }
+
+  return(1);
+}
+
+
+//  PURPOSE:  To print the 'numEntries' entries in the 'payloadLen' bytes at
+//	'payload'.  No return value.
+void		printEntries	(const char*	payload,
+				 uint32_t	payloadLen,
+				 uint32_t	numEntries
+				)
+{
+  const char*	cPtr		= payload;
+  const char*	endPtr		= payload + payloadLen;
+
+  for  (uint32_t i = 0;  i < numEntries;  i++)
+  {
+    if  ((size_t)(endPtr - cPtr) < sizeof(uint32_t) + sizeof(uint16_t))
+      break;
+
+    uint32_t	count	= getU32(cPtr);
+    uint16_t	wordLen	= getU16(cPtr+sizeof(uint32_t));
+
+    cPtr	+= sizeof(uint32_t) + sizeof(uint16_t);
+
+    if  (endPtr - cPtr < wordLen)
+      break;
+
+    printf("%2u: %.*s\n",count,(int)wordLen,cPtr);
+    cPtr	+= wordLen;
+  }
+}
+
+
 //  PURPOSE:  To do the work of the application.  Gets letter from user, sends
 //	it to server over file-descriptor 'socketFd', and prints returned text.
-//	No return value.
+//	The request is '*requestPtr' with the word range filled in, so its
+//	opcode, flags and argument can ask for the top words or for deltas,
+//	which are printed as they come before the whole histogram.  The
+//	beginning word's index is only asked for if it is negative, and the
+//	number of words only if it is not positive, so both can come from the
+//	command line instead.  No return value.
 void		communicateWithServer
-				(int		socketFd
+				(int			socketFd,
+				 struct Request*	requestPtr
 				)
 {
   //  I.  Application validity check:
@@ -146,69 +248,643 @@ void		communicateWithServer
   //  II.  Do work of application:
   //  II.A.  Get letter from user:
   char	buffer[BUFFER_LEN+1];
-  int	shouldContinue	= 1;
-  int	wordIndex;
-  int	wordCount;
 
-  do
+  while  (requestPtr->wordIndex < 0)
   {
     printf("Please enter the beginning word's index (a non-negative int): ");
-    fgets(buffer,BUFFER_LEN,stdin);
-    wordIndex	= strtol(buffer,NULL,0);
+
+    if  (fgets(buffer,BUFFER_LEN,stdin) == NULL)
+      return;
+
+    requestPtr->wordIndex	= strtol(buffer,NULL,0);
   }
-  while  (wordIndex < 0);
 
-  do
+  while  (requestPtr->wordCount < 1)
   {
     printf("Please enter the number of words to histogram (a positive int): ");
-    fgets(buffer,BUFFER_LEN,stdin);
-    wordCount	= strtol(buffer,NULL,0);
+
+    if  (fgets(buffer,BUFFER_LEN,stdin) == NULL)
+      return;
+
+    requestPtr->wordCount	= strtol(buffer,NULL,0);
   }
-  while  (wordCount < 1);
 
-  int*	 iPtr	= (int*)buffer;
+  //  II.B.  Send request:
+  char			requestBytes[PROTOCOL_MAX_REQUEST_LEN];
 
-  iPtr[0]	= htonl(wordIndex);
-  iPtr[1]	= htonl(wordCount);
-  write(socketFd,buffer,sizeof(int)*2);
+  write(socketFd,requestBytes,encodeRequest(requestPtr,requestBytes));
 
-  FILE*	inputPtr	= fdopen(socketFd,"r");
+  //  II.C.  Get each reply header, then its whole payload in one read, until
+  //	the reply that is not a delta:
+  FILE*		inputPtr	= fdopen(dup(socketFd),"r");
+  int		status;
+  int		flags;
+  uint32_t	requestId;
+  uint32_t	numEntries;
+  char*		payload;
+  uint32_t	payloadLen;
 
-  while  (fgets(buffer,BUFFER_LEN,inputPtr) != NULL)
+  do
   {
-    int	count	= ntohl(iPtr[0]);
-
-    if  (count == 0)
+    if  (!receiveReply(inputPtr,&status,&flags,&requestId,&numEntries,&payload,&payloadLen))
+    {
+      fprintf(stderr,"Bad reply\n");
       break;
+    }
 
-    if  (count < 0)
-    {
+    if  (status == STATUS_BUSY)
+      fprintf(stderr,"Busy, try again later\n");
+    else
+    if  (status != STATUS_OK)
       fprintf(stderr,"Error\n");
+
+    //  II.D.  Print entries:
+    if  (flags & REPLY_FLAG_DELTA)
+      printf("--- delta: %u words changed ---\n",numEntries);
+    else
+    if  (requestPtr->flags & REQUEST_FLAG_STREAM)
+      printf("--- final: %u words ---\n",numEntries);
+
+    printEntries(payload,payloadLen,numEntries);
+    fflush(stdout);
+    free(payload);
+  }
+  while  (flags & REPLY_FLAG_DELTA);
+
+  fclose(inputPtr);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To ask the server over 'socketFd' for its counters, and to print
+//	them.  Returns 'EXIT_SUCCESS' on success or 'EXIT_FAILURE' otherwise.
+int		communicateStats(int		socketFd
+				)
+{
+  struct Request	request;
+  char			requestBytes[PROTOCOL_MAX_REQUEST_LEN];
+
+  memset(&request,'\0',sizeof(request));
+  request.version	= PROTOCOL_V2;
+  request.opcode	= OPCODE_STATS;
+  write(socketFd,requestBytes,encodeRequest(&request,requestBytes));
+
+  FILE*		inputPtr	= fdopen(dup(socketFd),"r");
+  int		status;
+  int		flags;
+  uint32_t	requestId;
+  uint32_t	numEntries;
+  char*		payload;
+  uint32_t	payloadLen;
+
+  if  ( !receiveReply(inputPtr,&status,&flags,&requestId,&numEntries,&payload,&payloadLen)  ||
+	(status != STATUS_OK)
+      )
+  {
+    fprintf(stderr,"Bad reply\n");
+    fclose(inputPtr);
+    return(EXIT_FAILURE);
+  }
+
+  printEntries(payload,payloadLen,numEntries);
+  free(payload);
+  fclose(inputPtr);
+  return(EXIT_SUCCESS);
+}
+
+
+
+
+//  PURPOSE:  To return the current monotonic time in nanoseconds.  No
+//	parameters.
+uint64_t	getNowNs	()
+{
+  struct timespec	ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+
+//  PURPOSE:  To hold the requests of a batch, when each was sent and how
+//	long its reply took to come ('NO_LATENCY' until it does), and the lock
+//	that keeps the replies that come over different connections from being
+//	printed into each other.
+struct		Batch
+{
+  struct Request*	requestArray;
+  uint32_t		numRequests;
+  int			numConnections;
+  uint64_t*		sentNsArray;
+  uint64_t*		latencyNsArray;
+  pthread_mutex_t	outputLock;
+};
+
+
+//  PURPOSE:  To hold one connection of a batch: its socket, the first of the
+//	requests it carries (it carries every 'numConnections'-th one from
+//	there on) and how many of them there are, the threads that send them
+//	and that read their replies, and how many replies came and failed.
+struct		Connection
+{
+  struct Batch*	batchPtr;
+  int		socketFd;
+  uint32_t	first;
+  uint32_t	numRequests;
+  uint32_t	numReplies;
+  uint32_t	numFailed;
+  pthread_t	senderId;
+  pthread_t	receiverId;
+};
+
+
+//  PURPOSE:  To send all the requests of the 'struct Connection' pointed to by
+//	'vPtr' back to back over its socket, without waiting for replies, and
+//	then to tell the server that no more requests come.  Each request is
+//	noted as sent when the 'write()' that carries it begins.  Returns
+//	'NULL'.
+void*		sendBatch	(void*		vPtr
+				)
+{
+  struct Connection*	connectionPtr	= (struct Connection*)vPtr;
+  struct Batch*		batchPtr	= connectionPtr->batchPtr;
+  uint32_t		stride		= batchPtr->numConnections;
+  uint32_t		firstUnsent	= connectionPtr->first;
+  char			buffer[PROTOCOL_MAX_REQUEST_LEN * BATCH_REQUESTS_PER_WRITE];
+  size_t		len		= 0;
+
+  for  (uint32_t i = connectionPtr->first;  i < batchPtr->numRequests;  i += stride)
+  {
+    len	+= encodeRequest(&batchPtr->requestArray[i],buffer+len);
+
+    if  ( (len + PROTOCOL_MAX_REQUEST_LEN > sizeof(buffer))  ||
+	  (i + stride >= batchPtr->numRequests)
+	)
+    {
+      uint64_t	nowNs	= getNowNs();
+
+      //  (released, so the receiving thread sees it once the reply is in)
+      for  ( ;  firstUnsent <= i;  firstUnsent += stride)
+	__atomic_store_n(&batchPtr->sentNsArray[firstUnsent],nowNs,__ATOMIC_RELEASE);
+
+      if  (write(connectionPtr->socketFd,buffer,len) != (ssize_t)len)
+	break;
+
+      len	= 0;
+    }
+  }
+
+  shutdown(connectionPtr->socketFd,SHUT_WR);
+  return(NULL);
+}
+
+
+//  PURPOSE:  To read the replies to all the requests of the
+//	'struct Connection' pointed to by 'vPtr' from its socket, to note how
+//	long each took, and to print each as it arrives, which may be out of
+//	order, with its request and latency.  Returns 'NULL'.
+void*		receiveBatch	(void*		vPtr
+				)
+{
+  struct Connection*	connectionPtr	= (struct Connection*)vPtr;
+  struct Batch*		batchPtr	= connectionPtr->batchPtr;
+  FILE*			replyPtr	= fdopen(dup(connectionPtr->socketFd),"r");
+
+  while  (connectionPtr->numReplies < connectionPtr->numRequests)
+  {
+    int		status;
+    int		flags;
+    uint32_t	requestId;
+    uint32_t	numEntries;
+    char*	payload;
+    uint32_t	payloadLen;
+
+    if  (!receiveReply(replyPtr,&status,&flags,&requestId,&numEntries,&payload,&payloadLen))
+    {
+      fprintf(stderr,"Bad reply\n");
       break;
     }
 
-    printf("%2d: %s",count,buffer+sizeof(int));
+    uint64_t	nowNs	= getNowNs();
+
+    connectionPtr->numReplies++;
+    pthread_mutex_lock(&batchPtr->outputLock);
+
+    //  Only a request sent over this connection can be answered over it:
+    if  ( (requestId >= batchPtr->numRequests)  ||
+	  (requestId % batchPtr->numConnections != connectionPtr->first)
+	)
+      printf("Request %u (unknown):\n",requestId);
+    else
+    {
+      uint64_t	latencyNs	= nowNs - __atomic_load_n(&batchPtr->sentNsArray[requestId],
+							  __ATOMIC_ACQUIRE
+							 );
+
+      batchPtr->latencyNsArray[requestId]	= latencyNs;
+      printf("Request %u (%d %d) in %.3f ms:\n",
+	     requestId,
+	     batchPtr->requestArray[requestId].wordIndex,
+	     batchPtr->requestArray[requestId].wordCount,
+	     latencyNs / 1e6
+	    );
+    }
+
+    if  (status != STATUS_OK)
+    {
+      printf( (status == STATUS_BUSY) ? "Busy\n" : "Error\n" );
+      connectionPtr->numFailed++;
+    }
+
+    printEntries(payload,payloadLen,numEntries);
+    pthread_mutex_unlock(&batchPtr->outputLock);
+    free(payload);
+  }
+
+  fclose(replyPtr);
+  return(NULL);
+}
+
+
+//  PURPOSE:  To compare the latencies pointed to by 'lhs' and 'rhs' for
+//	'qsort()'.
+int		compareLatency	(const void*	lhs,
+				 const void*	rhs
+				)
+{
+  uint64_t	l	= *(const uint64_t*)lhs;
+  uint64_t	r	= *(const uint64_t*)rhs;
+
+  return( (l < r) ? -1 : (l > r) ? 1 : 0 );
+}
+
+
+//  PURPOSE:  To return the latency at fraction 'fraction' of the 'numTimed'
+//	sorted latencies in 'latencyNsArray', by nearest rank: the smallest
+//	one that at least that fraction of them are no greater than.
+uint64_t	getPercentileNs	(const uint64_t*	latencyNsArray,
+				 uint32_t		numTimed,
+				 double			fraction
+				)
+{
+  double	rank	= fraction * numTimed;
+  uint32_t	i	= (uint32_t)rank;
+
+  //  'i' is the rank rounded up, less one:
+  if  ((double)i == rank)
+    i--;
+
+  if  (rank <= 0)
+    i	= 0;
+
+  if  (i >= numTimed)
+    i	= numTimed - 1;
+
+  return(latencyNsArray[i]);
+}
+
+
+//  PURPOSE:  To read "wordIndex wordCount" pairs from 'inputPtr', to stream
+//	them as pipelined requests over 'numConnections' concurrent
+//	connections to the server named 'url' at port 'port', each with every
+//	'numConnections'-th request, and to print each reply as it arrives,
+//	with how long it took from when its request was sent.  A line that is
+//	not a pair is reported on stderr and skipped.  Then prints the number
+//	of replies and errors and the latencies over all connections.
+//	Returns 'EXIT_SUCCESS' if every line was a request and every request
+//	got an 'STATUS_OK' reply, or 'EXIT_FAILURE' otherwise.
+int		communicateBatch(const char*	url,
+				 int		port,
+				 int		numConnections,
+				 FILE*		inputPtr
+				)
+{
+  //  I.  Application validity check:
+
+  //  II.  Do batch:
+  //  II.A.  Read requests:
+  struct Batch	batch;
+  uint32_t	capacity	= 0;
+  int		wordIndex;
+  int		wordCount;
+  char*		lineCPtr	= NULL;
+  size_t	lineSize	= 0;
+  uint32_t	lineNum		= 0;
+  uint32_t	numSkipped	= 0;
+
+  memset(&batch,'\0',sizeof(batch));
+
+  while  (getline(&lineCPtr,&lineSize,inputPtr) >= 0)
+  {
+    char	extra;
+    int		numRead	= sscanf(lineCPtr,"%d %d %c",&wordIndex,&wordCount,&extra);
+
+    lineNum++;
+
+    //  Blank lines are allowed, but any other line is a request:
+    if  (numRead != 2)
+    {
+      if  (strspn(lineCPtr," \t\r\n") < strlen(lineCPtr))
+      {
+	fprintf(stderr,"Line %u is not \"wordIndex wordCount\", skipped: %s",
+		lineNum,lineCPtr
+	       );
+	numSkipped++;
+      }
+
+      continue;
+    }
+
+    if  (batch.numRequests == capacity)
+    {
+      capacity		= (capacity == 0) ? 1024 : 2*capacity;
+      batch.requestArray	= (struct Request*)
+				  realloc(batch.requestArray,capacity*sizeof(struct Request));
+
+      if  (batch.requestArray == NULL)
+      {
+	fprintf(stderr,"Out of memory\n");
+	exit(EXIT_FAILURE);
+      }
+    }
+
+    struct Request*	requestPtr	= &batch.requestArray[batch.numRequests];
+
+    memset(requestPtr,'\0',sizeof(*requestPtr));
+    requestPtr->version		= PROTOCOL_V2;
+    requestPtr->opcode		= OPCODE_HISTOGRAM;
+    requestPtr->requestId	= batch.numRequests++;
+    requestPtr->wordIndex	= wordIndex;
+    requestPtr->wordCount	= wordCount;
+  }
+
+  free(lineCPtr);
+
+  //  II.B.  Connect (no more connections than requests, but at least one):
+  if  ((uint32_t)numConnections > batch.numRequests)
+    numConnections	= (batch.numRequests == 0) ? 1 : batch.numRequests;
+
+  struct Connection*	connectionArray	= (struct Connection*)
+					  calloc(numConnections,sizeof(struct Connection));
+
+  batch.numConnections	= numConnections;
+  batch.sentNsArray	= (uint64_t*)calloc(batch.numRequests+1,sizeof(uint64_t));
+  batch.latencyNsArray	= (uint64_t*)malloc((batch.numRequests+1)*sizeof(uint64_t));
+
+  if  ( (connectionArray == NULL)  ||  (batch.sentNsArray == NULL)  ||
+	(batch.latencyNsArray == NULL)
+      )
+  {
+    fprintf(stderr,"Out of memory\n");
+    exit(EXIT_FAILURE);
   }
 
+  for  (uint32_t i = 0;  i < batch.numRequests;  i++)
+    batch.latencyNsArray[i]	= NO_LATENCY;
+
+  pthread_mutex_init(&batch.outputLock,NULL);
+
+  for  (int i = 0;  i < numConnections;  i++)
+  {
+    connectionArray[i].batchPtr	= &batch;
+    connectionArray[i].first	= i;
+    connectionArray[i].numRequests
+		= (batch.numRequests - i + numConnections - 1) / numConnections;
+    connectionArray[i].socketFd	= attemptToConnectToServer(url,port);
+
+    if  (connectionArray[i].socketFd < 0)
+      exit(EXIT_FAILURE);
+  }
+
+  //  II.C.  Send each connection's requests from a thread of its own while
+  //	   another reads its replies, so neither side waits on a full socket
+  //	   buffer:
+  uint64_t	startNs		= getNowNs();
+
+  for  (int i = 0;  i < numConnections;  i++)
+  {
+    pthread_create(&connectionArray[i].senderId,NULL,sendBatch,&connectionArray[i]);
+    pthread_create(&connectionArray[i].receiverId,NULL,receiveBatch,&connectionArray[i]);
+  }
+
+  uint32_t	numReplies	= 0;
+  uint32_t	numFailed	= 0;
+
+  for  (int i = 0;  i < numConnections;  i++)
+  {
+    pthread_join(connectionArray[i].receiverId,NULL);
+    pthread_join(connectionArray[i].senderId,NULL);
+    close(connectionArray[i].socketFd);
+    numReplies	+= connectionArray[i].numReplies;
+    numFailed	+= connectionArray[i].numFailed;
+  }
+
+  double	secs		= (getNowNs() - startNs) / 1e9;
+
+  //  II.D.  Sum up the latencies of the requests that got a reply:
+  uint32_t	numTimed	= 0;
+
+  for  (uint32_t i = 0;  i < batch.numRequests;  i++)
+    if  (batch.latencyNsArray[i] != NO_LATENCY)
+      batch.latencyNsArray[numTimed++]	= batch.latencyNsArray[i];
+
+  qsort(batch.latencyNsArray,numTimed,sizeof(uint64_t),compareLatency);
+
   //  III.  Finished:
+  fprintf(stderr,"%u requests, %u replies, %u errors, %u lines skipped\n",
+	  batch.numRequests,numReplies,numFailed,numSkipped
+	 );
+
+  if  (numTimed > 0)
+    fprintf(stderr,
+	    "%d connections, %.1f requests/sec, latency p50 %.3f ms, "
+	    "p99 %.3f ms, max %.3f ms\n",
+	    numConnections,
+	    (secs > 0) ? numReplies / secs : 0.0,
+	    getPercentileNs(batch.latencyNsArray,numTimed,0.5) / 1e6,
+	    getPercentileNs(batch.latencyNsArray,numTimed,0.99) / 1e6,
+	    getPercentileNs(batch.latencyNsArray,numTimed,1.0) / 1e6
+	   );
+
+  pthread_mutex_destroy(&batch.outputLock);
+  free(batch.latencyNsArray);
+  free(batch.sentNsArray);
+  free(connectionArray);
+  free(batch.requestArray);
+
+  return( ( (numReplies == batch.numRequests)  &&  (numFailed == 0)  &&
+	    (numSkipped == 0)
+	  )
+	  ? EXIT_SUCCESS
+	  : EXIT_FAILURE
+	);
 }
 
 
-//  PURPOSE:  To do the work of the client.  Ignores command line parameters.
-//	Returns 'EXIT_SUCCESS' to OS on success or 'EXIT_FAILURE' otherwise.
-int	main	()
+//  PURPOSE:  To do the work of the client.  The server is named by
+//	"--host=host" and "--port=port", or by the first two of the other
+//	command line parameters, and is asked for if not given.  With no
+//	mode, sends it one request for "--count=wordCount" words from
+//	"--index=wordIndex", asking for whichever of these is not given.  With
+//	"--top=K" asks for only its K most frequent words (approximately, if
+//	with "--approximate"), or with "--stream[=words]" streams its counts
+//	as they change.  With "--batch host port [file]" in 'argc' and
+//	'argv[]', sends every "wordIndex wordCount" pair in 'file' (or stdin),
+//	spread over "--connections=K" connections (default 1).  With "--stats
+//	host port", prints the counters of the server.  Returns
+//	'EXIT_SUCCESS' to OS on success or 'EXIT_FAILURE' otherwise.
+int	main	(int	argc,
+		 char*	argv[]
+		)
 {
+  static struct option	optionArray[]	=
+  {
+    {"batch",	no_argument,	NULL,	'b'},
+    {"stats",	no_argument,	NULL,	's'},
+    {"stream",	optional_argument,	NULL,	'm'},
+    {"top",	required_argument,	NULL,	't'},
+    {"approximate",	no_argument,	NULL,	'a'},
+    {"host",	required_argument,	NULL,	'h'},
+    {"port",	required_argument,	NULL,	'p'},
+    {"index",	required_argument,	NULL,	'i'},
+    {"count",	required_argument,	NULL,	'c'},
+    {"connections",	required_argument,	NULL,	'k'},
+    {NULL,	0,		NULL,	0}
+  };
+  int		option;
+  int		mode		= 0;
+  struct Request	request;
   char		url[BUFFER_LEN];
-  int		port;
+  int		port		= 0;
+  int		numConnections	= 0;
   int		socketFd;
+  int		status	= EXIT_SUCCESS;
+
+  memset(&request,'\0',sizeof(request));
+  request.version	= PROTOCOL_V2;
+  request.opcode	= OPCODE_HISTOGRAM;
+  request.wordIndex	= -1;
+  url[0]		= '\0';
+
+  //  'mode' is '0' for one request, or the option letter.  The other
+  //  options shape that request, or name the server:
+  while  ( (option = getopt_long(argc,argv,"",optionArray,NULL)) != -1 )
+    if  (option == 'm')
+    {
+      request.flags	|= REQUEST_FLAG_STREAM;
+      request.argument	= (optarg == NULL) ? 0 : strtoul(optarg,NULL,0);
+    }
+    else
+    if  (option == 't')
+    {
+      request.opcode	= OPCODE_TOP;
+      request.argument	= strtoul(optarg,NULL,0);
+    }
+    else
+    if  (option == 'a')
+      request.flags	|= REQUEST_FLAG_APPROXIMATE;
+    else
+    if  (option == 'h')
+    {
+      strncpy(url,optarg,BUFFER_LEN-1);
+      url[BUFFER_LEN-1]	= '\0';
+    }
+    else
+    if  (option == 'p')
+      port		= strtol(optarg,NULL,0);
+    else
+    if  (option == 'i')
+      request.wordIndex	= strtol(optarg,NULL,0);
+    else
+    if  (option == 'c')
+      request.wordCount	= strtol(optarg,NULL,0);
+    else
+    if  (option == 'k')
+    {
+      numConnections	= strtol(optarg,NULL,0);
+
+      if  (numConnections < 1)
+	numConnections	= -1;
+    }
+    else
+      mode	= (mode == 0  &&  option != '?') ? option : -1;
+
+  //  The first two other parameters name the server, unless options did:
+  if  ( (url[0] == '\0')  &&  (port == 0)  &&  (argc - optind >= 2) )
+  {
+    strncpy(url,argv[optind],BUFFER_LEN-1);
+    url[BUFFER_LEN-1]	= '\0';
+    port		= strtol(argv[optind+1],NULL,0);
+    optind		+= 2;
+  }
+
+  if  ( (mode < 0)							||
+	( (mode != 0)  &&
+	  ( (request.opcode != OPCODE_HISTOGRAM)  ||  (request.flags != 0)  ||
+	    (request.wordIndex >= 0)  ||  (request.wordCount != 0)  ||
+	    (port <= 0)
+	  )
+	)								||
+	( (numConnections != 0)  &&
+	  ( (mode != 'b')  ||  (numConnections < 1) )
+	)								||
+	(argc - optind > ((mode == 'b') ? 1 : 0))			||
+	( (request.flags & REQUEST_FLAG_STREAM)  &&
+	  (request.opcode != OPCODE_HISTOGRAM)
+	)								||
+	( (request.flags & REQUEST_FLAG_APPROXIMATE)  &&
+	  (request.opcode != OPCODE_TOP)
+	)
+      )
+  {
+    fprintf(stderr,
+	    "Usage:\twordHistogramClient [--host=host] [--port=port] [--index=wordIndex] [--count=wordCount]\n"
+	    "\t\t[--stream[=words] | --top=K [--approximate]]\n"
+	    "\twordHistogramClient --batch [--connections=K] host port [file]\n"
+	    "\twordHistogramClient --stats host port\n"
+	    "(\"host port\" may also be given as --host=host --port=port)\n"
+	   );
+    exit(EXIT_FAILURE);
+  }
+
+  //  A port given without a host is on the default host:
+  if  ( (url[0] == '\0')  &&  (port > 0) )
+    strncpy(url,DEFAULT_HOSTNAME,BUFFER_LEN);
+
+  if  (mode == 0)
+    obtainUrlAndPort(BUFFER_LEN,url,&port);
+
+  if  (mode == 'b')
+  {
+    FILE*	inputPtr	= (argc - optind > 0)
+				  ? fopen(argv[optind],"r")
+				  : stdin;
+
+    if  (inputPtr == NULL)
+    {
+      fprintf(stderr,"Cannot open %s\n",argv[optind]);
+      return(EXIT_FAILURE);
+    }
+
+    status	= communicateBatch(url,port,(numConnections == 0) ? 1 : numConnections,inputPtr);
+
+    if  (inputPtr != stdin)
+      fclose(inputPtr);
+
+    return(status);
+  }
 
-  obtainUrlAndPort(BUFFER_LEN,url,&port);
   socketFd	= attemptToConnectToServer(url,port);
 
   if  (socketFd < 0)
     exit(EXIT_FAILURE);
 
-  communicateWithServer(socketFd);
+  if  (mode == 0)
+    communicateWithServer(socketFd,&request);
+  else
+    status	= communicateStats(socketFd);
+
   close(socketFd);
-  return(EXIT_SUCCESS);
+  return(status);
 }
@@ -3,9 +3,9 @@
  *---		wordHistogramServer.c					---*
  *---									---*
  *---	    This file defines a C program that gets file-sys commands	---*
- *---	from client via a socket, executes those commands in their own	---*
- *---	threads, and returns the corresponding output back to the	---*
- *---	client.								---*
+ *---	from client via a socket, executes those commands in a pool of	---*
+ *---	worker threads, and returns the corresponding output back to	---*
+ *---	the client.							---*
  *---									---*
  *---	----	----	----	----	----	----	----	----	---*
  *---									---*
@@ -13,162 +13,1309 @@
  *---									---*
  *-------------------------------------------------------------------------*/
 
-//	Compile with:
-//	$ gcc wordHistogramServer.c callHistogrammer.c -o wordHistogramServer -lpthread -g
+//	Compile with (after making libhistogram.a, see histogramEngine.cpp):
+//	$ gcc wordHistogramServer.c callHistogrammer.c protocol.c resultCache.c serverMetrics.c libhistogram.a -o wordHistogramServer -lpthread -lstdc++ -g
 
 //---		Header file inclusion					---//
 
+#define		_GNU_SOURCE		// For accept4()
 #include	"header.h"
+#include	"protocol.h"
+#include	"resultCache.h"
+#include	"serverMetrics.h"
 #include	<pthread.h>	// For pthread_create()
+#include	<getopt.h>	// For getopt_long()
+#include	<stdint.h>	// For uint64_t
+#include	<sys/epoll.h>	// For epoll_create1(), epoll_ctl(), epoll_wait()
+#include	<sys/eventfd.h>	// For eventfd()
+#include	<sys/uio.h>	// For struct iovec
+#include	<stddef.h>	// For ptrdiff_t
+#include	<sys/resource.h>	// For setrlimit()
+#include	<limits.h>	// For INT_MAX
+#include	<sys/un.h>	// For sockaddr_un
 
 
 //---		Definition of constants:				---//
 const int	ERROR_FD		= -1;
 
+//  PURPOSE:  To tell the number of seconds between checks of whether the
+//	corpus changed.
+const int	CORPUS_CHECK_SECS	= 1;
+
+//  PURPOSE:  To tell the most events one 'epoll_wait()' returns.
+#define		EPOLL_MAX_EVENTS	256
+
+//  PURPOSE:  To tell the most requests of one connection that may be under
+//	way at once.  The server stops reading a connection that has this
+//	many.
+#define		PIPELINE_MAX_DEPTH	64
+
+//  PURPOSE:  To tell the most replies sent with one 'sendmsg()'.
+#define		SEND_MAX_REPLIES	16
+
+//  PURPOSE:  To tell the most delta replies of one connection that may
+//	wait to be sent.  Past that, a streaming request's changes are kept
+//	for its next delta rather than queued in one more.
+#define		STREAM_MAX_DELTAS	4
+
+//  PURPOSE:  To tell the default number of megabytes of replies cached.
+#define		DEFAULT_CACHE_MEGABYTES	64
+
+//  PURPOSE:  To tell the default of the most requests that may wait for a
+//	worker.
+#define		DEFAULT_QUEUE_DEPTH	1024
+
+//  PURPOSE:  To tell the most bytes of the text form of the counters.
+#define		STATS_TEXT_LEN		8192
+
 
 //---		Declarations:						---//
 
-//  PURPOSE:  To make a process that histograms words starting at 'wordIndex'
-//  	and count 'wordCount' words, get the word histogram from that process
-//	and send it back to the client via socket file-descriptor 'toClientFd'.
-//	No return value.
+//  PURPOSE:  To return a new histogrammer whose process is started on the
+//	corpus 'corpusPathCPtr' as it is at version 'version', or 'NULL' if
+//	there is no memory.
+extern
+struct Histogrammer*
+		newHistogrammer	(const char*	corpusPathCPtr,
+				 uint64_t	version
+				);
+
+//  PURPOSE:  To have the process of '*histogrammerPtr' histogram 'wordCount'
+//  	words starting at 'wordIndex', and get the word histogram (or only
+//	its 'topK' most frequent words, if 'topK' is not '0') from it, adding
+//	it to '*replyPtr'.  The process is (re)started first if it is not
+//	running or was started on a version of the file other than
+//	'version'.  Returns the status of the reply.
+extern
+int		callHistogrammer(struct Histogrammer*	histogrammerPtr,
+				 uint64_t		version,
+				 int			wordIndex,
+				 int			wordCount,
+				 int			topK,
+				 struct Reply*		replyPtr
+				);
+
+//  PURPOSE:  To load the file (or the directory or list of files)
+//	'filenameCPtr' as the corpus that 'histogramInProcess()' histograms,
+//	if no corpus is loaded yet or the files changed since it was.  Returns
+//	'1' if the current corpus is up to date or '0' if the files could not
+//	be loaded.
+extern
+int		loadCorpus	(const char*	filenameCPtr
+				);
+
+//  PURPOSE:  To return a number that changes whenever a file is added to or
+//	removed from the files 'pathCPtr' names, or one of them is replaced or
+//	changed, or '0' if they cannot be listed.
+extern
+uint64_t	getCorpusStamp	(const char*	pathCPtr
+				);
+
+//  PURPOSE:  To return the version of the corpus 'loadCorpus()' loaded,
+//	which changes whenever it loads a new one.  No parameters.
+extern
+uint64_t	getCorpusVersion();
+
+//  PURPOSE:  To histogram, in this process, the 'wordCount' words starting
+//	at word 'wordIndex' of the corpus 'loadCorpus()' loaded, adding the
+//	histogram to '*replyPtr'.  Sets '*versionPtr' to the version of the
+//	corpus histogrammed.  Returns the status of the reply.
 extern
-void		callHistogrammer(int		toClientFd,
-				 int		wordIndex,
-				 int		wordCount
+int		histogramInProcess
+				(int		wordIndex,
+				 int		wordCount,
+				 struct Reply*	replyPtr,
+				 uint64_t*	versionPtr
 				);
 
+//  PURPOSE:  To add to '*replyPtr', in this process, the 'k' most frequent
+//	of the 'wordCount' words starting at word 'wordIndex' of the corpus
+//	'loadCorpus()' loaded, counted approximately in a sketch if
+//	'isApproximate' is not '0'.  Sets '*versionPtr' to the version of the
+//	corpus.  Returns the status of the reply.
+extern
+int		topInProcess	(int		wordIndex,
+				 int		wordCount,
+				 int		k,
+				 int		isApproximate,
+				 struct Reply*	replyPtr,
+				 uint64_t*	versionPtr
+				);
+
+//  PURPOSE:  To start histogramming, in this process, the 'wordCount' words
+//	starting at word 'wordIndex' of the corpus 'loadCorpus()' loaded,
+//	noting which counts change if 'shouldTrackDirty' is not '0'.  Sets
+//	'*versionPtr' to the version of the corpus.  Returns the task, or
+//	'NULL' after setting '*statusPtr' to the status of the reply.
+extern
+struct HistogramTask*
+		beginHistogram	(int		wordIndex,
+				 int		wordCount,
+				 int		shouldTrackDirty,
+				 uint64_t*	versionPtr,
+				 int*		statusPtr
+				);
+
+//  PURPOSE:  To count about 'numWords' more words of '*taskPtr', adding to
+//	'*deltaPtr' the words whose counts changed since the last call, or
+//	leaving them to the next call if 'deltaPtr' is 'NULL'.  Returns the
+//	number of words left to count.
+extern
+int		continueHistogram
+				(struct HistogramTask*	taskPtr,
+				 int			numWords,
+				 struct Reply*		deltaPtr
+				);
+
+//  PURPOSE:  To count the words left of '*taskPtr', add its whole histogram
+//	to '*replyPtr' and free it.  Returns the status of the reply.
+extern
+int		endHistogram	(struct HistogramTask*	taskPtr,
+				 struct Reply*		replyPtr
+				);
+
+//  PURPOSE:  To free '*taskPtr' without counting the words left of it.  No
+//	return value.
+extern
+void		cancelHistogram	(struct HistogramTask*	taskPtr
+				);
+
+
+//---		Definition of types:					---//
+
+struct		Connection;
+
+//  PURPOSE:  To hold one request and, once a worker histogrammed it, its
+//	reply.  Only the worker that histograms it touches it until it is
+//	handed back to the event loop.  A streaming request also has jobs
+//	made by the worker, whose 'isDelta' is non-zero, one per delta reply
+//	sent before its own.  'readNs' tells when the event loop read the
+//	request and 'doneNs' when its reply was finished, for the metrics.
+struct		Job
+{
+  struct Connection*	connPtr;
+  struct Request	request;
+  struct Reply		reply;
+  int			isDelta;
+  uint64_t		readNs;
+  uint64_t		doneNs;
+  struct Job*		nextPtr;
+};
+
+
+//  PURPOSE:  To hold a first-in first-out list of jobs.
+struct		JobQueue
+{
+  struct Job*		headPtr;
+  struct Job*		tailPtr;
+};
+
+
+//  PURPOSE:  To hold the state of one client connection.  Only the event
+//	loop touches it, but for 'numDeltas', the number of its delta jobs
+//	made and not yet freed, which workers also change, atomically.  A
+//	version 2 connection stays open for as many (possibly pipelined)
+//	requests as the client sends; a version 1 connection is closed after
+//	its one reply.  'acceptNs' tells when it was accepted, and
+//	'hasReplied' is non-zero once the first byte of a reply was sent.
+struct		Connection
+{
+  int			fd;
+  int			clientNum;
+  uint32_t		watchedEvents;
+  char			inBuffer[PROTOCOL_MAX_REQUEST_LEN * PIPELINE_MAX_DEPTH];
+  size_t		inLen;
+  int			numJobs;
+  int			isReadDone;
+  int			isBroken;
+  struct JobQueue	outQueue;
+  size_t		headSent;
+  int			numDeltas;
+  uint64_t		acceptNs;
+  int			hasReplied;
+};
+
 
 //---		Definition of global vars:				---//
 
 //  PURPOSE:  To be non-zero for as long as this program should run, or '0'
 //	otherwise.
 
+//  PURPOSE:  To be non-zero if requests should be histogrammed by
+//	histogrammer processes, one long-lived one per worker (as
+//	'callHistogrammer()' does), or '0' if they should be histogrammed in
+//	this process.
+int		shouldFork	= 0;
+
+//  PURPOSE:  To tell the file whose words are histogrammed, or the directory
+//	or "@listFile" list of files whose words, one file after the other,
+//	are.
+const char*	corpusPathCPtr	= FILENAME;
+
+//  PURPOSE:  To be non-zero if each request a worker takes should be
+//	printed, or '0' otherwise.  Printing takes the lock of 'stdout', so
+//	it is off by default; the metrics tell the same without a lock.
+int		isVerbose	= 0;
+
+//  PURPOSE:  To tell the number of worker threads that histogram requests.
+//	'0' means one per online CPU.
+int		numWorkers	= 0;
+
+//  PURPOSE:  To tell the length of the OS queue of not-yet-accepted
+//	connections.
+int		listenBacklog	= SOMAXCONN;
+
+//  PURPOSE:  To tell the most requests that may wait for a worker.  Any more
+//	are answered at once with 'STATUS_BUSY'.  '0' means no limit.
+int		queueDepth	= DEFAULT_QUEUE_DEPTH;
+
+//  PURPOSE:  To hold the path of the local socket on which the counters are
+//	given in text, or 'NULL' if there is none.
+const char*	statsSocketPath	= NULL;
+
+//  PURPOSE:  To tell the most bytes of replies cached, or '0' if replies
+//	should not be cached.
+size_t		cacheBytes	= (size_t)DEFAULT_CACHE_MEGABYTES << 20;
+
+//  PURPOSE:  To hold the epoll instance of the event loop.
+int		epollFd		= ERROR_FD;
+
+//  PURPOSE:  To hold the eventfd with which workers wake the event loop
+//	when they finish a request.
+int		wakeFd		= ERROR_FD;
+
+//  PURPOSE:  To hold the jobs that wait for a worker.
+struct JobQueue	jobQueue;
+
+//  PURPOSE:  To tell the number of jobs in 'jobQueue'.
+int		numQueued	= 0;
+
+//  PURPOSE:  To guard 'jobQueue' and 'numQueued'.
+pthread_mutex_t	jobLock		= PTHREAD_MUTEX_INITIALIZER;
+
+//  PURPOSE:  To tell idle workers that 'jobQueue' is not empty.
+pthread_cond_t	jobCond		= PTHREAD_COND_INITIALIZER;
+
+//  PURPOSE:  To hold the jobs whose replies are ready to be sent.
+struct JobQueue	doneQueue;
+
+//  PURPOSE:  To guard 'doneQueue'.
+pthread_mutex_t	doneLock	= PTHREAD_MUTEX_INITIALIZER;
+
+//  PURPOSE:  To tell the number of requests answered with 'STATUS_BUSY'.
+//	Only the event loop touches it.
+uint64_t	numBusyReplies	= 0;
+
 
 //---		Definition of functions:				---//
 
-//  PURPOSE:  To cast 'vPtr' to the pointer type coming from 'doServer()'
-//	that points to two integers.  Then, to use those two integers,
-//	one as a file descriptor, the other as a thread number, to fulfill
-//	requests coming from the client over the file descriptor socket.
-//	Returns 'NULL'.
-void*		handleClient	(void*		vPtr
+//  PURPOSE:  To add 'jobPtr' to the end of '*queuePtr'.  No return value.
+void		enqueue		(struct JobQueue*	queuePtr,
+				 struct Job*		jobPtr
 				)
 {
-  //  I.  Application validity check:
+  jobPtr->nextPtr	= NULL;
 
-  //  II.  Handle client:
-  //  II.A.  Get file descriptor:
-  int*	   intArray	= (int *) vPtr;
-  ///The thread id and the file descriptor are passed, but they come in as a void* pointer.
-///Use another pointer to cast back to int*
-
-  int 	   fd		= intArray[0];
-  int	   threadNum	= intArray[1];
-
-  free(intArray);
-  
-  //  RELEASE THE MEMORY
-  printf("Thread %d starting.\n",threadNum);
-
-  //  II.B.  Read command:
-  char	buffer[2*sizeof(int)];
-  int	wordIndex;
-  int	wordCount;
-
-  //  GET 2 ints FROM CLIENT
-  //  CHANGE THEIR ENDIAN
-  read(fd, buffer, sizeof(buffer));
-  wordIndex = ntohl(*((int *) buffer));
-  wordCount = ntohl(*(((int *) buffer) + 1));
-  
-  printf("Thread %d received: %d %d\n",threadNum,wordIndex,wordCount);
-  callHistogrammer(fd,wordIndex,wordCount);
+  if  (queuePtr->tailPtr == NULL)
+    queuePtr->headPtr		= jobPtr;
+  else
+    queuePtr->tailPtr->nextPtr	= jobPtr;
+
+  queuePtr->tailPtr	= jobPtr;
+}
+
+
+//  PURPOSE:  To remove and return the first job of '*queuePtr', or 'NULL' if
+//	it is empty.
+struct Job*	dequeue		(struct JobQueue*	queuePtr
+				)
+{
+  struct Job*	jobPtr	= queuePtr->headPtr;
+
+  if  (jobPtr != NULL)
+  {
+    queuePtr->headPtr	= jobPtr->nextPtr;
+
+    if  (queuePtr->headPtr == NULL)
+      queuePtr->tailPtr	= NULL;
+  }
+
+  return(jobPtr);
+}
+
+
+//  PURPOSE:  To add to the reply 'vPtr' points to the entry telling that the
+//	counter named 'nameCPtr' has value 'value', or 'INT_MAX' if it is
+//	more.  No return value.
+void		addStatsEntry	(void*		vPtr,
+				 const char*	nameCPtr,
+				 uint64_t	value
+				)
+{
+  addReplyEntry((struct Reply*)vPtr,
+		(value > INT_MAX) ? INT_MAX : (int)value,
+		nameCPtr,strlen(nameCPtr)
+	       );
+}
+
+
+//  PURPOSE:  To hold the text form of the counters as it is made.
+struct		StatsText
+{
+  char		buffer[STATS_TEXT_LEN];
+  size_t	len;
+};
+
+
+//  PURPOSE:  To append to the 'struct StatsText' 'vPtr' points to the line
+//	telling that the counter named 'nameCPtr' has value 'value'.  No
+//	return value.
+void		addStatsLine	(void*		vPtr,
+				 const char*	nameCPtr,
+				 uint64_t	value
+				)
+{
+  struct StatsText*	textPtr	= (struct StatsText*)vPtr;
+  int			len	= snprintf(textPtr->buffer + textPtr->len,
+					   sizeof(textPtr->buffer) - textPtr->len,
+					   "%s %lu\n",nameCPtr,(unsigned long)value
+					  );
+
+  if  ( (len > 0)  &&  (textPtr->len + len < sizeof(textPtr->buffer)) )
+    textPtr->len	+= len;
+}
+
+
+//  PURPOSE:  To give 'sink' (with 'sinkPtr') every counter of the server:
+//	those of the queue, the cache, and then its metrics.  Only called by
+//	the event loop.  No return value.
+void		reportStats	(MetricSink	sink,
+				 void*		sinkPtr
+				)
+{
+  struct CacheStats	cacheStats;
+  int			queued;
+
+  pthread_mutex_lock(&jobLock);
+  queued	= numQueued;
+  pthread_mutex_unlock(&jobLock);
+
+  (*sink)(sinkPtr,"workers",		numWorkers);
+  (*sink)(sinkPtr,"queueDepth",		queued);
+  (*sink)(sinkPtr,"queueLimit",		queueDepth);
+  (*sink)(sinkPtr,"busyReplies",	numBusyReplies);
+
+  getCacheStats(&cacheStats);
+  (*sink)(sinkPtr,"cacheHits",		cacheStats.numHits);
+  (*sink)(sinkPtr,"cacheMisses",	cacheStats.numMisses);
+  (*sink)(sinkPtr,"cacheInserts",	cacheStats.numInserts);
+  (*sink)(sinkPtr,"cacheEvictions",	cacheStats.numEvictions);
+  (*sink)(sinkPtr,"cacheInvalidations",	cacheStats.numInvalidations);
+  (*sink)(sinkPtr,"cacheEntries",	cacheStats.numEntries);
+  (*sink)(sinkPtr,"cacheKilobytes",	cacheStats.numBytes >> 10);
+
+  reportMetrics(sink,sinkPtr);
+}
+
+
+//  PURPOSE:  To return '1' if '*requestPtr' asks for words to be
+//	histogrammed (and so its reply may be cached), or '0' otherwise.
+int		isHistogramRequest
+				(const struct Request*	requestPtr
+				)
+{
+  return( (requestPtr->opcode == OPCODE_HISTOGRAM)  ||
+	  (requestPtr->opcode == OPCODE_TOP)
+	);
+}
+
+
+//  PURPOSE:  To hand job 'jobPtr', with its reply finished, back to the event
+//	loop, and to wake the event loop.  No return value.
+void		handBack	(struct Job*	jobPtr
+				)
+{
+  uint64_t	one	= 1;
+
+  jobPtr->doneNs	= getNowNs();
+
+  pthread_mutex_lock(&doneLock);
+  enqueue(&doneQueue,jobPtr);
+  pthread_mutex_unlock(&doneLock);
+
+  write(wakeFd,&one,sizeof(one));
+}
+
+
+//  PURPOSE:  To histogram the request of 'jobPtr' in this process, handing
+//	back a delta reply of the counts that changed every 'argument' words
+//	(but no fewer than 'PROTOCOL_MIN_STREAM_WORDS') before adding the
+//	whole histogram to its own reply.  While 'STREAM_MAX_DELTAS' deltas
+//	of its connection wait to be sent, the changes are left to the next
+//	delta instead.  Sets '*versionPtr' to the version of the corpus.
+//	Returns the status of the reply.
+int		streamHistogram	(struct Job*	jobPtr,
+				 uint64_t*	versionPtr
+				)
+{
+  struct Request*	requestPtr	= &jobPtr->request;
+  struct Connection*	connPtr		= jobPtr->connPtr;
+  int			wordsPerDelta	= (requestPtr->argument == 0)
+					  ? PROTOCOL_DEFAULT_STREAM_WORDS
+					  : (requestPtr->argument < PROTOCOL_MIN_STREAM_WORDS)
+					  ? PROTOCOL_MIN_STREAM_WORDS
+					  : (requestPtr->argument > INT_MAX)
+					  ? INT_MAX
+					  : (int)requestPtr->argument;
+  int			status;
+  struct HistogramTask*	taskPtr		= beginHistogram(requestPtr->wordIndex,
+							 requestPtr->wordCount,
+							 1,versionPtr,&status
+							);
+
+  if  (taskPtr == NULL)
+    return(status);
+
+  //  The last words are counted into the whole histogram, not a delta:
+  for  (int numLeft = requestPtr->wordCount;  numLeft > wordsPerDelta;  )
+  {
+    //  A client that reads slower than the worker counts gets fewer,
+    //  bigger deltas rather than an ever longer queue of them:
+    if  (__atomic_load_n(&connPtr->numDeltas,__ATOMIC_ACQUIRE) >= STREAM_MAX_DELTAS)
+    {
+      numLeft	= continueHistogram(taskPtr,wordsPerDelta,NULL);
+      continue;
+    }
+
+    struct Job*	deltaPtr	= (struct Job*)calloc(1,sizeof(struct Job));
+
+    if  (deltaPtr == NULL)
+    {
+      cancelHistogram(taskPtr);
+      return(STATUS_ERROR);
+    }
+
+    deltaPtr->connPtr	= connPtr;
+    deltaPtr->request	= *requestPtr;
+    deltaPtr->isDelta	= 1;
+    beginReply(&deltaPtr->reply,requestPtr);
+    numLeft		= continueHistogram(taskPtr,wordsPerDelta,&deltaPtr->reply);
+    deltaPtr->reply.flags	= REPLY_FLAG_DELTA;
+    endReply(&deltaPtr->reply,STATUS_OK);
+    __atomic_add_fetch(&connPtr->numDeltas,1,__ATOMIC_ACQ_REL);
+    handBack(deltaPtr);
+  }
+
+  return(endHistogram(taskPtr,&jobPtr->reply));
+}
+
+
+//  PURPOSE:  To histogram the jobs from 'jobQueue' one after the other, to
+//	hand each one back to the event loop with its reply through
+//	'doneQueue', and to wake the event loop.  With '--fork', the worker
+//	starts its own histogrammer process first and keeps it, so no
+//	request waits for one to start.  'vPtr' tells the index of the slot
+//	of the worker's metrics.  Never returns.
+void*		histogramWorker	(void*		vPtr
+				)
+{
+  setThreadMetrics((int)(intptr_t)vPtr);
+
+  struct Histogrammer*	histogrammerPtr	= shouldFork
+					  ? newHistogrammer(corpusPathCPtr,getCacheVersion())
+					  : NULL;
+
+  while  (1)
+  {
+    struct Job*	jobPtr;
+
+    pthread_mutex_lock(&jobLock);
+
+    while  ( (jobPtr = dequeue(&jobQueue)) == NULL )
+      pthread_cond_wait(&jobCond,&jobLock);
+
+    numQueued--;
+    pthread_mutex_unlock(&jobLock);
+
+    struct Request*	requestPtr	= &jobPtr->request;
+    int			status;
+    uint64_t		version		= 0;
+    uint64_t		startNs		= getNowNs();
+
+    noteLatency(LATENCY_QUEUE_WAIT,startNs - jobPtr->readNs);
+
+    if  (isVerbose)
+      printf("Client %d received: %d %d\n",
+	     jobPtr->connPtr->clientNum,requestPtr->wordIndex,requestPtr->wordCount
+	    );
+
+    beginReply(&jobPtr->reply,requestPtr);
+
+    if  (!isHistogramRequest(requestPtr))
+      status	= STATUS_BAD_REQUEST;
+    else
+    if  ( (requestPtr->wordIndex < 0)  ||  (requestPtr->wordCount < 1)  ||
+	  ( (requestPtr->opcode == OPCODE_TOP)  &&
+	    ( (requestPtr->argument < 1)  ||  (requestPtr->argument > INT_MAX) )
+	  )
+	)
+      status	= STATUS_BAD_REQUEST;
+    else
+    if  (shouldFork)
+    {
+      //  The histogrammer reads the file as it is now (it is restarted if
+      //  the file changed), and its top words are exact even when
+      //  approximate ones would do:
+      version	= getCacheVersion();
+      status	= (histogrammerPtr == NULL)
+		  ? STATUS_ERROR
+		  : callHistogrammer(histogrammerPtr,version,
+				     requestPtr->wordIndex,requestPtr->wordCount,
+				     (requestPtr->opcode == OPCODE_TOP)
+				     ? (int)requestPtr->argument
+				     : 0,
+				     &jobPtr->reply
+				    );
+    }
+    else
+    if  (requestPtr->opcode == OPCODE_TOP)
+      status	= topInProcess(requestPtr->wordIndex,requestPtr->wordCount,
+			       (int)requestPtr->argument,
+			       (requestPtr->flags & REQUEST_FLAG_APPROXIMATE) != 0,
+			       &jobPtr->reply,&version
+			      );
+    else
+    if  (requestPtr->flags & REQUEST_FLAG_STREAM)
+      status	= streamHistogram(jobPtr,&version);
+    else
+      status	= histogramInProcess(requestPtr->wordIndex,requestPtr->wordCount,
+				     &jobPtr->reply,&version
+				    );
+
+    endReply(&jobPtr->reply,status);
+    noteLatency(LATENCY_COUNT,getNowNs() - startNs);
+
+    if  ( (status == STATUS_OK)  &&  isHistogramRequest(requestPtr) )
+    {
+      addCounter(COUNTER_WORDS,requestPtr->wordCount);
+      insertCache(requestPtr,version,&jobPtr->reply);
+    }
+
+    noteLatency(LATENCY_SERVICE,getNowNs() - startNs);
+    handBack(jobPtr);
+  }
+
+  return(NULL);
+}
+
+
+//  PURPOSE:  To return a number that changes whenever a file is added to or
+//	removed from the files 'pathCPtr' names, or one of them is replaced
+//	or changed, judging by their names, devices, inodes, sizes and
+//	modification times.  Only called by one thread at a time.
+uint64_t	getFileVersion	(const char*	pathCPtr
+				)
+{
+  static uint64_t	lastStamp;
+  static uint64_t	version		= 0;
+  uint64_t		stamp		= getCorpusStamp(pathCPtr);
+
+  if  ( (version == 0)  ||  (stamp != lastStamp) )
+  {
+    lastStamp	= stamp;
+    version++;
+  }
+
+  return(version);
+}
+
+
+//  PURPOSE:  To note the current version of the corpus, for the cache.  When
+//	histogramming in this process, this is the version of the loaded
+//	snapshot, and otherwise that of the files of 'corpusPathCPtr' on
+//	disk.  No return value.
+void		noteCorpusVersion
+				()
+{
+  setCacheVersion( shouldFork ? getFileVersion(corpusPathCPtr) : getCorpusVersion() );
+}
+
+
+//  PURPOSE:  To reload the corpus whenever its files change on disk, and
+//	to empty the cache of replies histogrammed from the old one.
+//	Requests that already hold the old corpus keep using it.  'vPtr' is
+//	ignored.  Never returns.
+void*		watchCorpus	(void*		vPtr
+				)
+{
+  while  (1)
+  {
+    sleep(CORPUS_CHECK_SECS);
+
+    if  (!shouldFork  &&  !loadCorpus(corpusPathCPtr))
+      fprintf(stderr,"Could not reload %s, keeping the old one.\n",corpusPathCPtr);
+
+    noteCorpusVersion();
+  }
 
-  //  III.  Finished:
-  printf("Thread %d quitting.\n",threadNum);
-  //  SOMETHING HERE
   return(NULL);
 }
 
 
+//  PURPOSE:  To free job 'jobPtr', and to let the worker streaming to its
+//	connection make another delta if it is one.  No return value.
+void		freeJob		(struct Job*	jobPtr
+				)
+{
+  if  (jobPtr->isDelta)
+    __atomic_sub_fetch(&jobPtr->connPtr->numDeltas,1,__ATOMIC_ACQ_REL);
+
+  free(jobPtr->reply.bytes);
+  free(jobPtr);
+}
+
+
+//  PURPOSE:  To make the event loop wait for just the events 'connPtr' can
+//	handle now: more requests while it has room for them, and room to
+//	send while it has replies to send.  No return value.
+void		updateWatch	(struct Connection*	connPtr
+				)
+{
+  uint32_t	events	= 0;
+
+  if  ( !connPtr->isReadDone  &&  (connPtr->numJobs < PIPELINE_MAX_DEPTH) )
+    events	|= EPOLLIN;
+
+  if  (connPtr->outQueue.headPtr != NULL)
+    events	|= EPOLLOUT;
+
+  if  (events == connPtr->watchedEvents)
+    return;
+
+  struct epoll_event	event;
+
+  event.events		= events;
+  event.data.ptr	= connPtr;
+
+  if  (connPtr->watchedEvents == 0)
+    epoll_ctl(epollFd,EPOLL_CTL_ADD,connPtr->fd,&event);
+  else
+  if  (events == 0)
+    epoll_ctl(epollFd,EPOLL_CTL_DEL,connPtr->fd,NULL);
+  else
+    epoll_ctl(epollFd,EPOLL_CTL_MOD,connPtr->fd,&event);
+
+  connPtr->watchedEvents	= events;
+}
+
+
+//  PURPOSE:  To close 'connPtr' and free it, if it is finished: if the
+//	client is done sending, or the connection broke, and no job of it is
+//	left.  Otherwise, to update which of its events are watched.  Returns
+//	'1' if 'connPtr' is still open or '0' otherwise.
+int		closeIfFinished	(struct Connection*	connPtr
+				)
+{
+  if  ( (connPtr->isReadDone  ||  connPtr->isBroken)  &&  (connPtr->numJobs == 0) )
+  {
+    //  'close()' alone leaves the socket watched while any process still
+    //  shares it:
+    if  (connPtr->watchedEvents != 0)
+      epoll_ctl(epollFd,EPOLL_CTL_DEL,connPtr->fd,NULL);
+
+    close(connPtr->fd);
+    free(connPtr);
+    return(0);
+  }
+
+  if  (connPtr->isBroken)
+  {
+    //  Stop watching until the workers hand back its last jobs:
+    connPtr->isReadDone	= 1;
+
+    while  (connPtr->outQueue.headPtr != NULL)
+    {
+      freeJob(dequeue(&connPtr->outQueue));
+      connPtr->numJobs--;
+    }
+
+    if  (connPtr->numJobs == 0)
+      return(closeIfFinished(connPtr));
+  }
+
+  updateWatch(connPtr);
+  return(1);
+}
+
+
+//  PURPOSE:  To send as many of the finished replies of 'connPtr' as the
+//	socket takes without blocking, several at once.  No return value.
+void		sendReplies	(struct Connection*	connPtr
+				)
+{
+  while  (connPtr->outQueue.headPtr != NULL)
+  {
+    struct iovec	iovArray[SEND_MAX_REPLIES];
+    int			numIov		= 0;
+    struct Job*		jobPtr		= connPtr->outQueue.headPtr;
+    size_t		offset		= connPtr->headSent;
+
+    for  ( ;  (jobPtr != NULL)  &&  (numIov < SEND_MAX_REPLIES);  jobPtr = jobPtr->nextPtr)
+    {
+      iovArray[numIov].iov_base	= jobPtr->reply.bytes + offset;
+      iovArray[numIov].iov_len	= jobPtr->reply.len - offset;
+      numIov++;
+      offset			= 0;
+    }
+
+    struct msghdr	message;
+
+    memset(&message,'\0',sizeof(message));
+    message.msg_iov	= iovArray;
+    message.msg_iovlen	= numIov;
+
+    ssize_t		numSent	= sendmsg(connPtr->fd,&message,MSG_NOSIGNAL);
+
+    if  (numSent < 0)
+    {
+      if  (errno == EINTR)
+	continue;
+
+      if  ( (errno != EAGAIN)  &&  (errno != EWOULDBLOCK) )
+	connPtr->isBroken	= 1;
+
+      return;
+    }
+
+    uint64_t		nowNs	= getNowNs();
+
+    addCounter(COUNTER_BYTES_SENT,numSent);
+
+    //  Free the replies that were sent whole, noting when the first and the
+    //  last byte of each went:
+    while  (numSent > 0)
+    {
+      jobPtr		= connPtr->outQueue.headPtr;
+      size_t	left	= jobPtr->reply.len - connPtr->headSent;
+
+      if  (!connPtr->hasReplied)
+      {
+	noteLatency(LATENCY_FIRST_BYTE,nowNs - connPtr->acceptNs);
+	connPtr->hasReplied	= 1;
+      }
+
+      if  ( (connPtr->headSent == 0)  &&  !jobPtr->isDelta )
+	noteLatency(LATENCY_REPLY_FIRST_BYTE,nowNs - jobPtr->readNs);
+
+      if  ((size_t)numSent < left)
+      {
+	connPtr->headSent	+= numSent;
+	return;
+      }
+
+      if  (!jobPtr->isDelta)
+      {
+	noteLatency(LATENCY_SEND,nowNs - jobPtr->doneNs);
+	addCounter(COUNTER_REQUESTS,1);
+      }
+
+      numSent		-= left;
+      connPtr->headSent	= 0;
+      freeJob(dequeue(&connPtr->outQueue));
+      connPtr->numJobs--;
+    }
+  }
+}
+
+
+//  PURPOSE:  To read what the client of 'connPtr' sent, and to hand each
+//	whole request in it to the workers.  The first 4 bytes of a request
+//	tell its version, and so its length.  Marks 'connPtr' broken if there
+//	is no memory for a request.  No return value.
+void		readRequests	(struct Connection*	connPtr
+				)
+{
+  while  ( !connPtr->isReadDone  &&  (connPtr->numJobs < PIPELINE_MAX_DEPTH) )
+  {
+    ssize_t	numRead	= read(connPtr->fd,
+				       connPtr->inBuffer + connPtr->inLen,
+				       sizeof(connPtr->inBuffer) - connPtr->inLen
+				      );
+
+    if  (numRead < 0)
+    {
+      if  (errno == EINTR)
+	continue;
+
+      if  ( (errno != EAGAIN)  &&  (errno != EWOULDBLOCK) )
+	connPtr->isBroken	= 1;
+
+      return;
+    }
+
+    //  The client is done sending, but still gets the replies it asked for:
+    if  (numRead == 0)
+    {
+      connPtr->isReadDone	= 1;
+      return;
+    }
+
+    connPtr->inLen	+= numRead;
+
+    uint64_t	nowNs	= getNowNs();
+
+    //  Hand every whole request to the workers:
+    const char*	cPtr	= connPtr->inBuffer;
+    const char*	endPtr	= connPtr->inBuffer + connPtr->inLen;
+
+    int		wasIdle	= (connPtr->outQueue.headPtr == NULL);
+
+    while  ( !connPtr->isReadDone				&&
+	     (endPtr - cPtr >= (ptrdiff_t)sizeof(uint32_t))	&&
+	     (endPtr - cPtr >= (ptrdiff_t)getRequestLen(cPtr))
+	   )
+    {
+      struct Job*	jobPtr	= (struct Job*)calloc(1,sizeof(struct Job));
+
+      //  Without memory, only this connection is given up, once the
+      //  workers hand back its jobs:
+      if  (jobPtr == NULL)
+      {
+	fprintf(stderr,"Out of memory reading a request.\n");
+	connPtr->isBroken	= 1;
+	return;
+      }
+
+      jobPtr->connPtr	= connPtr;
+      jobPtr->readNs	= nowNs;
+      jobPtr->doneNs	= nowNs;
+      decodeRequest(&jobPtr->request,cPtr);
+      cPtr		+= getRequestLen(cPtr);
+      connPtr->numJobs++;
+
+      //  A version 1 client sends just one request:
+      if  (jobPtr->request.version == PROTOCOL_V1)
+	connPtr->isReadDone	= 1;
+
+      //  A cached reply, or the counters, need no worker:
+      if  ( isHistogramRequest(&jobPtr->request)		&&
+	    lookupCache(&jobPtr->request,&jobPtr->reply)
+	  )
+      {
+	enqueue(&connPtr->outQueue,jobPtr);
+	continue;
+      }
+
+      if  (jobPtr->request.opcode == OPCODE_STATS)
+      {
+	beginReply(&jobPtr->reply,&jobPtr->request);
+	reportStats(addStatsEntry,&jobPtr->reply);
+	endReply(&jobPtr->reply,STATUS_OK);
+	enqueue(&connPtr->outQueue,jobPtr);
+	continue;
+      }
+
+      //  Past 'queueDepth' waiting requests, the client is better told to
+      //  retry at once than left to wait longer and longer:
+      int	isQueued	= 0;
+
+      pthread_mutex_lock(&jobLock);
+
+      if  ( (queueDepth == 0)  ||  (numQueued < queueDepth) )
+      {
+	enqueue(&jobQueue,jobPtr);
+	numQueued++;
+	isQueued	= 1;
+	pthread_cond_signal(&jobCond);
+      }
+
+      pthread_mutex_unlock(&jobLock);
+
+      if  (!isQueued)
+      {
+	beginReply(&jobPtr->reply,&jobPtr->request);
+	endReply(&jobPtr->reply,STATUS_BUSY);
+	enqueue(&connPtr->outQueue,jobPtr);
+	numBusyReplies++;
+      }
+    }
+
+    connPtr->inLen	= endPtr - cPtr;
+    memmove(connPtr->inBuffer,cPtr,connPtr->inLen);
+
+    //  If replies were already waiting, the socket is full:
+    if  (wasIdle  &&  (connPtr->outQueue.headPtr != NULL))
+      sendReplies(connPtr);
+  }
+}
+
+
+//  PURPOSE:  To hand the replies the workers finished to their connections,
+//	and to start sending them.  No return value.
+void		sendDoneReplies	()
+{
+  uint64_t		numDone;
+  struct JobQueue	queue;
+  struct Job*		jobPtr;
+
+  read(wakeFd,&numDone,sizeof(numDone));
+
+  pthread_mutex_lock(&doneLock);
+  queue			= doneQueue;
+  doneQueue.headPtr	= NULL;
+  doneQueue.tailPtr	= NULL;
+  pthread_mutex_unlock(&doneLock);
+
+  while  ( (jobPtr = dequeue(&queue)) != NULL )
+  {
+    struct Connection*	connPtr	= jobPtr->connPtr;
+
+    //  The connection stays open while its request is under way, so a delta
+    //  job is counted only once it is back:
+    if  (jobPtr->isDelta)
+      connPtr->numJobs++;
+
+    if  (connPtr->isBroken)
+    {
+      freeJob(jobPtr);
+      connPtr->numJobs--;
+    }
+    else
+    {
+      int	wasIdle	= (connPtr->outQueue.headPtr == NULL);
+
+      enqueue(&connPtr->outQueue,jobPtr);
+
+      //  If replies were already waiting, the socket is full:
+      if  (wasIdle)
+	sendReplies(connPtr);
+    }
+
+    closeIfFinished(connPtr);
+  }
+}
+
+
+//  PURPOSE:  To 'accept()' every pending client on 'listenFd', and start
+//	reading their requests.  A client there is no memory for is closed at
+//	once.  Stops watching 'listenFd' if this process runs out of file
+//	descriptors, and returns '1' in that case, or '0' otherwise.
+int		acceptClients	(int		listenFd
+				)
+{
+  static int	clientCount	= 0;
+
+  while  (1)
+  {
+    int	fd	= accept4(listenFd,NULL,NULL,SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if  (fd < 0)
+    {
+      if  (errno == EINTR)
+	continue;
+
+      if  ( (errno == EMFILE)  ||  (errno == ENFILE) )
+      {
+	epoll_ctl(epollFd,EPOLL_CTL_DEL,listenFd,NULL);
+	return(1);
+      }
+
+      return(0);
+    }
+
+    struct Connection*	connPtr	= (struct Connection*)calloc(1,sizeof(struct Connection));
+
+    //  Without memory, this client is turned away but the others are not:
+    if  (connPtr == NULL)
+    {
+      fprintf(stderr,"Out of memory accepting a client.\n");
+      close(fd);
+      continue;
+    }
+
+    connPtr->fd		= fd;
+    connPtr->clientNum	= clientCount++;
+    connPtr->acceptNs	= getNowNs();
+    updateWatch(connPtr);
+  }
+}
+
+
+//  PURPOSE:  To 'accept()' every pending client on the local socket
+//	'statsFd', to send it the counters of the server in text, one "name
+//	value" line each, and to close it.  No return value.
+void		sendStatsText	(int		statsFd
+				)
+{
+  int	fd;
+
+  while  ( (fd = accept4(statsFd,NULL,NULL,SOCK_CLOEXEC)) >= 0 )
+  {
+    struct StatsText	text;
+
+    text.len	= 0;
+    reportStats(addStatsLine,&text);
+
+    //  The text fits the socket's buffer, so this does not wait long:
+    send(fd,text.buffer,text.len,MSG_NOSIGNAL);
+    close(fd);
+  }
+}
+
+
+//  PURPOSE:  To attempt to make and return a non-blocking local socket
+//	listening at 'statsSocketPath', replacing any file there.  Returns
+//	that file-descriptor, or 'ERROR_FD' on failure.
+int		getStatsFileDescriptor
+				()
+{
+  struct sockaddr_un	socketInfo;
+  int			fd	= socket(AF_UNIX,SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,0);
+
+  if  (fd < 0)
+  {
+    perror("socket()");
+    return(ERROR_FD);
+  }
+
+  memset(&socketInfo,'\0',sizeof(socketInfo));
+  socketInfo.sun_family	= AF_UNIX;
+  strncpy(socketInfo.sun_path,statsSocketPath,sizeof(socketInfo.sun_path) - 1);
+  unlink(statsSocketPath);
+
+  if  ( (bind(fd,(struct sockaddr*)&socketInfo,sizeof(socketInfo)) < 0)  ||
+	(listen(fd,SOMAXCONN) < 0)
+      )
+  {
+    perror(statsSocketPath);
+    close(fd);
+    return(ERROR_FD);
+  }
+
+  return(fd);
+}
+
+
 //  PURPOSE:  To run the server by 'accept()'-ing client requests from
-//	'listenFd' and doing them.
+//	'listenFd' and doing them.  One thread runs an epoll event loop over
+//	non-blocking sockets, which reads requests and sends replies, and
+//	'numWorkers' threads histogram the requests.  With '--stats-socket',
+//	the event loop also gives the counters in text on a local socket.
 void		doServer	(int		listenFd
 				)
 {
   //  I.  Application validity check:
 
-	int ret;
-	
-	//  II.  Server clients:
-	pthread_t		threadId;
-	pthread_attr_t	threadAttr;
-	int threadCount	= 0;
-	
-	ret = pthread_attr_init(&threadAttr);
-	
-	if (ret < 0) {
-		printf("pthread_attr_init failed\n");
-		return;
-	}
-	
-	ret = pthread_attr_setdetachstate(&threadAttr, PTHREAD_CREATE_DETACHED);
-	
-	if (ret < 0) {
-		printf("pthread_attr_setdetachstate failed\n");
-		return;
-		
-	}
-
-	while  (1)
-	{
-		int sockfd, len;
-		struct sockaddr_in clientAddr;
-		
-		len = sizeof(clientAddr);
-		/// put the file descriptor from accept() in one of those elements
-		sockfd = accept(listenFd, (struct sockaddr *) &clientAddr, &len);
-		
-		if (sockfd < 0) {
-			printf("accept failed\n");
-			return;
-		}
-		else {
-			printf("New client connected\n");
-		}
-		//allocate enough memory for an array of 2 integers
-
-		int* clientFdPtr = (int *) malloc(2 * sizeof(int));
-		clientFdPtr[0] = sockfd;
-		clientFdPtr[1] = threadCount++;
-    ///put the value of threadCount in the other element and increment threadCount.
-
-		///Make a detached thread to handle this new client and have it run handleClient(). Pass the address of your array.
-
-		pthread_create(&threadId, &threadAttr, handleClient, (void *) clientFdPtr);
-	}
-	
-	
-	pthread_attr_destroy(&threadAttr);
-	
+  //  II.  Server clients:
+  //  II.A.  Make event loop and workers:
+  struct epoll_event	listenEvent;
+  struct epoll_event	wakeEvent;
+  struct epoll_event	statsEvent;
+  int			statsFd		= ERROR_FD;
+  int			isAcceptPaused	= 0;
+
+  epollFd	= epoll_create1(EPOLL_CLOEXEC);
+  wakeFd	= eventfd(0,EFD_NONBLOCK | EFD_CLOEXEC);
+
+  if  ( (epollFd < 0)  ||  (wakeFd < 0) )
+  {
+    perror("epoll_create1()/eventfd()");
+    return;
+  }
+
+  fcntl(listenFd,F_SETFL,fcntl(listenFd,F_GETFL) | O_NONBLOCK);
+
+  //  The event loop tells 'listenFd' and 'wakeFd' from connections by
+  //  their 'data.ptr':
+  listenEvent.events	= EPOLLIN;
+  listenEvent.data.ptr	= &listenEvent;
+  wakeEvent.events	= EPOLLIN;
+  wakeEvent.data.ptr	= &wakeEvent;
+  epoll_ctl(epollFd,EPOLL_CTL_ADD,listenFd,&listenEvent);
+  epoll_ctl(epollFd,EPOLL_CTL_ADD,wakeFd,&wakeEvent);
+
+  if  ( (statsSocketPath != NULL)  &&
+	((statsFd = getStatsFileDescriptor()) != ERROR_FD)
+      )
+  {
+    statsEvent.events	= EPOLLIN;
+    statsEvent.data.ptr	= &statsEvent;
+    epoll_ctl(epollFd,EPOLL_CTL_ADD,statsFd,&statsEvent);
+  }
+
+  if  (numWorkers < 1)
+    numWorkers	= sysconf(_SC_NPROCESSORS_ONLN);
+
+  //  The event loop notes its metrics in slot 0, and each worker in its own:
+  initMetrics(numWorkers + 1);
+  setThreadMetrics(0);
+
+  for  (int i = 0;  i < numWorkers;  i++)
+  {
+    pthread_t	threadId;
+
+    pthread_create(&threadId,NULL,histogramWorker,(void*)(intptr_t)(i + 1));
+    pthread_detach(threadId);
+  }
+
+  //  II.B.  Run event loop:
+  struct epoll_event	eventArray[EPOLL_MAX_EVENTS];
+
+  while  (1)
+  {
+    int	numEvents	= epoll_wait(epollFd,eventArray,EPOLL_MAX_EVENTS,-1);
+
+    if  (numEvents < 0)
+    {
+      if  (errno == EINTR)
+	continue;
+
+      perror("epoll_wait()");
+      break;
+    }
+
+    int	isWoken		= 0;
+
+    for  (int i = 0;  i < numEvents;  i++)
+    {
+      void*	ptr	= eventArray[i].data.ptr;
+
+      if  (ptr == &listenEvent)
+	isAcceptPaused	= acceptClients(listenFd);
+      else
+      if  (ptr == &wakeEvent)
+	isWoken		= 1;
+      else
+      if  (ptr == &statsEvent)
+	sendStatsText(statsFd);
+      else
+      {
+	struct Connection*	connPtr	= (struct Connection*)ptr;
+	uint32_t		events	= eventArray[i].events;
+
+	if  (events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+	  readRequests(connPtr);
+
+	if  ( (events & EPOLLOUT)  &&  !connPtr->isBroken )
+	  sendReplies(connPtr);
+
+	closeIfFinished(connPtr);
+      }
+    }
+
+    //  Done last, since it may close connections that have events above:
+    if  (isWoken)
+      sendDoneReplies();
+
+    //  Closing connections may have freed file descriptors:
+    if  (isAcceptPaused)
+    {
+      isAcceptPaused	= 0;
+      epoll_ctl(epollFd,EPOLL_CTL_ADD,listenFd,&listenEvent);
+    }
+  }
+
   //  III.  Finished:
+  if  (statsFd != ERROR_FD)
+  {
+    close(statsFd);
+    unlink(statsSocketPath);
+  }
+
+  close(wakeFd);
+  close(epollFd);
 }
 
 
-//  PURPOSE:  To decide a port number, either from the command line arguments
-//	'argc' and 'argv[]', or by asking the user.  Returns port number.
-int		getPortNum	(int	argc,
+//  PURPOSE:  To set the global vars that options in the 'argc' command line
+//	arguments given in 'argv[]' select.  Prints usage and 'exit()'s with
+//	'EXIT_FAILURE' on error.  Returns the index in 'argv[]' of the first
+//	argument that is not an option.
+int		getOptions	(int	argc,
 				 char*	argv[]
 				)
+{
+  static struct option	optionArray[]	=
+  {
+    {"fork",	no_argument,		NULL,	'f'},
+    {"workers",	required_argument,	NULL,	'w'},
+    {"backlog",	required_argument,	NULL,	'b'},
+    {"cache",	required_argument,	NULL,	'c'},
+    {"queue",	required_argument,	NULL,	'q'},
+    {"stats-socket",required_argument,	NULL,	's'},
+    {"corpus",	required_argument,	NULL,	'p'},
+    {"verbose",	no_argument,		NULL,	'v'},
+    {NULL,	0,			NULL,	0}
+  };
+  int			option;
+
+  while  ( (option = getopt_long(argc,argv,"",optionArray,NULL)) != -1 )
+  {
+    switch  (option)
+    {
+    case 'f' :
+      shouldFork	= 1;
+      break;
+
+    case 'w' :
+      numWorkers	= strtol(optarg,NULL,0);
+      break;
+
+    case 'b' :
+      listenBacklog	= strtol(optarg,NULL,0);
+      break;
+
+    case 'c' :
+      cacheBytes	= (size_t)strtol(optarg,NULL,0) << 20;
+      break;
+
+    case 'q' :
+      queueDepth	= strtol(optarg,NULL,0);
+      break;
+
+    case 's' :
+      statsSocketPath	= optarg;
+      break;
+
+    case 'p' :
+      corpusPathCPtr	= optarg;
+      break;
+
+    case 'v' :
+      isVerbose		= 1;
+      break;
+
+    default :
+      fprintf(stderr,
+	      "Usage:\twordHistogramServer [--fork] [--workers=N]"
+	      " [--backlog=N] [--cache=megabytes] [--queue=N]"
+	      " [--stats-socket=path] [--corpus=path] [--verbose] [port]\n"
+	      "(the corpus is a file, a directory or @listFile, "
+	      FILENAME " by default)\n"
+	     );
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  return(optind);
+}
+
+
+//  PURPOSE:  To decide a port number, either from the command line argument
+//	'argv[argIndex]' if 'argIndex' is less than 'argc', or by asking the
+//	user.  Returns port number.
+int		getPortNum	(int	argc,
+				 char*	argv[],
+				 int	argIndex
+				)
 {
   //  I.  Application validity check:
 
   //  II.  Get listening socket:
   int	portNum;
 
-  if  (argc >= 2)
-    portNum	= strtol(argv[1],NULL,0);
+  if  (argIndex < argc)
+    portNum	= strtol(argv[argIndex],NULL,0);
   else
   {
     char	buffer[BUFFER_LEN];
@@ -195,7 +1342,7 @@ int		getServerFileDescriptor
   //  II.  Attempt to get socket file descriptor and bind it to 'port':
   //  II.A.  Create a socket
   int socketDescriptor = socket(AF_INET, // AF_INET domain
-			        SOCK_STREAM, // Reliable TCP
+			        SOCK_STREAM | SOCK_CLOEXEC, // Reliable TCP, not inherited by histogrammers
 			        0);
 
   if  (socketDescriptor < 0)
@@ -233,7 +1380,7 @@ int		getServerFileDescriptor
   }
 
   //  II.B.6.  Set OS queue length:
-  listen(socketDescriptor,5);
+  listen(socketDescriptor,listenBacklog);
 
   //  III.  Finished:
   return(socketDescriptor);
@@ -247,10 +1394,36 @@ int		main		(int	argc,
   //  I.  Application validity check:
 
   //  II.  Do server:
-  int 	      port	= getPortNum(argc,argv);
+  struct rlimit	fdLimit;
+
+  //  Allow as many connections as the OS lets this process have, and do
+  //  not die when a client hangs up before its reply is sent:
+  if  (getrlimit(RLIMIT_NOFILE,&fdLimit) == 0)
+  {
+    fdLimit.rlim_cur	= fdLimit.rlim_max;
+    setrlimit(RLIMIT_NOFILE,&fdLimit);
+  }
+
+  signal(SIGPIPE,SIG_IGN);
+
+  int	      argIndex	= getOptions(argc,argv);
+  int 	      port	= getPortNum(argc,argv,argIndex);
   int	      listenFd	= getServerFileDescriptor(port);
   int	      status	= EXIT_FAILURE;
 
+  pthread_t   watcherId;
+
+  if  (!shouldFork  &&  !loadCorpus(corpusPathCPtr))
+  {
+    fprintf(stderr,"Could not load %s.\n",corpusPathCPtr);
+    exit(EXIT_FAILURE);
+  }
+
+  initCache(cacheBytes);
+  noteCorpusVersion();
+  pthread_create(&watcherId,NULL,watchCorpus,NULL);
+  pthread_detach(watcherId);
+
   if  (listenFd >= 0)
   {
     doServer(listenFd);